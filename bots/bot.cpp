@@ -18,6 +18,9 @@
 #include "bots\bot_defs.h"
 #include "bots\squad_manager.h"
 #include "bots\bot_manager.h"
+#include "bots\bot_profiler.h"
+#include "bots\bot_timeline.h"
+#include "bots\bot_benchmark.h"
 
 #include "nav.h"
 #include "nav_mesh.h"
@@ -64,15 +67,16 @@ DECLARE_DEBUG_COMMAND( bot_debug_desires, "0", "" )
 DECLARE_DEBUG_COMMAND( bot_debug_max_msgs, "10", "" )
 
 DECLARE_DEBUG_COMMAND( bot_optimize, "0", "" );
+DECLARE_DEBUG_COMMAND( bot_debug_allocations, "0", "Warns when the heap grows or a known allocation is made while a bot processes its A.I. (Measuring the heap is slow)" )
 DECLARE_REPLICATED_COMMAND( bot_far_distance, "2500", "" )
+DECLARE_REPLICATED_COMMAND( bot_aim_lod_scale, "1", "Multiplies the distance until which the bots aim to the bones of their target (0 = Always the bones)." )
+
+int g_iBotAllocations = 0;
 
 //================================================================================
 // Macros
 //================================================================================
 
-// Only a utility macro to check if the current state is finished
-#define STATE_FINISHED m_iStateTimer.HasStarted() && m_iStateTimer.IsElapsed()
-
 //================================================================================
 // It allows to create a bot with the name and position specified.
 //================================================================================
@@ -146,6 +150,9 @@ void CBot::Spawn()
     m_iTacticalMode = TACTICAL_MODE_NONE;
     m_iStateTimer.Invalidate();
 
+    TheBots->GetTimers()->Remove( m_hStateTimer );
+    m_hStateTimer = BOT_TIMER_INVALID;
+
     m_nActiveSchedule = NULL;
     m_nConditions.ClearAll();
 
@@ -155,6 +162,15 @@ void CBot::Spawn()
     if ( GetMemory() ) {
         GetMemory()->UpdateDataMemory( MEMORY_SPAWN_POSITION, GetAbsOrigin() );
     }
+
+    // The look distance of the senses is our upper limit for the level of detail
+    if ( m_flDefaultLookDistance < 0.0f && GetSenses() ) {
+        m_flDefaultLookDistance = GetSenses()->GetDistLook();
+    }
+
+    BotLevelOfDetail lod = m_iLevelOfDetail;
+    m_iLevelOfDetail = BOT_LOD_HIGH;
+    SetLevelOfDetail( lod );
 }
 
 //================================================================================
@@ -164,9 +180,9 @@ void CBot::Update()
 {
     VPROF_BUDGET( "Update", VPROF_BUDGETGROUP_BOTS );
 
-    if ( STATE_FINISHED ) {
-        CleanState();
-    }
+    // The traces and events from now on are ours
+    CBotProfilerScope profilerScope( GetHost()->entindex() );
+    BOT_TIMELINE_SCOPE( "CBot::Update", "Bot" );
 
     // TODO: FIXME
     if ( bot_mimic.GetInt() > 0 ) {
@@ -174,16 +190,39 @@ void CBot::Update()
         return;
     }
 
-    m_cmd = new CUserCmd();
+    CFastTimer timer;
+    timer.Start();
+
+    m_cmd = AllocUserCommand();
     m_cmd->viewangles = GetHost()->EyeAngles();
 
     Upkeep();
 
-    if ( CanRunAI() ) RunAI();
+    if ( TheBots->IsThinkGranted( this ) && CanRunAI() )
+        RunAI();
+    else
+        RepeatLastCmd();
+
+    timer.End();
+    TheBotBenchmark->AddTime( timer.GetDuration().GetMillisecondsF() );
 
     PlayerMove( m_cmd );
 }
 
+//================================================================================
+// Returns an empty command for this frame
+// We use the buffer that is not being used by the last command.
+//================================================================================
+CUserCmd *CBot::AllocUserCommand()
+{
+    CUserCmd *cmd = &m_CmdBuffer[m_iCmdBuffer];
+    m_iCmdBuffer = (m_iCmdBuffer + 1) % ARRAYSIZE( m_CmdBuffer );
+
+    Assert( cmd != m_lastCmd );
+    cmd->Reset();
+    return cmd;
+}
+
 //================================================================================
 // Simulates all input as if it were a player
 //================================================================================
@@ -209,6 +248,7 @@ void CBot::PlayerMove( CUserCmd *cmd )
 
 //================================================================================
 // Returns if we can process Artificial Intelligence
+// The bot manager decides in which frame we will do it (see CBotManager::UpdateThinkQueue)
 //================================================================================
 bool CBot::CanRunAI()
 {
@@ -229,7 +269,7 @@ bool CBot::CanRunAI()
     if ( !GetDecision() )
         return false;
 
-    if ( GetLocomotion() && TheNavMesh->GetNavAreaCount() == 0 )
+    if ( GetLocomotion() && !TheBotWorld->IsNavMeshLoaded() )
         return false;
 
     if ( GetFollow() && GetFollow()->IsFollowingBot() ) {
@@ -243,19 +283,15 @@ bool CBot::CanRunAI()
 #ifdef INSOURCE_DLL
     if ( !GetHost()->IsActive() )
         return false;
+#endif
 
+    // The bot manager combines the PVS of all humans once per frame
     if ( GetPerformance() == BOT_PERFORMANCE_PVS ) {
-        CHumanPVSFilter filter( GetAbsOrigin() );
-
-        if ( filter.GetRecipientCount() == 0 )
+        if ( !TheBots->IsVisibleToHumans( GetAbsOrigin() ) )
             return false;
     }
-#endif
-
-    if ( ((gpGlobals->tickcount + GetHost()->entindex()) % 2) == 0 )
-        return true;
 
-    return false;
+    return true;
 }
 
 //================================================================================
@@ -265,13 +301,92 @@ void CBot::Upkeep()
 {
 }
 
+//================================================================================
+// In the frames we do not process the A.I. we continue with the movement 
+// and buttons of our last command, this way the bots with a low level of detail 
+// can keep moving and fighting without stopping between each think.
+//================================================================================
+void CBot::RepeatLastCmd()
+{
+    if ( !m_lastCmd )
+        return;
+
+    if ( bot_frozen.GetBool() || !GetHost()->IsAlive() )
+        return;
+
+    // We have stopped thinking (PVS or bot_frozen), we stay quiet.
+    if ( TheBots->GetThinkStaleness( this ) > TIME_TO_TICKS( 1.0f ) )
+        return;
+
+    m_cmd->forwardmove = m_lastCmd->forwardmove;
+    m_cmd->sidemove = m_lastCmd->sidemove;
+    m_cmd->upmove = m_lastCmd->upmove;
+
+    // Buttons that are pressed only once are not repeated
+    m_cmd->buttons |= (m_lastCmd->buttons & ~(IN_JUMP | IN_USE | IN_RELOAD));
+}
+
+//================================================================================
+// Applies the limits of a level of detail
+//================================================================================
+void CBot::SetLevelOfDetail( BotLevelOfDetail value )
+{
+    Assert( value >= BOT_LOD_HIGH && value < LAST_BOT_LOD );
+
+    if ( value == m_iLevelOfDetail )
+        return;
+
+    m_iLevelOfDetail = value;
+
+    if ( !GetSenses() || m_flDefaultLookDistance < 0.0f )
+        return;
+
+    float radius = GetLevelOfDetailInfo().perceptionRadius;
+
+    if ( radius < 0.0f )
+        GetSenses()->SetDistLook( m_flDefaultLookDistance );
+    else
+        GetSenses()->SetDistLook( MIN( m_flDefaultLookDistance, radius ) );
+}
+
+//================================================================================
+// Returns whether we should aim to the bones of a target at [distance].
+// The bone setup is heavy for the engine and at long range the positions
+// calculated from the bounds of the target are good enough.
+//================================================================================
+bool CBot::ShouldAimWithBones( float distance ) const
+{
+    if ( !GetLevelOfDetailInfo().hitboxAiming )
+        return false;
+
+    float scale = bot_aim_lod_scale.GetFloat();
+    float cutoff = GetProfile()->GetHitboxBonesDistance();
+
+    if ( scale <= 0.0f || cutoff <= 0.0f )
+        return true;
+
+    return (distance <= cutoff * scale);
+}
+
 //================================================================================
 // All the processing that can be heavy for the engine.
 //================================================================================
 void CBot::RunAI()
 {
+    BOT_TIMELINE_SCOPE( "RunAI", "Bot" );
+
+    int allocations = g_iBotAllocations;
+
+    // Any allocation, including the growth of the containers,
+    // reading the size of the heap can be slow.
+    size_t heap = (bot_debug_allocations.GetBool()) ? g_pMemAlloc->GetSize( NULL ) : 0;
+
     m_RunTimer.Start();
 
+    // New tick, the answers of the previous one are not valid
+    if ( GetDecision() )
+        GetDecision()->InvalidateMemo();
+
     BlockConditions();
 
     ApplyDebugCommands();
@@ -282,12 +397,32 @@ void CBot::RunAI()
 
     UnblockConditions();
 
+    // The predicates answered while gathering could not read the conditions
+    if ( GetDecision() )
+        GetDecision()->InvalidateMemo();
+
     UpdateComponents( false );
 
     UpdateSchedule();
 
     m_RunTimer.End();
 
+    TheBots->OnBotThink( this, m_RunTimer.GetDuration().GetMillisecondsF() );
+
+    TheBotProfiler->AddSample( GetHost()->entindex(), BOT_PROFILE_RUNAI, 0, m_RunTimer.GetDuration().GetMillisecondsF() );
+
+    m_iAllocations = g_iBotAllocations - allocations;
+    m_iHeapGrowth = 0;
+
+    if ( bot_debug_allocations.GetBool() ) {
+        m_iHeapGrowth = (int)((int64)g_pMemAlloc->GetSize( NULL ) - (int64)heap);
+
+        if ( m_iAllocations > 0 || m_iHeapGrowth > 0 ) {
+            DevWarning( "%s has made %i known allocations and the heap has grown %i bytes in RunAI()\n", GetName(), m_iAllocations, m_iHeapGrowth );
+            AssertMsg( m_iAllocations == 0 && m_iHeapGrowth <= 0, "The bot has allocated memory in the steady state" );
+        }
+    }
+
     DebugDisplay();
 }
 
@@ -304,10 +439,14 @@ void CBot::UpdateComponents( bool important )
         else if ( !important && m_nComponents[it]->ItsImportant() )
             continue;
         
+        BOT_TIMELINE_SCOPE( TheBotProfiler->GetHistogramName( BOT_PROFILE_COMPONENT, m_nComponents[it]->GetID() ), "Component" );
+
         timer.Start();
         m_nComponents[it]->Update();
         timer.End();
         m_nComponents[it]->SetUpdateCost( timer.GetDuration().GetMillisecondsF() );
+
+        TheBotProfiler->AddSample( GetHost()->entindex(), BOT_PROFILE_COMPONENT, m_nComponents[it]->GetID(), m_nComponents[it]->GetUpdateCost() );
     }
 }
 
@@ -383,7 +522,7 @@ void CBot::MimicThink( int playerIndex )
     DebugDisplay();
 
     const CUserCmd *playercmd = pPlayer->GetLastUserCommand();
-    m_cmd = new CUserCmd();
+    m_cmd = AllocUserCommand();
 
     m_cmd->command_number = playercmd->command_number;
     m_cmd->tick_count = playercmd->tick_count;
@@ -545,8 +684,8 @@ CON_COMMAND_F( bot_add, "Adds a specified number of generic bots", FCVAR_SERVER
 
 CON_COMMAND_F( bot_kick, "Kick all bots on the server", FCVAR_SERVER )
 {
-    for ( int it = 0; it <= gpGlobals->maxClients; ++it ) {
-        CPlayer *pPlayer = ToInPlayer( UTIL_PlayerByIndex(it) );
+    for ( int it = 0; it <= TheBotWorld->GetMaxPlayers(); ++it ) {
+        CPlayer *pPlayer = TheBotWorld->GetPlayer( it );
 
         if ( !pPlayer || !pPlayer->IsAlive() )
             continue;
@@ -565,8 +704,8 @@ CON_COMMAND_F( bot_debug_follow, "It causes all Bots to start following the host
     if ( !pOwner )
         return;
 
-    for ( int it = 0; it <= gpGlobals->maxClients; ++it ) {
-        CPlayer *pPlayer = ToInPlayer( UTIL_PlayerByIndex(it) );
+    for ( int it = 0; it <= TheBotWorld->GetMaxPlayers(); ++it ) {
+        CPlayer *pPlayer = TheBotWorld->GetPlayer( it );
 
         if ( !pPlayer || !pPlayer->IsAlive() )
             continue;
@@ -584,8 +723,8 @@ CON_COMMAND_F( bot_debug_follow, "It causes all Bots to start following the host
 
 CON_COMMAND_F( bot_debug_stop_follow, "Causes all Bots to stop following", FCVAR_SERVER )
 {
-    for ( int it = 0; it <= gpGlobals->maxClients; ++it ) {
-        CPlayer *pPlayer = ToInPlayer( UTIL_PlayerByIndex( it ) );
+    for ( int it = 0; it <= TheBotWorld->GetMaxPlayers(); ++it ) {
+        CPlayer *pPlayer = TheBotWorld->GetPlayer( it );
 
         if ( !pPlayer || !pPlayer->IsAlive() )
             continue;
@@ -606,8 +745,8 @@ CON_COMMAND_F( bot_debug_drive_random, "Orders all bots to move at random sites"
     if ( TheNavAreas.Count() == 0 )
         return;
 
-    for ( int it = 0; it <= gpGlobals->maxClients; ++it ) {
-        CPlayer *pPlayer = ToInPlayer( UTIL_PlayerByIndex( it ) );
+    for ( int it = 0; it <= TheBotWorld->GetMaxPlayers(); ++it ) {
+        CPlayer *pPlayer = TheBotWorld->GetPlayer( it );
 
         if ( !pPlayer || !pPlayer->IsAlive() )
             continue;
@@ -652,8 +791,8 @@ CON_COMMAND_F( bot_debug_drive_player, "Command all bots to move to host locatio
     if ( !pArea )
         return;
 
-    for ( int it = 0; it <= gpGlobals->maxClients; ++it ) {
-        CPlayer *pPlayer = ToInPlayer( UTIL_PlayerByIndex( it ) );
+    for ( int it = 0; it <= TheBotWorld->GetMaxPlayers(); ++it ) {
+        CPlayer *pPlayer = TheBotWorld->GetPlayer( it );
 
         if ( !pPlayer || !pPlayer->IsAlive() )
             continue;
@@ -43,6 +43,12 @@ public:
     virtual bool CanRunAI();
     virtual void Upkeep();
     virtual void RunAI();
+    virtual void RepeatLastCmd();
+
+    virtual CUserCmd *AllocUserCommand();
+
+    virtual void SetLevelOfDetail( BotLevelOfDetail value );
+    virtual bool ShouldAimWithBones( float distance ) const;
 
     virtual void UpdateComponents( bool important = false );
 
@@ -68,6 +74,8 @@ public:
     virtual void SetState( BotState state, float duration = 3.0f );
     virtual void CleanState();
 
+    virtual void OnTimerExpired( BotTimerHandle handle, BotTimerType type, int param );
+
     virtual void Panic( float duration = -1.0f );
     virtual void Alert( float duration = -1.0f );
     virtual void Idle();
@@ -76,6 +84,7 @@ public:
     virtual void SetCondition( BCOND condition );
     virtual void ClearCondition( BCOND condition );
     virtual bool HasCondition( BCOND condition ) const;
+    virtual bool HasAnyCondition( const CFlagsBits &conditions ) const;
 
     virtual void AddComponent( IBotComponent *pComponent );
 
@@ -95,11 +104,12 @@ public:
     virtual int TranslateSchedule( int schedule ) { return schedule; }
     virtual void UpdateSchedule();
 
-	virtual bool TaskStart( BotTaskInfo_t *info ) { return false; }
-	virtual bool TaskRun( BotTaskInfo_t *info ) { return false; }
+	virtual bool TaskStart( const BotTaskInfo_t *info ) { return false; }
+	virtual bool TaskRun( const BotTaskInfo_t *info ) { return false; }
 	virtual void TaskComplete();
 	virtual void TaskFail( const char *pWhy );
 
+    virtual void PreparePerception();
     virtual void GatherConditions();
 
     virtual void GatherHealthConditions();
@@ -4,6 +4,9 @@
 
 #include "cbase.h"
 #include "bots\bot.h"
+#include "bots\bot_profiler.h"
+#include "bots\bot_timeline.h"
+#include "bots\bot_manager.h"
 
 #ifdef INSOURCE_DLL
 #include "in_gamerules.h"
@@ -16,6 +19,7 @@
 #include "tier0/memdbgon.h"
 
 extern ConVar bot_primary_attack;
+extern ConVar bot_hitbox_early_exit;
 
 //================================================================================
 // Sets a condition
@@ -46,6 +50,25 @@ bool CBot::HasCondition( BCOND condition ) const
     return m_nConditions.IsBitSet( condition );
 }
 
+//================================================================================
+// Returns if the bot is in any of the conditions of the mask
+// The mask is compared a word at a time.
+//================================================================================
+bool CBot::HasAnyCondition( const CFlagsBits &conditions ) const
+{
+    if ( IsConditionsAllowed() ) {
+        Assert( !"Attempt to verify a condition before gathering!" );
+        return false;
+    }
+
+    for ( int it = 0; it < m_nConditions.GetNumDWords(); ++it ) {
+        if ( (m_nConditions.GetDWord( it ) & conditions.GetDWord( it )) != 0 )
+            return true;
+    }
+
+    return false;
+}
+
 //================================================================================
 // Add a component to the list
 //================================================================================
@@ -158,7 +181,7 @@ int CBot::SelectIdealSchedule()
         // This schedule has a greater desire!
         if ( pSchedule->GetInternalDesire() > desire ) {
             pIdeal = pSchedule;
-            desire = pSchedule->GetDesire();
+            desire = pSchedule->GetCachedDesire();
         }
     }
 
@@ -175,6 +198,7 @@ int CBot::SelectIdealSchedule()
 void CBot::UpdateSchedule()
 {
     VPROF_BUDGET( "UpdateSchedule", VPROF_BUDGETGROUP_BOTS );
+    BOT_TIMELINE_SCOPE( "UpdateSchedule", "Bot" );
 
     // Maybe an custom A.I. want to change a schedule.
     int idealSchedule = TranslateSchedule( SelectIdealSchedule() );
@@ -199,6 +223,8 @@ void CBot::UpdateSchedule()
             m_ScheduleTimer.Start();
             GetActiveSchedule()->Update();
             m_ScheduleTimer.End();
+
+            TheBotProfiler->AddSample( GetHost()->entindex(), BOT_PROFILE_SCHEDULE, pSchedule->GetID(), m_ScheduleTimer.GetDuration().GetMillisecondsF() );
             return;
         }
         else {
@@ -211,6 +237,8 @@ void CBot::UpdateSchedule()
     m_nActiveSchedule->Start();
     m_nActiveSchedule->Update();
     m_ScheduleTimer.End();
+
+    TheBotProfiler->AddSample( GetHost()->entindex(), BOT_PROFILE_SCHEDULE, pSchedule->GetID(), m_ScheduleTimer.GetDuration().GetMillisecondsF() );
 }
 
 //================================================================================
@@ -238,6 +266,54 @@ void CBot::TaskFail( const char *pWhy )
 }
 
 
+//================================================================================
+// Prepares the traces that we will need in this frame.
+// The bot manager executes them (in parallel with the rest of bots) 
+// before we run our A.I., in GatherConditions we only read the results.
+//================================================================================
+void CBot::PreparePerception()
+{
+    VPROF_BUDGET( "PreparePerception", VPROF_BUDGETGROUP_BOTS );
+
+    GetPerception()->Clear();
+
+    CEntityMemory *memory = GetPrimaryThreat();
+
+    if ( memory == NULL || memory->GetEntity() == NULL )
+        return;
+
+    CBaseEntity *pThreat = memory->GetEntity();
+    Vector vecEyes = GetHost()->EyePosition();
+
+    // Hitboxes that we will check in CEntityMemory::UpdateHitboxAndVisibility
+    // With a low level of detail or a far threat we avoid the bone setup
+    HitboxPositions hitbox;
+    TheBots->GetEntityHitbox( pThreat, hitbox, ShouldAimWithBones( memory->GetDistance() ) );
+
+    if ( hitbox.IsValid() ) {
+        GetPerception()->SetHitbox( pThreat, hitbox );
+
+        // The first hitboxes that will be probed, the rest are only traced
+        // if these are occluded and the bot must find another one.
+        GetPerception()->AddQuery( PERCEPTION_VISIBILITY, GetHost(), vecEyes, hitbox.Get( GetProfile()->GetFavoriteHitbox() ), pThreat );
+
+        if ( memory->GetLastVisibleHitbox() != HITGROUP_GENERIC ) {
+            GetPerception()->AddQuery( PERCEPTION_VISIBILITY, GetHost(), vecEyes, hitbox.Get( memory->GetLastVisibleHitbox() ), pThreat );
+        }
+
+        if ( !bot_hitbox_early_exit.GetBool() ) {
+            GetPerception()->AddQuery( PERCEPTION_VISIBILITY, GetHost(), vecEyes, hitbox.head, pThreat );
+            GetPerception()->AddQuery( PERCEPTION_VISIBILITY, GetHost(), vecEyes, hitbox.chest, pThreat );
+            GetPerception()->AddQuery( PERCEPTION_VISIBILITY, GetHost(), vecEyes, hitbox.leftLeg, pThreat );
+            GetPerception()->AddQuery( PERCEPTION_VISIBILITY, GetHost(), vecEyes, hitbox.rightLeg, pThreat );
+        }
+    }
+
+    // GatherEnemyConditions
+    GetPerception()->AddQuery( PERCEPTION_VISIBILITY, GetHost(), vecEyes, memory->GetLastKnownPosition(), pThreat );
+    GetPerception()->AddQuery( PERCEPTION_LINE_OF_FIRE, GetHost(), vecEyes, memory->GetIdealPosition(), pThreat );
+}
+
 //================================================================================
 // Gets new conditions from environment and statistics
 // Conditions that do not require information about components (vision/smell/hearing)
@@ -245,6 +321,7 @@ void CBot::TaskFail( const char *pWhy )
 void CBot::GatherConditions()
 {
     VPROF_BUDGET( "GatherConditions", VPROF_BUDGETGROUP_BOTS );
+    BOT_TIMELINE_SCOPE( "GatherConditions", "Bot" );
 
     GatherHealthConditions();
     GatherWeaponConditions();
@@ -259,6 +336,7 @@ void CBot::GatherConditions()
 void CBot::GatherHealthConditions()
 {
     VPROF_BUDGET( "GatherHealthConditions", VPROF_BUDGETGROUP_BOTS );
+    BOT_TIMELINE_SCOPE( "GatherHealthConditions", "Bot" );
 
     if ( GetDecision()->IsLowHealth() ) {
         SetCondition( BCOND_LOW_HEALTH );
@@ -296,6 +374,7 @@ void CBot::GatherHealthConditions()
 void CBot::GatherWeaponConditions()
 {
     VPROF_BUDGET( "GatherWeaponConditions", VPROF_BUDGETGROUP_BOTS );
+    BOT_TIMELINE_SCOPE( "GatherWeaponConditions", "Bot" );
 
     // We change to the best weapon for this situation
     // TODO: A better place to put this.
@@ -368,6 +447,7 @@ void CBot::GatherWeaponConditions()
 void CBot::GatherEnemyConditions()
 {
     VPROF_BUDGET( "GatherEnemyConditions", VPROF_BUDGETGROUP_BOTS );
+    BOT_TIMELINE_SCOPE( "GatherEnemyConditions", "Bot" );
 
     CEntityMemory *memory = GetPrimaryThreat();
 
@@ -442,6 +522,7 @@ void CBot::GatherEnemyConditions()
 void CBot::GatherAttackConditions()
 {
     VPROF_BUDGET("SelectAttackConditions", VPROF_BUDGETGROUP_BOTS);
+    BOT_TIMELINE_SCOPE( "GatherAttackConditions", "Bot" );
 
     BCOND condition = GetDecision()->ShouldRangeAttack1();
 
@@ -468,6 +549,8 @@ void CBot::GatherAttackConditions()
 //================================================================================
 void CBot::GatherLocomotionConditions()
 {
+    BOT_TIMELINE_SCOPE( "GatherLocomotionConditions", "Bot" );
+
     if ( !GetLocomotion() )
         return;
 
@@ -543,10 +626,8 @@ void CBot::OnMemberTakeDamage( CPlayer *pMember, const CTakeDamageInfo & info )
         // TODO
     }
 
-    // Han atacado a un jugador normal, reportemos a sus amigos Bots
-    if ( !pMember->IsBot() && info.GetAttacker() ) {
-        OnMemberReportEnemy( pMember, info.GetAttacker() );
-    }
+    // The attacker of a human member is reported to the table
+    // of the squad once (see CSquad::ReportTakeDamage)
 }
 
 //================================================================================
@@ -571,18 +652,6 @@ void CBot::OnMemberDeath( CPlayer *pMember, const CTakeDamageInfo & info )
 //================================================================================
 void CBot::OnMemberReportEnemy( CPlayer *pMember, CBaseEntity *pEnemy ) 
 {
-    if ( !GetMemory() )
-        return;
-
-    // Posicin estimada del enemigo
-    Vector vecEstimatedPosition = pEnemy->WorldSpaceCenter();
-    const float errorDistance = 100.0f;
-
-    // Cuando un amigo nos reporta la posicin de un enemigo siempre debe haber un margen de error,
-    // un humano no puede saber la posicin exacta hasta verlo con sus propios ojos.
-    vecEstimatedPosition.x += RandomFloat( -errorDistance, errorDistance );
-    vecEstimatedPosition.y += RandomFloat( -errorDistance, errorDistance );
-
-    // Actualizamos nuestra memoria
-    GetMemory()->UpdateEntityMemory( pEnemy, vecEstimatedPosition, pMember );
+    // The memory reads the position from the table of the squad,
+    // it is not copied here (see CBotMemory::UpdateSquadMemory)
 }
@@ -0,0 +1,473 @@
+//========= Copyright  1996-2005, Valve Corporation, All rights reserved. ============//
+// Authors: 
+// Ivn Bravo Bravo (linkedin.com/in/ivanbravobravo), 2017
+
+#include "cbase.h"
+#include "bots\bot_benchmark.h"
+
+#include "bots\bot.h"
+#include "bots\bot_profiler.h"
+#include "bots\bot_world.h"
+
+#ifdef INSOURCE_DLL
+#include "in_utils.h"
+#else
+#include "bots\in_utils.h"
+#endif
+
+#include "nav_area.h"
+
+// memdbgon must be the last include file in a .cpp file!!!
+#include "tier0/memdbgon.h"
+
+extern ConVar bot_trace_budget;
+extern ConVar bot_desire_cache_verify;
+
+CBotBenchmark g_BotBenchmark;
+CBotBenchmark *TheBotBenchmark = &g_BotBenchmark;
+
+//================================================================================
+//================================================================================
+static int SortTickTimes( const float *a, const float *b )
+{
+    if ( *a < *b )
+        return -1;
+
+    if ( *a > *b )
+        return 1;
+
+    return 0;
+}
+
+//================================================================================
+//================================================================================
+CBotBenchmark::CBotBenchmark()
+{
+    m_bRunning = false;
+    m_iScenario = BOT_BENCHMARK_IDLE;
+    m_iCount = 0;
+    m_iTicks = 0;
+    m_iSeed = 0;
+    m_pCenterArea = NULL;
+    m_pTeamAreas[0] = NULL;
+    m_pTeamAreas[1] = NULL;
+    m_flTickTime = -1.0f;
+    m_iStartAllocations = 0;
+    m_iStartHeap = 0;
+    m_iPreviousBudget = 0;
+}
+
+//================================================================================
+// Starts the benchmark, the bots are created right now
+//================================================================================
+bool CBotBenchmark::Start( BotBenchmarkScenario scenario, int count, int ticks, int seed )
+{
+    if ( IsRunning() )
+        Stop();
+
+    if ( TheNavAreas.Count() == 0 ) {
+        Warning( "The benchmark of the bots needs a navigation mesh.\n" );
+        return false;
+    }
+
+    // Only as many bots as free player slots
+    int freeSlots = 0;
+
+    for ( int it = 1; it <= TheBotWorld->GetMaxPlayers(); ++it ) {
+        if ( !TheBotWorld->GetPlayer( it ) )
+            ++freeSlots;
+    }
+
+    if ( freeSlots == 0 ) {
+        Warning( "There are no free player slots for the bots of the benchmark.\n" );
+        return false;
+    }
+
+    if ( count > freeSlots ) {
+        Warning( "There are only %i free player slots, the benchmark will use %i bots.\n", freeSlots, freeSlots );
+        count = freeSlots;
+    }
+
+    m_iScenario = scenario;
+    m_iCount = count;
+    m_iTicks = ticks;
+    m_iSeed = seed;
+
+    // The scenario has its own random stream, but the bots use the global
+    // uniform stream (RandomInt, RandomFloat) in their decisions, so it is
+    // also seeded to make the runs repeatable. It is reseeded on Stop.
+    m_Random.SetSeed( seed );
+    RandomSeed( seed );
+
+    m_pCenterArea = GetRandomArea();
+    m_pTeamAreas[0] = GetRandomArea();
+    m_pTeamAreas[1] = GetRandomArea();
+
+    if ( m_iScenario == BOT_BENCHMARK_COVER ) {
+        TheBotMockWorld->Generate( seed, count * 8, m_pCenterArea->GetCenter(), 1024.0f );
+
+        // The traces of the mock are solid now, the bots must not
+        // spawn or meet inside a box.
+        TheBotMockWorld->ClearBoxes( m_pCenterArea->GetCenter(), 128.0f );
+        TheBotMockWorld->ClearBoxes( m_pTeamAreas[0]->GetCenter(), 128.0f );
+        TheBotMockWorld->ClearBoxes( m_pTeamAreas[1]->GetCenter(), 128.0f );
+
+        Bot_SetWorld( TheBotMockWorld );
+    }
+
+    // Under load the bots must keep jumping and firing with the previous answers
+    if ( m_iScenario == BOT_BENCHMARK_BUDGET ) {
+        m_iPreviousBudget = bot_trace_budget.GetInt();
+        bot_trace_budget.SetValue( 1 );
+    }
+
+    SpawnBots();
+
+    m_TickTimes.Purge();
+    m_TickTraces.Purge();
+    m_TickTimes.EnsureCapacity( ticks );
+    m_TickTraces.EnsureCapacity( ticks );
+
+    TheBotProfiler->Reset();
+    m_iStartAllocations = g_iBotAllocations;
+    m_iStartHeap = g_pMemAlloc->GetSize( NULL );
+
+    // The creation of the bots is not measured, we start with the next tick
+    m_flTickTime = -1.0f;
+    m_bRunning = true;
+
+    Msg( "Bot benchmark: %s with %i bots for %i ticks (seed %i)\n", g_BotBenchmarkScenarios[m_iScenario], m_Bots.Count(), m_iTicks, m_iSeed );
+    return true;
+}
+
+//================================================================================
+// Finishes the benchmark, prints the report and removes the bots
+//================================================================================
+void CBotBenchmark::Stop()
+{
+    if ( !IsRunning() )
+        return;
+
+    m_bRunning = false;
+
+    CUtlBuffer buffer( 0, 0, CUtlBuffer::TEXT_BUFFER );
+    Report( buffer );
+
+    buffer.PutChar( 0 );
+    Msg( "%s", (const char *)buffer.Base() );
+
+    KickBots();
+
+    // The game gets back a random stream that is not repeatable
+    RandomSeed( (int)Plat_MSTime() );
+
+    if ( m_iScenario == BOT_BENCHMARK_COVER )
+        Bot_SetWorld( NULL );
+
+    if ( m_iScenario == BOT_BENCHMARK_BUDGET )
+        bot_trace_budget.SetValue( m_iPreviousBudget );
+}
+
+//================================================================================
+// Called at the end of each tick, after all the bots have been updated
+//================================================================================
+void CBotBenchmark::Update()
+{
+    if ( !IsRunning() )
+        return;
+
+    if ( m_flTickTime >= 0.0f ) {
+        m_TickTimes.AddToTail( m_flTickTime );
+        m_TickTraces.AddToTail( TheBotProfiler->GetFrameTraceCount() );
+    }
+
+    m_flTickTime = 0.0f;
+
+    if ( m_TickTimes.Count() >= m_iTicks ) {
+        Stop();
+        return;
+    }
+
+    UpdateScenario();
+}
+
+//================================================================================
+// Adds time spent by the A.I. in this tick
+//================================================================================
+void CBotBenchmark::AddTime( float ms )
+{
+    if ( !IsRunning() || m_flTickTime < 0.0f )
+        return;
+
+    m_flTickTime += ms;
+}
+
+//================================================================================
+//================================================================================
+void CBotBenchmark::SpawnBots()
+{
+    m_Bots.Purge();
+
+    for ( int it = 0; it < m_iCount; ++it ) {
+        int team = it % 2;
+        CNavArea *pArea = m_pCenterArea;
+
+        if ( IsFirefight() )
+            pArea = m_pTeamAreas[team];
+        else if ( m_iScenario == BOT_BENCHMARK_IDLE )
+            pArea = GetRandomArea();
+
+        Vector vecPosition = pArea->GetCenter() + Vector( 0, 0, 18.0f );
+        CPlayer *pPlayer = CreateBot( NULL, NULL, NULL );
+
+        if ( !pPlayer ) {
+            Warning( "Bot benchmark: Only %i of %i bots could be created.\n", m_Bots.Count(), m_iCount );
+            break;
+        }
+
+        if ( IsFirefight() ) {
+            pPlayer->ChangeTeam( FIRST_GAME_TEAM + team );
+            pPlayer->SetSquad( (team == 0) ? "benchmark_red" : "benchmark_blue" );
+        }
+
+        pPlayer->Teleport( &vecPosition, NULL, NULL );
+        m_Bots.AddToTail( pPlayer );
+    }
+}
+
+//================================================================================
+// Gives orders to the bots according to the scenario
+//================================================================================
+void CBotBenchmark::UpdateScenario()
+{
+    CBasePlayer *pLeader = NULL;
+
+    FOR_EACH_VEC( m_Bots, it )
+    {
+        CPlayer *pPlayer = ToInPlayer( m_Bots[it].Get() );
+
+        if ( !pPlayer || !pPlayer->IsAlive() )
+            continue;
+
+        IBot *pBot = pPlayer->GetBotController();
+
+        if ( !pBot || !pBot->GetLocomotion() )
+            continue;
+
+        switch ( m_iScenario ) {
+            case BOT_BENCHMARK_IDLE:
+            {
+                if ( !pBot->GetLocomotion()->HasDestination() )
+                    pBot->GetLocomotion()->DriveTo( "Benchmark Patrol", GetRandomArea() );
+
+                break;
+            }
+
+            case BOT_BENCHMARK_FIREFIGHT:
+            case BOT_BENCHMARK_COVER:
+            case BOT_BENCHMARK_BUDGET:
+            {
+                if ( !pBot->GetLocomotion()->HasDestination() && !pBot->GetEnemy() )
+                    pBot->GetLocomotion()->DriveTo( "Benchmark Firefight", m_pCenterArea );
+
+                break;
+            }
+
+            case BOT_BENCHMARK_FOLLOW:
+            {
+                // The first one leads the others
+                if ( !pLeader ) {
+                    pLeader = pPlayer;
+
+                    if ( !pBot->GetLocomotion()->HasDestination() )
+                        pBot->GetLocomotion()->DriveTo( "Benchmark Leader", GetRandomArea() );
+
+                    break;
+                }
+
+                if ( pBot->GetFollow() && pBot->GetFollow()->GetEntity() != pLeader )
+                    pBot->GetFollow()->Start( pLeader );
+
+                break;
+            }
+        }
+    }
+}
+
+//================================================================================
+//================================================================================
+void CBotBenchmark::KickBots()
+{
+    FOR_EACH_VEC( m_Bots, it )
+    {
+        CPlayer *pPlayer = ToInPlayer( m_Bots[it].Get() );
+
+        if ( !pPlayer || !pPlayer->GetBotController() )
+            continue;
+
+        pPlayer->GetBotController()->Kick();
+    }
+
+    m_Bots.Purge();
+}
+
+//================================================================================
+// Returns if the scenario has two squads fighting each other
+//================================================================================
+bool CBotBenchmark::IsFirefight() const
+{
+    return (m_iScenario == BOT_BENCHMARK_FIREFIGHT || m_iScenario == BOT_BENCHMARK_COVER || m_iScenario == BOT_BENCHMARK_BUDGET);
+}
+
+//================================================================================
+//================================================================================
+CNavArea *CBotBenchmark::GetRandomArea()
+{
+    return TheNavAreas[ m_Random.RandomInt( 0, TheNavAreas.Count() - 1 ) ];
+}
+
+//================================================================================
+//================================================================================
+float CBotBenchmark::GetPercentile( const CUtlVector<float> &sorted, float percentile ) const
+{
+    if ( sorted.Count() == 0 )
+        return 0.0f;
+
+    int index = clamp( (int)(percentile * sorted.Count()), 0, sorted.Count() - 1 );
+    return sorted[index];
+}
+
+//================================================================================
+//================================================================================
+void CBotBenchmark::Report( CUtlBuffer &buffer )
+{
+    CUtlVector<float> sorted;
+    sorted.CopyArray( m_TickTimes.Base(), m_TickTimes.Count() );
+    sorted.Sort( SortTickTimes );
+
+    int ticks = m_TickTimes.Count();
+    float total = 0.0f;
+    int traces = 0;
+
+    for ( int it = 0; it < ticks; ++it ) {
+        total += m_TickTimes[it];
+        traces += m_TickTraces[it];
+    }
+
+    float average = (ticks > 0) ? (total / ticks) : 0.0f;
+    int bots = MAX( m_Bots.Count(), 1 );
+
+    int allocations = g_iBotAllocations - m_iStartAllocations;
+    size_t heap = g_pMemAlloc->GetSize( NULL );
+
+    buffer.Printf( "\nBot benchmark: %s - %i bots - %i ticks - seed %i - world %s\n", g_BotBenchmarkScenarios[m_iScenario], m_Bots.Count(), ticks, m_iSeed, TheBotWorld->GetName() );
+    buffer.Printf( "Tick A.I. time (ms): avg %.3f p50 %.3f p90 %.3f p99 %.3f max %.3f\n", average, GetPercentile( sorted, 0.5f ), GetPercentile( sorted, 0.9f ), GetPercentile( sorted, 0.99f ), GetPercentile( sorted, 1.0f ) );
+    buffer.Printf( "Per bot (ms): avg %.4f\n", average / bots );
+    buffer.Printf( "Traces: %i (%.1f per tick)\n", traces, (ticks > 0) ? (traces / (float)ticks) : 0.0f );
+    buffer.Printf( "Skipped traces: %i (budget %i)\n", TheBotProfiler->GetTotalSkippedTraceCount(), bot_trace_budget.GetInt() );
+
+    if ( IsFirefight() )
+        ReportSquads( buffer );
+
+    // The line of fire is critical, the budget must not stop the bots from firing
+    if ( m_iScenario == BOT_BENCHMARK_BUDGET ) {
+        int lineOfSight = TheBotProfiler->GetTotalTraceCount( BOT_TRACE_LINE_OF_SIGHT );
+        int jumps = TheBotProfiler->GetTotalTraceCount( BOT_TRACE_JUMP );
+
+        buffer.Printf( "Line of sight traces: %i - Jump traces: %i\n", lineOfSight, jumps );
+
+        if ( TheBotProfiler->IsCriticalTrace( BOT_TRACE_LINE_OF_SIGHT ) && lineOfSight > 0 )
+            buffer.Printf( "Check: OK, the line of fire is traced under the budget\n" );
+        else
+            buffer.Printf( "Check: FAILED, the bots did not trace the line of fire under the budget\n" );
+    }
+    buffer.Printf( "Path computations: %i\n", TheBotProfiler->GetPathCount() );
+    buffer.Printf( "Desires: %i (%i from the cache, %i wrong with bot_desire_cache_verify %i)\n", TheBotProfiler->GetDesireCount(), TheBotProfiler->GetDesireCachedCount(), TheBotProfiler->GetDesireMismatchCount(), bot_desire_cache_verify.GetInt() );
+    buffer.Printf( "Known allocations: %i (%.2f per tick)\n", allocations, (ticks > 0) ? (allocations / (float)ticks) : 0.0f );
+    buffer.Printf( "Heap: %i KB (%+i KB since the start)\n", (int)(heap / 1024), (int)(((int64)heap - (int64)m_iStartHeap) / 1024) );
+}
+
+//================================================================================
+// Writes the threats in the tables of the squads and the enemies remembered
+// by the bots, the members only remember the enemies they have seen
+// and one enemy of the table when they have nothing else (see CBotMemory::UpdateSquadMemory)
+//================================================================================
+void CBotBenchmark::ReportSquads( CUtlBuffer &buffer )
+{
+    CUtlVector<CSquad *> squads;
+    int threats = 0;
+    int remembered = 0;
+    int informed = 0;
+
+    FOR_EACH_VEC( m_Bots, it )
+    {
+        CPlayer *pPlayer = ToInPlayer( m_Bots[it].Get() );
+
+        if ( !pPlayer || !pPlayer->GetBotController() )
+            continue;
+
+        IBot *pBot = pPlayer->GetBotController();
+        CSquad *pSquad = pBot->GetSquad();
+
+        if ( pSquad && !squads.HasElement( pSquad ) ) {
+            squads.AddToTail( pSquad );
+            threats += pSquad->GetThreatCount();
+        }
+
+        if ( !pBot->GetMemory() )
+            continue;
+
+        FOR_EACH_VEC( m_Bots, enemy )
+        {
+            CEntityMemory *memory = pBot->GetMemory()->GetEntityMemory( m_Bots[enemy].Get() );
+
+            if ( !memory || !pBot->GetDecision()->IsEnemy( memory->GetEntity() ) )
+                continue;
+
+            ++remembered;
+
+            if ( memory->GetInformer() )
+                ++informed;
+        }
+    }
+
+    buffer.Printf( "Squad threats: %i in the tables - %i enemies remembered by the bots (%i reported by a friend)\n", threats, remembered, informed );
+}
+
+//================================================================================
+//================================================================================
+CON_COMMAND_F( bot_benchmark, "Runs a benchmark of the bots. Usage: bot_benchmark <idle|firefight|follow|cover|budget|stop> [bots] [ticks] [seed]", FCVAR_SERVER )
+{
+    if ( args.ArgC() < 2 ) {
+        Msg( "Usage: bot_benchmark <idle|firefight|follow|cover|budget|stop> [bots] [ticks] [seed]\n" );
+        return;
+    }
+
+    if ( FStrEq( args.Arg( 1 ), "stop" ) ) {
+        TheBotBenchmark->Stop();
+        return;
+    }
+
+    int scenario = -1;
+
+    for ( int it = 0; it < LAST_BOT_BENCHMARK; ++it ) {
+        if ( FStrEq( args.Arg( 1 ), g_BotBenchmarkScenarios[it] ) ) {
+            scenario = it;
+            break;
+        }
+    }
+
+    if ( scenario == -1 ) {
+        Warning( "Unknown scenario: %s\n", args.Arg( 1 ) );
+        return;
+    }
+
+    int count = (args.ArgC() > 2) ? atoi( args.Arg( 2 ) ) : 32;
+    int ticks = (args.ArgC() > 3) ? atoi( args.Arg( 3 ) ) : 1000;
+    int seed = (args.ArgC() > 4) ? atoi( args.Arg( 4 ) ) : 0;
+
+    count = MAX( count, 1 );
+    ticks = MAX( ticks, 1 );
+
+    TheBotBenchmark->Start( (BotBenchmarkScenario)scenario, count, ticks, seed );
+}
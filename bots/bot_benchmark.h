@@ -0,0 +1,100 @@
+//========= Copyright  1996-2005, Valve Corporation, All rights reserved. ============//
+// Authors: 
+// Ivn Bravo Bravo (linkedin.com/in/ivanbravobravo), 2017
+
+#ifndef BOT_BENCHMARK_H
+#define BOT_BENCHMARK_H
+
+#ifdef _WIN32
+#pragma once
+#endif
+
+#include "utlbuffer.h"
+
+class CNavArea;
+
+//================================================================================
+// Scenarios of the benchmark
+//================================================================================
+enum BotBenchmarkScenario
+{
+    BOT_BENCHMARK_IDLE = 0,     // Every bot patrols random areas
+    BOT_BENCHMARK_FIREFIGHT,    // Two squads meet in the same area
+    BOT_BENCHMARK_FOLLOW,       // Every bot follows the first one
+    BOT_BENCHMARK_COVER,        // Firefight inside a synthetic world full of boxes
+    BOT_BENCHMARK_BUDGET,       // Firefight with a trace budget of 1 (see bot_trace_budget)
+
+    LAST_BOT_BENCHMARK
+};
+
+static const char *g_BotBenchmarkScenarios[LAST_BOT_BENCHMARK] =
+{
+    "idle",
+    "firefight",
+    "follow",
+    "cover",
+    "budget"
+};
+
+//================================================================================
+// Spawns [count] bots in a scenario, lets them run for a fixed number of ticks
+// and reports the cost of the A.I. in each tick.
+// With the same seed, map and server settings the runs are repeatable,
+// so it can be used to compare the cost before and after a change.
+//================================================================================
+class CBotBenchmark
+{
+public:
+    CBotBenchmark();
+
+    virtual bool IsRunning() const {
+        return m_bRunning;
+    }
+
+    virtual bool Start( BotBenchmarkScenario scenario, int count, int ticks, int seed );
+    virtual void Stop();
+    virtual void Update();
+
+    virtual void AddTime( float ms );
+
+    virtual void Report( CUtlBuffer &buffer );
+    virtual void ReportSquads( CUtlBuffer &buffer );
+
+protected:
+    virtual void SpawnBots();
+    virtual void UpdateScenario();
+    virtual void KickBots();
+
+    virtual bool IsFirefight() const;
+    virtual CNavArea *GetRandomArea();
+    virtual float GetPercentile( const CUtlVector<float> &sorted, float percentile ) const;
+
+protected:
+    bool m_bRunning;
+
+    BotBenchmarkScenario m_iScenario;
+    int m_iCount;
+    int m_iTicks;
+    int m_iSeed;
+
+    CUniformRandomStream m_Random;
+    CUtlVector< CHandle<CBasePlayer> > m_Bots;
+
+    CNavArea *m_pCenterArea;
+    CNavArea *m_pTeamAreas[2];
+
+    // Measures of each tick
+    float m_flTickTime;
+    CUtlVector<float> m_TickTimes;
+    CUtlVector<int> m_TickTraces;
+
+    int m_iStartAllocations;
+    size_t m_iStartHeap;
+
+    // bot_trace_budget before the budget scenario
+    int m_iPreviousBudget;
+};
+
+extern CBotBenchmark *TheBotBenchmark;
+
+#endif // BOT_BENCHMARK_H
@@ -4,6 +4,8 @@
 
 #include "cbase.h"
 #include "bots\bot.h"
+#include "bots\bot_manager.h"
+#include "bots\bot_profiler.h"
 
 #ifdef INSOURCE_DLL
 #include "in_utils.h"
@@ -32,6 +34,17 @@ extern ConVar bot_debug_max_msgs;
 
 extern ConVar think_limit;
 
+//================================================================================
+// Visibility of a hitbox of the threat for the debug output
+//================================================================================
+static const char *GetHitboxDebugState( CEntityMemory *memory, HitboxType part )
+{
+    if ( !memory->IsHitboxProbed( part ) )
+        return "-";
+
+    return (memory->IsHitboxVisible( part )) ? "1" : "0";
+}
+
 //================================================================================
 // Returns whether to display debugging information for this bot.
 //================================================================================
@@ -80,6 +93,34 @@ void CBot::DebugDisplay()
         DebugScreenText( msg.sprintf( "%s (%.3f ms)", GetName(), thinkTime ) );
     }
 
+    {
+        const BotThinkInfo_t &info = TheBots->GetThinkInfo( this );
+        int queued = TheBots->GetThinkGrantedCount() + TheBots->GetThinkDeferredCount();
+
+        DebugScreenText( msg.sprintf( "Level of Detail: %s", g_BotLevelsOfDetail[GetLevelOfDetail()] ) );
+        DebugScreenText( msg.sprintf( "Think Cost: %.3f ms - Priority: %.1f - Queue: %i/%i (%.2f ms debt)", info.cost, info.priority, TheBots->GetThinkGrantedCount(), queued, TheBots->GetThinkDebt() ) );
+        DebugScreenText( msg.sprintf( "Perception: %i traces (%i hits - %i misses)", GetPerception()->GetCount(), GetPerception()->GetHits(), GetPerception()->GetMisses() ) );
+        DebugScreenText( msg.sprintf( "Sight Cache: %i hits - %i misses - %i invalidated (%.0f%%)", GetSightCache()->GetHits(), GetSightCache()->GetMisses(), GetSightCache()->GetInvalidations(), GetSightCache()->GetHitRate() * 100.0f ) );
+        DebugScreenText( msg.sprintf( "Visibility: %i rays posted - %i traced (%i symmetric)", TheBotVisibility->GetPostedCount(), TheBotVisibility->GetRayCount(), TheBotVisibility->GetSymmetricCount() ) );
+        DebugScreenText( msg.sprintf( "Allocations: %i known - %i bytes of heap growth", GetAllocations(), GetHeapGrowth() ) );
+
+        CBotDecision *pDecision = dynamic_cast<CBotDecision *>(GetDecision());
+
+        if ( pDecision ) {
+            DebugScreenText( msg.sprintf( "Decision Memo: %i saved - %i evaluated", pDecision->GetMemoSaved(), pDecision->GetMemoEvaluated() ) );
+        }
+
+        int index = GetHost()->entindex();
+        DebugScreenText( msg.sprintf( "Traces: %i (%i skipped by budget) - All bots: %i", TheBotProfiler->GetTraceCount( index ), TheBotProfiler->GetSkippedTraceCount( index ), TheBotProfiler->GetFrameTraceCount() ) );
+
+        for ( int it = 0; it < LAST_BOT_TRACE; ++it ) {
+            int count = TheBotProfiler->GetTraceCount( index, (BotTraceSite)it );
+
+            if ( count > 0 )
+                DebugScreenText( msg.sprintf( "    %s: %i", g_BotTraceSites[it], count ) );
+        }
+    }
+
     DebugScreenText( msg.sprintf( "%s - %s", GetProfile()->GeSkillName(), g_TacticalModes[GetTacticalMode()] ) );
     DebugScreenText( msg.sprintf( "Health: %i", GetHealth() ) );
     DebugScreenText( "" );
@@ -165,8 +206,8 @@ void CBot::DebugDisplay()
         DebugScreenText( "" );
         DebugScreenText( msg.sprintf("Memory (Ents: %i) (%.3f ms):", GetMemory()->GetKnownCount(), GetMemory()->GetUpdateCost() ), red );
 
-        DebugScreenText( msg.sprintf( "    Threats: %i (Nearby: %i - Dangerous: %i)", GetMemory()->GetThreatCount(), GetDataMemoryInt( "NearbyThreats" ), GetDataMemoryInt( "NearbyDangerousThreats" ) ), red );
-        DebugScreenText( msg.sprintf( "    Friends: %i (Nearby: %i)", GetMemory()->GetFriendCount(), GetDataMemoryInt( "NearbyFriends" ) ), green );
+        DebugScreenText( msg.sprintf( "    Threats: %i (Nearby: %i - Dangerous: %i)", GetMemory()->GetThreatCount(), GetDataMemoryInt( MEMORY_NEARBY_THREATS ), GetDataMemoryInt( MEMORY_NEARBY_DANGEROUS_THREATS ) ), red );
+        DebugScreenText( msg.sprintf( "    Friends: %i (Nearby: %i)", GetMemory()->GetFriendCount(), GetDataMemoryInt( MEMORY_NEARBY_FRIENDS ) ), green );
 
         if ( GetEnemy() ) {
             CEntityMemory *pThreat = GetMemory()->GetPrimaryThreat();
@@ -184,11 +225,12 @@ void CBot::DebugDisplay()
             DebugScreenText( msg.sprintf( "        Time Left: %.2fs", pThreat->GetTimeLeft() ), red );
             DebugScreenText( msg.sprintf( "        Visible: %i (%.2f since visible)", pThreat->IsVisible(), pThreat->GetElapsedTimeSinceVisible() ), red );
             DebugScreenText( msg.sprintf( "        Distance: %.2f", pThreat->GetDistance() ), red );
-            DebugScreenText( msg.sprintf( "        Hitbox: (H: %i) (C: %i) (LL: %i) (RL: %i)", 
-                             pThreat->GetVisibleHitbox().head.IsValid(),
-                             pThreat->GetVisibleHitbox().chest.IsValid(),
-                             pThreat->GetVisibleHitbox().leftLeg.IsValid(),
-                             pThreat->GetVisibleHitbox().rightLeg.IsValid() ), red );
+            // - = Not traced in the last update
+            DebugScreenText( msg.sprintf( "        Hitbox: (H: %s) (C: %s) (LL: %s) (RL: %s)", 
+                             GetHitboxDebugState( pThreat, HITGROUP_HEAD ),
+                             GetHitboxDebugState( pThreat, HITGROUP_CHEST ),
+                             GetHitboxDebugState( pThreat, HITGROUP_LEFTLEG ),
+                             GetHitboxDebugState( pThreat, HITGROUP_RIGHTLEG ) ), red );
 
             if ( bot_debug_memory.GetBool() ) {
                 NDebugOverlay::EntityBounds( pThreat->GetEntity(), red.r(), red.g(), red.b(), 15.0f, 0.1f );
@@ -300,7 +342,7 @@ void CBot::DebugDisplay()
 
     // Deep Memory
     if ( bot_debug_memory.GetBool() && GetMemory() ) {
-        FOR_EACH_MAP_FAST( GetMemory()->m_Memory, it )
+        FOR_EACH_VEC( GetMemory()->m_Memory, it )
         {
             CEntityMemory *memory = GetMemory()->m_Memory[it];
             Assert( memory );
@@ -15,6 +15,7 @@
 #include "nav_area.h"
 #include "nav_mesh.h"
 #include "bots\interfaces\improv.h"
+#include "bots\interfaces\ibotworld.h"
 
 //================================================================================
 // Source Engine
@@ -238,13 +239,79 @@ public:
 //================================================================================
 //================================================================================
 
-#define MEMORY_BLOCK_LOOK_AROUND "BlockLookAround"
-#define MEMORY_SPAWN_POSITION "SpawnPosition"
-#define MEMORY_BEST_WEAPON "BestWeapon"
-#define MEMORY_DEJECTED_FRIEND "DejectedFriend"
+//================================================================================
+// Keys of the data memory known by the A.I.
+// Each key has its own slot inside the memory component, the data memories
+// with any other name (created by mods or maps) are stored by name.
+//================================================================================
+enum BotMemoryKey
+{
+    MEMORY_INVALID = -1,
+
+    MEMORY_BLOCK_LOOK_AROUND = 0,
+    MEMORY_SPAWN_POSITION,
+    MEMORY_BEST_WEAPON,
+    MEMORY_DEJECTED_FRIEND,
+    MEMORY_NEARBY_THREATS,
+    MEMORY_NEARBY_FRIENDS,
+    MEMORY_NEARBY_DANGEROUS_THREATS,
+    MEMORY_NEXT_SCHEDULE,
+    MEMORY_SAVED_POSITION,
+    MEMORY_INVESTIGATE_LOCATION,
+
+    LAST_BOT_MEMORY
+};
+
+static const char *g_BotMemoryKeys[LAST_BOT_MEMORY] =
+{
+    "BlockLookAround",
+    "SpawnPosition",
+    "BestWeapon",
+    "DejectedFriend",
+    "NearbyThreats",
+    "NearbyFriends",
+    "NearbyDangerousThreats",
+    "NextSchedule",
+    "SavedPosition",
+    "InvestigateLocation"
+};
+
+//================================================================================
+// Timers of the bots (see CBotTimerWheel)
+//================================================================================
+// Serial of the timer (32 bits) | index of the timer + 1 (32 bits)
+typedef uint64 BotTimerHandle;
+
+#define BOT_TIMER_INVALID 0
+
+enum BotTimerType
+{
+    BOT_TIMER_STATE = 0,        // Duration of the current state
+    BOT_TIMER_SCHEDULE_WAIT,    // Wait of a schedule task, [param] is the schedule
+    BOT_TIMER_DATA_MEMORY,      // Expiration of a data memory
+    BOT_TIMER_ENTITY_MEMORY,    // The memory of an entity is lost, [param] is the entity index
+
+    LAST_BOT_TIMER
+};
+
+//================================================================================
+// Rays posted to the visibility service (see CBotVisibility)
+//================================================================================
+typedef int BotVisibilityHandle;
+
+#define BOT_VISIBILITY_INVALID 0
 
 #define GET_COVER_RADIUS 1500.0f
 
+//================================================================================
+// Allocations made by the A.I. of the bots that are known (new, pools...)
+// The growth of the containers is not counted here, bot_debug_allocations
+// also measures the heap around RunAI() to see them.
+//================================================================================
+
+extern int g_iBotAllocations;
+#define BOT_COUNT_ALLOCATION() ++g_iBotAllocations
+
 //================================================================================
 // Bot Names
 // TODO: One way to change these names without editing the code. (Script file for example)
@@ -555,12 +622,57 @@ static const char *g_BotStrategie[LAST_STRATEGIE] =
 //================================================================================
 enum BotPerformance
 {
-    BOT_PERFORMANCE_AWAKE = 0,
-    BOT_PERFORMANCE_PVS,
+    BOT_PERFORMANCE_AWAKE = 0, // Always uses the level of detail that has been set
+    BOT_PERFORMANCE_PVS,       // Only think if a human can see our PVS
+    BOT_PERFORMANCE_LOD,       // The level of detail depends on our relevance to the humans
 
     LAST_PERFORMANCE
 };
 
+//================================================================================
+// Level of detail of the A.I.
+//================================================================================
+enum BotLevelOfDetail
+{
+    BOT_LOD_HIGH = 0,
+    BOT_LOD_MEDIUM,
+    BOT_LOD_LOW,
+    BOT_LOD_MINIMAL,
+
+    LAST_BOT_LOD
+};
+
+static const char *g_BotLevelsOfDetail[LAST_BOT_LOD] =
+{
+    "HIGH",
+    "MEDIUM",
+    "LOW",
+    "MINIMAL"
+};
+
+struct BotLODInfo_t
+{
+    // Minimum ticks between each A.I. processing
+    int thinkInterval;
+
+    // Maximum distance to see entities (-1 = The default of the senses)
+    float perceptionRadius;
+
+    // Minimum seconds before recomputing the path to our destination
+    float pathInterval;
+
+    // We aim to the hitboxes of our enemies (it requires bone setup and more traces)
+    bool hitboxAiming;
+};
+
+static const BotLODInfo_t g_BotLODInfo[LAST_BOT_LOD] =
+{
+    { 2, -1.0f, 3.0f, true },      // HIGH
+    { 4, 2500.0f, 5.0f, true },    // MEDIUM
+    { 8, 1500.0f, 8.0f, false },   // LOW
+    { 16, 1000.0f, 12.0f, false }  // MINIMAL
+};
+
 //================================================================================
 // Stores the assigned Hitbox number for each body part
 //================================================================================
@@ -587,6 +699,24 @@ struct HitboxPositions
         return (head.IsValid() && chest.IsValid());
     }
 
+    // Position of the hitbox, any other group is the chest
+    Vector &Get( HitboxType part ) {
+        switch ( part ) {
+            case HITGROUP_HEAD:
+                return head;
+
+            case HITGROUP_LEFTLEG:
+                return leftLeg;
+
+            case HITGROUP_RIGHTLEG:
+                return rightLeg;
+
+            case HITGROUP_CHEST:
+            default:
+                return chest;
+        }
+    }
+
     Vector head;
     Vector chest;
     Vector leftLeg;
@@ -39,6 +39,7 @@ BEGIN_DATADESC( CBotSpawn )
     DEFINE_KEYFIELD( m_iBotTacticalMode, FIELD_INTEGER, "BotTacticalMode" ),
 	DEFINE_KEYFIELD( m_iBlockLookAround, FIELD_INTEGER, "BlockLookAround" ),
     DEFINE_KEYFIELD( m_iPerformance, FIELD_INTEGER, "Performance" ),
+    DEFINE_KEYFIELD( m_iLevelOfDetail, FIELD_INTEGER, "LevelOfDetail" ),
 	DEFINE_KEYFIELD( m_nFollowEntity, FIELD_STRING, "FollowEntity" ),
     DEFINE_KEYFIELD( m_bDisabledMovement, FIELD_BOOLEAN, "DisableMovement" ),
     DEFINE_KEYFIELD( m_bIsLeader, FIELD_BOOLEAN, "IsLeader" ),
@@ -52,6 +53,7 @@ BEGIN_DATADESC( CBotSpawn )
 
     DEFINE_INPUTFUNC( FIELD_INTEGER, "SetSkill", InputSetSkill ),
     DEFINE_INPUTFUNC( FIELD_INTEGER, "SetTacticalMode", InputSetTacticalMode ),
+    DEFINE_INPUTFUNC( FIELD_INTEGER, "SetLevelOfDetail", InputSetLevelOfDetail ),
     DEFINE_INPUTFUNC( FIELD_INTEGER, "BlockLook", InputBlockLook ),
     DEFINE_INPUTFUNC( FIELD_STRING, "SetSquad", InputSetSquad ),
     DEFINE_INPUTFUNC( FIELD_VOID, "DisableMovement", InputDisableMovement ),
@@ -129,8 +131,8 @@ bool CBotSpawn::CanMake( bool bRespawn )
         if ( ThePlayersSystem->IsAbleToSee( this, filter ) )
             return false;
 #else
-        for ( int it = 0; it <= gpGlobals->maxClients; ++it ) {
-            CPlayer *pPlayer = ToInPlayer( UTIL_PlayerByIndex( it ) );
+        for ( int it = 0; it <= TheBotWorld->GetMaxPlayers(); ++it ) {
+            CPlayer *pPlayer = TheBotWorld->GetPlayer( it );
 
             if ( !pPlayer )
                 continue;
@@ -138,7 +140,7 @@ bool CBotSpawn::CanMake( bool bRespawn )
             if ( !pPlayer->IsAlive() )
                 continue;
 
-            if ( pPlayer->IsAbleToSee(this, CBaseCombatCharacter::USE_FOV ) )
+            if ( pPlayer->IsInFieldOfView( this ) && Bot_IsVisibilityClear( pPlayer, pPlayer->EyePosition(), WorldSpaceCenter(), this ) )
                 return false;
         }
 #endif
@@ -176,8 +178,21 @@ void CBotSpawn::SetUpBot()
 
     pBot->SetSkill( m_iBotSkill );
     pBot->SetTacticalMode( m_iBotTacticalMode );
+
+    // -1 = The level of detail is left to the manager
+    if ( m_iLevelOfDetail < 0 ) {
+        m_iPerformance = BOT_PERFORMANCE_LOD;
+    }
+    else {
+        m_iLevelOfDetail = MIN( m_iLevelOfDetail, LAST_BOT_LOD - 1 );
+    }
+
     pBot->SetPerformance( (BotPerformance)m_iPerformance );
 
+    if ( m_iPerformance != BOT_PERFORMANCE_LOD ) {
+        pBot->SetLevelOfDetail( (BotLevelOfDetail)m_iLevelOfDetail );
+    }
+
     if ( m_bDisabledMovement ) {
         if ( pBot->GetLocomotion() ) {
             pBot->GetLocomotion()->SetDisabled( m_bDisabledMovement );
@@ -186,7 +201,7 @@ void CBotSpawn::SetUpBot()
 
     if ( m_iBlockLookAround > 0 ) {
         if ( pBot->GetMemory() ) {
-            pBot->GetMemory()->UpdateDataMemory( "BlockLookAround", m_iBlockLookAround, m_iBlockLookAround );
+            pBot->GetMemory()->UpdateDataMemory( MEMORY_BLOCK_LOOK_AROUND, m_iBlockLookAround, m_iBlockLookAround );
         }
     }
 
@@ -222,7 +237,7 @@ void CBotSpawn::SetUpBot()
 
     if ( HasSpawnFlags( SF_USE_SPAWNER_POSITION ) ) {
         if ( pBot->GetMemory() ) {
-            pBot->GetMemory()->UpdateDataMemory( "SpawnPosition", GetAbsOrigin(), -1.0f );
+            pBot->GetMemory()->UpdateDataMemory( MEMORY_SPAWN_POSITION, GetAbsOrigin(), -1.0f );
         }
 
         GetPlayer()->Teleport( &GetAbsOrigin(), &GetAbsAngles(), NULL );
@@ -311,6 +326,30 @@ void CBotSpawn::InputSetTacticalMode( inputdata_t & inputdata )
         GetPlayer()->GetBotController()->SetTacticalMode( m_iBotTacticalMode );
 }
 
+//================================================================================
+// Sets a fixed level of detail (-1 = Automatic according to the humans)
+//================================================================================
+void CBotSpawn::InputSetLevelOfDetail( inputdata_t &inputdata )
+{
+    int value = inputdata.value.Int();
+
+    if ( value < 0 ) {
+        m_iPerformance = BOT_PERFORMANCE_LOD;
+        m_iLevelOfDetail = -1;
+    }
+    else {
+        m_iPerformance = BOT_PERFORMANCE_AWAKE;
+        m_iLevelOfDetail = MIN( value, LAST_BOT_LOD - 1 );
+    }
+
+    if ( GetPlayer() && GetPlayer()->GetBotController() ) {
+        GetPlayer()->GetBotController()->SetPerformance( (BotPerformance)m_iPerformance );
+
+        if ( m_iPerformance == BOT_PERFORMANCE_AWAKE )
+            GetPlayer()->GetBotController()->SetLevelOfDetail( (BotLevelOfDetail)m_iLevelOfDetail );
+    }
+}
+
 //================================================================================
 //================================================================================
 void CBotSpawn::InputBlockLook( inputdata_t &inputdata ) 
@@ -318,7 +357,7 @@ void CBotSpawn::InputBlockLook( inputdata_t &inputdata )
     m_iBlockLookAround = inputdata.value.Int();
 
     if ( GetPlayer() && GetPlayer()->GetBotController() && GetPlayer()->GetBotController()->GetMemory() ) {
-        GetPlayer()->GetBotController()->GetMemory()->UpdateDataMemory( "BlockLookAround", m_iBlockLookAround, -1.0f );
+        GetPlayer()->GetBotController()->GetMemory()->UpdateDataMemory( MEMORY_BLOCK_LOOK_AROUND, m_iBlockLookAround, -1.0f );
     }
 }
 
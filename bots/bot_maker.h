@@ -51,6 +51,7 @@ public:
 
     void InputSetSkill( inputdata_t &inputdata );
     void InputSetTacticalMode( inputdata_t &inputdata );
+    void InputSetLevelOfDetail( inputdata_t &inputdata );
     void InputBlockLook( inputdata_t &inputdata );
     void InputSetSquad( inputdata_t &inputdata );
     void InputDisableMovement( inputdata_t &inputdata );
@@ -74,6 +75,7 @@ protected:
     int m_iBotTacticalMode;
 	int m_iBlockLookAround;
     int m_iPerformance;
+    int m_iLevelOfDetail;
 
     bool m_bIsLeader;
     bool m_bDisabledMovement;
@@ -6,6 +6,11 @@
 #include "bots\bot_manager.h"
 
 #include "bots\bot.h"
+#include "bots\bot_profiler.h"
+#include "bots\bot_timeline.h"
+#include "bots\bot_benchmark.h"
+#include "bots\bot_world.h"
+#include "bots\bot_visibility.h"
 
 #ifdef INSOURCE_DLL
 #include "in_utils.h"
@@ -19,9 +24,36 @@
 CBotManager g_BotManager;
 CBotManager *TheBots = &g_BotManager;
 
+//================================================================================
+// Commands
+//================================================================================
+
+DECLARE_REPLICATED_COMMAND( bot_think_budget, "4", "Maximum time in ms that the bots can spend processing their A.I. in each frame." )
+DECLARE_REPLICATED_COMMAND( bot_think_min_interval, "2", "Minimum number of ticks between each A.I. processing of the same bot." )
+
+DECLARE_REPLICATED_COMMAND( bot_lod_near_distance, "1200", "Bots closer than this distance to a human always use the highest level of detail." )
+DECLARE_REPLICATED_COMMAND( bot_lod_medium_distance, "2500", "Bots farther than this distance from any human use the low level of detail." )
+DECLARE_REPLICATED_COMMAND( bot_lod_far_distance, "5000", "Bots farther than this distance from any human use the minimal level of detail." )
+DECLARE_REPLICATED_COMMAND( bot_lod_view_cone, "0.7", "Bots inside the view cone of a human (dot product) use the highest level of detail." )
+DECLARE_REPLICATED_COMMAND( bot_lod_view_cone_distance, "3500", "Bots farther than this distance from a human do not get the highest level of detail for being inside its view cone." )
+
+DECLARE_REPLICATED_COMMAND( bot_perception_parallel, "1", "Indicates if the traces of the perception stage against the world geometry can be executed in worker threads." )
+DECLARE_REPLICATED_COMMAND( bot_perception_parallel_min, "8", "Minimum number of traces to use worker threads." )
+
+static int BotThinkCandidateSort( const BotThinkCandidate_t *a, const BotThinkCandidate_t *b )
+{
+    if ( a->priority > b->priority )
+        return -1;
+
+    if ( a->priority < b->priority )
+        return 1;
+
+    return 0;
+}
+
 void Bot_RunAll() {
-    for ( int it = 0; it <= gpGlobals->maxClients; ++it ) {
-        CPlayer *pPlayer = ToInPlayer( UTIL_PlayerByIndex(it) );
+    for ( int it = 0; it <= TheBotWorld->GetMaxPlayers(); ++it ) {
+        CPlayer *pPlayer = TheBotWorld->GetPlayer( it );
 
         if ( !pPlayer )
             continue;
@@ -37,6 +69,13 @@ void Bot_RunAll() {
 //================================================================================
 CBotManager::CBotManager() : CAutoGameSystemPerFrame("BotManager")
 {
+    m_flThinkCost = 0.0f;
+    m_flThinkDebt = 0.0f;
+    m_iThinkGranted = 0;
+    m_iThinkDeferred = 0;
+    m_iSightSerial = 0;
+
+    Q_memset( m_HumanPVS, 0, sizeof( m_HumanPVS ) );
 }
 
 //================================================================================
@@ -44,14 +83,65 @@ CBotManager::CBotManager() : CAutoGameSystemPerFrame("BotManager")
 bool CBotManager::Init()
 {
     Utils::InitBotTrig();
+    m_EntitySnapshots.EnsureCapacity( MAX_EDICTS );
+    gEntList.AddListenerEntity( this );
     return true;
 }
 
+//================================================================================
+//================================================================================
+void CBotManager::Shutdown()
+{
+    gEntList.RemoveListenerEntity( this );
+}
+
+//================================================================================
+// Doors and breakables created during the game are tracked from their spawn
+//================================================================================
+void CBotManager::OnEntitySpawned( CBaseEntity *pEntity )
+{
+    if ( !Utils::IsDoor( pEntity ) && !Utils::IsBreakable( pEntity ) )
+        return;
+
+    AddSightBlocker( pEntity );
+}
+
+//================================================================================
+// A door or breakable has been removed, the answers that crossed it are not valid
+//================================================================================
+void CBotManager::OnEntityDeleted( CBaseEntity *pEntity )
+{
+    FOR_EACH_VEC( m_SightBlockers, it )
+    {
+        BotSightBlocker_t &blocker = m_SightBlockers[it];
+
+        if ( blocker.entity.Get() != pEntity )
+            continue;
+
+        InvalidateSight( blocker.mins, blocker.maxs );
+        m_SightBlockers.FastRemove( it );
+        return;
+    }
+}
+
 //================================================================================
 //================================================================================
 void CBotManager::LevelInitPostEntity()
 {
-    
+    for ( int it = 0; it < ARRAYSIZE( m_ThinkInfo ); ++it ) {
+        m_ThinkInfo[it].Reset();
+    }
+
+    m_flThinkCost = 0.0f;
+    m_flThinkDebt = 0.0f;
+
+    m_HumanViews.RemoveAll();
+    Q_memset( m_HumanPVS, 0, sizeof( m_HumanPVS ) );
+
+    m_Timers.Clear();
+    TheBotProfiler->Reset();
+
+    FindSightBlockers();
 }
 
 //================================================================================
@@ -59,8 +149,8 @@ void CBotManager::LevelInitPostEntity()
 void CBotManager::LevelShutdownPreEntity()
 {
 #ifdef INSOURCE_DLL
-    for ( int it = 0; it <= gpGlobals->maxClients; ++it ) {
-        CPlayer *pPlayer = ToInPlayer( UTIL_PlayerByIndex( it ) );
+    for ( int it = 0; it <= TheBotWorld->GetMaxPlayers(); ++it ) {
+        CPlayer *pPlayer = TheBotWorld->GetPlayer( it );
 
         if ( !pPlayer )
             continue;
@@ -73,12 +163,38 @@ void CBotManager::LevelShutdownPreEntity()
 
     engine->ServerExecute();
 #endif
+
+    // The next level starts with the world of the engine
+    TheBotBenchmark->Stop();
+    Bot_SetWorld( NULL );
+}
+
+//================================================================================
+// The bots are gone, the programs of their schedules can be released
+//================================================================================
+void CBotManager::LevelShutdownPostEntity()
+{
+    IBotSchedule::ReleaseTaskPrograms();
 }
 
 //================================================================================
 //================================================================================
 void CBotManager::FrameUpdatePreEntityThink()
 {
+    CFastTimer timer;
+    timer.Start();
+
+    m_Timers.Advance( TheBotWorld->GetTickCount() );
+
+    UpdateSightBlockers();
+    UpdateEntitySnapshots();
+    UpdateHumanViews();
+    UpdateThinkQueue();
+    UpdatePerception();
+
+    timer.End();
+    TheBotBenchmark->AddTime( timer.GetDuration().GetMillisecondsF() );
+
 #ifdef INSOURCE_DLL
     Bot_RunAll();
 #endif
@@ -88,5 +204,526 @@ void CBotManager::FrameUpdatePreEntityThink()
 //================================================================================
 void CBotManager::FrameUpdatePostEntityThink()
 {
+    TheBotTimeline->Update();
+    TheBotBenchmark->Update();
+}
+
+//================================================================================
+// Decides which bots can process their A.I. in this frame.
+// Bots are sorted by the time they have been waiting and their relevance,
+// we let them think until the estimated cost exceeds the budget, the rest
+// will have more priority in the next frame.
+//================================================================================
+void CBotManager::UpdateThinkQueue()
+{
+    VPROF_BUDGET( "CBotManager::UpdateThinkQueue", VPROF_BUDGETGROUP_BOTS );
+    BOT_TIMELINE_SCOPE( "CBotManager::UpdateThinkQueue", "Manager" );
+
+    // If we exceeded the budget in the previous frame, we pay it now
+    m_flThinkDebt = MAX( 0.0f, m_flThinkCost - bot_think_budget.GetFloat() );
+    m_flThinkCost = 0.0f;
+    m_iThinkGranted = 0;
+    m_iThinkDeferred = 0;
+
+    CUtlVector<BotThinkCandidate_t> &candidates = m_ThinkCandidates;
+    candidates.RemoveAll();
+
+    for ( int it = 1; it <= TheBotWorld->GetMaxPlayers(); ++it ) {
+        BotThinkInfo_t &info = m_ThinkInfo[it];
+        info.granted = false;
+
+        CPlayer *pPlayer = TheBotWorld->GetPlayer( it );
+
+        if ( !pPlayer )
+            continue;
+
+        if ( !pPlayer->IsBot() )
+            continue;
+
+        IBot *pBot = pPlayer->GetBotController();
+
+        if ( !pBot )
+            continue;
+
+        UpdateLevelOfDetail( pBot );
+
+        if ( !pBot->CanRunAI() )
+            continue;
+
+        int staleness = GetThinkStaleness( pBot );
+        int interval = MAX( bot_think_min_interval.GetInt(), pBot->GetLevelOfDetailInfo().thinkInterval );
+
+        if ( staleness < interval )
+            continue;
+
+        info.priority = staleness * GetThinkRelevance( pBot );
+
+        BotThinkCandidate_t candidate;
+        candidate.index = it;
+        candidate.priority = info.priority;
+        candidates.AddToTail( candidate );
+    }
+
+    if ( candidates.Count() == 0 )
+        return;
+
+    candidates.Sort( BotThinkCandidateSort );
+
+    float budget = bot_think_budget.GetFloat() - m_flThinkDebt;
+    float estimated = 0.0f;
+
+    FOR_EACH_VEC( candidates, it )
+    {
+        BotThinkInfo_t &info = m_ThinkInfo[ candidates[it].index ];
+
+        // There is no more time in this frame, the rest will think in the next one.
+        // At least one bot must think to avoid starving when a single bot is too expensive.
+        if ( m_iThinkGranted > 0 && (estimated + info.cost) > budget ) {
+            m_iThinkDeferred = candidates.Count() - m_iThinkGranted;
+            break;
+        }
+
+        info.granted = true;
+        estimated += info.cost;
+        ++m_iThinkGranted;
+    }
+}
+
+//================================================================================
+// Perception stage: The bots that will think in this frame post their traces
+// to the visibility service, the duplicated rays are merged and all of them
+// are executed in one batch before any bot runs its A.I.
+// The traces only read the world so they can be spread across worker threads.
+//================================================================================
+void CBotManager::UpdatePerception()
+{
+    VPROF_BUDGET( "CBotManager::UpdatePerception", VPROF_BUDGETGROUP_BOTS );
+    BOT_TIMELINE_SCOPE( "CBotManager::UpdatePerception", "Manager" );
+
+    TheBotVisibility->Clear();
+
+    for ( int it = 1; it <= TheBotWorld->GetMaxPlayers(); ++it ) {
+        if ( !m_ThinkInfo[it].granted )
+            continue;
+
+        CPlayer *pPlayer = TheBotWorld->GetPlayer( it );
+
+        if ( !pPlayer || !pPlayer->GetBotController() )
+            continue;
+
+        int rays = TheBotVisibility->GetRayCount();
+
+        // Bone setup and entity queries must be done in the main thread
+        pPlayer->GetBotController()->PreparePerception();
+
+        // Only the new rays are traced, the shared ones were paid by another bot
+        TheBotProfiler->CountTrace( it, BOT_TRACE_PERCEPTION, TheBotVisibility->GetRayCount() - rays );
+    }
+
+    TheBotVisibility->Execute( bot_perception_parallel.GetBool(), bot_perception_parallel_min.GetInt() );
+}
+
+//================================================================================
+// Finds the doors and breakables of the map
+//================================================================================
+void CBotManager::FindSightBlockers()
+{
+    m_SightBlockers.RemoveAll();
+    ++m_iSightSerial;
+
+    for ( CBaseEntity *pEntity = gEntList.FirstEnt(); pEntity; pEntity = gEntList.NextEnt( pEntity ) ) {
+        if ( !Utils::IsDoor( pEntity ) && !Utils::IsBreakable( pEntity ) )
+            continue;
+
+        AddSightBlocker( pEntity );
+    }
+}
+
+//================================================================================
+//================================================================================
+void CBotManager::AddSightBlocker( CBaseEntity *pEntity )
+{
+    FOR_EACH_VEC( m_SightBlockers, it )
+    {
+        if ( m_SightBlockers[it].entity.Get() == pEntity )
+            return;
+    }
+
+    int index = m_SightBlockers.AddToTail();
+    BotSightBlocker_t &blocker = m_SightBlockers[index];
+
+    blocker.entity = pEntity;
+    blocker.origin = pEntity->GetAbsOrigin();
+    blocker.angles = pEntity->GetAbsAngles();
+    pEntity->CollisionProp()->WorldSpaceAABB( &blocker.mins, &blocker.maxs );
+}
+
+//================================================================================
+// Invalidates the answers of the line of sight cache of the bots
+// that cross a door or breakable that has moved (see CBotSightCache)
+//================================================================================
+void CBotManager::UpdateSightBlockers()
+{
+    VPROF_BUDGET( "CBotManager::UpdateSightBlockers", VPROF_BUDGETGROUP_BOTS );
+
+    FOR_EACH_VEC_BACK( m_SightBlockers, it )
+    {
+        BotSightBlocker_t &blocker = m_SightBlockers[it];
+        CBaseEntity *pEntity = blocker.entity.Get();
+
+        // Removed without notifying us
+        if ( pEntity == NULL ) {
+            InvalidateSight( blocker.mins, blocker.maxs );
+            m_SightBlockers.FastRemove( it );
+            continue;
+        }
+
+        if ( pEntity->GetAbsOrigin() == blocker.origin && pEntity->GetAbsAngles() == blocker.angles )
+            continue;
+
+        // Where it was and where it is now
+        InvalidateSight( blocker.mins, blocker.maxs );
+
+        blocker.origin = pEntity->GetAbsOrigin();
+        blocker.angles = pEntity->GetAbsAngles();
+        pEntity->CollisionProp()->WorldSpaceAABB( &blocker.mins, &blocker.maxs );
+
+        InvalidateSight( blocker.mins, blocker.maxs );
+    }
+}
+
+//================================================================================
+// Invalidates the answers of all the bots whose line crosses the bounds
+//================================================================================
+void CBotManager::InvalidateSight( const Vector &mins, const Vector &maxs )
+{
+    for ( int it = 0; it <= TheBotWorld->GetMaxPlayers(); ++it ) {
+        CPlayer *pPlayer = TheBotWorld->GetPlayer( it );
+
+        if ( !pPlayer || !pPlayer->GetBotController() )
+            continue;
+
+        pPlayer->GetBotController()->GetSightCache()->Invalidate( mins, maxs );
+    }
+}
+
+//================================================================================
+// Takes the snapshot of all the players for this tick
+//================================================================================
+void CBotManager::UpdateEntitySnapshots()
+{
+    VPROF_BUDGET( "CBotManager::UpdateEntitySnapshots", VPROF_BUDGETGROUP_BOTS );
 
-}
\ No newline at end of file
+    for ( int it = 1; it <= TheBotWorld->GetMaxPlayers(); ++it ) {
+        CPlayer *pPlayer = TheBotWorld->GetPlayer( it );
+
+        if ( !pPlayer )
+            continue;
+
+        GetEntitySnapshot( pPlayer );
+    }
+}
+
+//================================================================================
+//================================================================================
+void CBotManager::TakeEntitySnapshot( BotEntitySnapshot_t &snapshot, CBaseEntity *pEntity )
+{
+    snapshot.entity = pEntity;
+    snapshot.tick = TheBotWorld->GetTickCount();
+    snapshot.position = pEntity->GetAbsOrigin();
+    snapshot.center = pEntity->WorldSpaceCenter();
+    snapshot.eyePosition = pEntity->EyePosition();
+    snapshot.velocity = pEntity->GetAbsVelocity();
+    snapshot.angles = pEntity->GetAbsAngles();
+    snapshot.mins = pEntity->WorldAlignMins();
+    snapshot.maxs = pEntity->WorldAlignMaxs();
+    snapshot.team = pEntity->GetTeamNumber();
+    snapshot.classify = pEntity->Classify();
+    snapshot.alive = pEntity->IsAlive();
+    snapshot.hitboxTick = -1;
+    snapshot.hitbox.Reset();
+}
+
+//================================================================================
+// Returns the state of the entity in this tick
+//================================================================================
+const BotEntitySnapshot_t *CBotManager::GetEntitySnapshot( CBaseEntity *pEntity )
+{
+    if ( pEntity == NULL )
+        return NULL;
+
+    int index = pEntity->entindex();
+
+    if ( index < 0 || index >= MAX_EDICTS )
+        return NULL;
+
+    if ( index >= m_EntitySnapshots.Count() ) {
+        int first = m_EntitySnapshots.AddMultipleToTail( index - m_EntitySnapshots.Count() + 1 );
+
+        for ( int it = first; it < m_EntitySnapshots.Count(); ++it ) {
+            m_EntitySnapshots[it].entity = NULL;
+            m_EntitySnapshots[it].tick = -1;
+        }
+    }
+
+    BotEntitySnapshot_t &snapshot = m_EntitySnapshots[index];
+
+    if ( snapshot.tick != TheBotWorld->GetTickCount() || snapshot.entity.Get() != pEntity ) {
+        TakeEntitySnapshot( snapshot, pEntity );
+    }
+
+    return &snapshot;
+}
+
+//================================================================================
+// Returns the state of the player with the given index in this tick, NULL if it does not exist
+//================================================================================
+const BotEntitySnapshot_t *CBotManager::GetPlayerSnapshot( int index )
+{
+    if ( m_EntitySnapshots.IsValidIndex( index ) ) {
+        const BotEntitySnapshot_t &snapshot = m_EntitySnapshots[index];
+
+        if ( snapshot.tick == TheBotWorld->GetTickCount() && snapshot.entity.Get() )
+            return &snapshot;
+    }
+
+    return GetEntitySnapshot( TheBotWorld->GetPlayer( index ) );
+}
+
+//================================================================================
+// Fill in [positions] with the hitboxes of the entity in this tick.
+// Without [bones] the generic positions are used (eyes and center)
+//================================================================================
+bool CBotManager::GetEntityHitbox( CBaseEntity *pEntity, HitboxPositions &positions, bool bones )
+{
+    positions.Reset();
+
+    const BotEntitySnapshot_t *snapshot = GetEntitySnapshot( pEntity );
+
+    if ( snapshot == NULL )
+        return false;
+
+    if ( !bones ) {
+        GetAnalyticHitbox( snapshot, positions );
+        return true;
+    }
+
+    // First bot asking for the hitboxes in this tick
+    if ( snapshot->hitboxTick != snapshot->tick ) {
+        BotEntitySnapshot_t &writable = m_EntitySnapshots[pEntity->entindex()];
+        Utils::GetHitboxPositions( pEntity, writable.hitbox );
+        writable.hitboxTick = writable.tick;
+    }
+
+    positions = snapshot->hitbox;
+    return positions.IsValid();
+}
+
+//================================================================================
+// Approximates the hitboxes with the bounds and the eyes of the entity,
+// used to aim at long range without the bone setup.
+//================================================================================
+void CBotManager::GetAnalyticHitbox( const BotEntitySnapshot_t *snapshot, HitboxPositions &positions )
+{
+    float height = snapshot->maxs.z - snapshot->mins.z;
+    float width = (snapshot->maxs.x - snapshot->mins.x) * 0.25f;
+
+    Vector vecRight;
+    AngleVectors( QAngle( 0, snapshot->angles.y, 0 ), NULL, &vecRight, NULL );
+
+    Vector vecBase = snapshot->center;
+    vecBase.z = snapshot->position.z + snapshot->mins.z;
+
+    positions.head = snapshot->eyePosition;
+    positions.chest = vecBase + Vector( 0, 0, height * 0.7f );
+    positions.leftLeg = vecBase + Vector( 0, 0, height * 0.25f ) - (vecRight * width);
+    positions.rightLeg = vecBase + Vector( 0, 0, height * 0.25f ) + (vecRight * width);
+}
+
+//================================================================================
+// Returns the multiplier for the priority of the bot in the queue
+//================================================================================
+float CBotManager::GetThinkRelevance( IBot *pBot )
+{
+    if ( pBot->IsCombating() )
+        return 3.0f;
+
+    if ( pBot->IsAlerted() )
+        return 2.0f;
+
+    return 1.0f;
+}
+
+//================================================================================
+// Saves the point of view of all the human players and 
+// combines their PVS so the bots only have to check one bit.
+//================================================================================
+void CBotManager::UpdateHumanViews()
+{
+    VPROF_BUDGET( "CBotManager::UpdateHumanViews", VPROF_BUDGETGROUP_BOTS );
+
+    m_HumanViews.RemoveAll();
+    Q_memset( m_HumanPVS, 0, sizeof( m_HumanPVS ) );
+
+    byte pvs[ MAX_MAP_CLUSTERS / 8 ];
+    int lastCluster = -1;
+
+    for ( int it = 1; it <= TheBotWorld->GetMaxPlayers(); ++it ) {
+        CPlayer *pPlayer = TheBotWorld->GetPlayer( it );
+
+        if ( !pPlayer )
+            continue;
+
+        if ( pPlayer->IsBot() || !pPlayer->IsConnected() )
+            continue;
+
+        HumanView_t view;
+        view.eyePosition = pPlayer->EyePosition();
+        pPlayer->EyeVectors( &view.forward );
+        m_HumanViews.AddToTail( view );
+
+        int cluster = engine->GetClusterForOrigin( view.eyePosition );
+
+        // Same cluster as the previous human (very common in coop)
+        if ( cluster < 0 || cluster == lastCluster )
+            continue;
+
+        lastCluster = cluster;
+
+        int bytes = engine->GetPVSForCluster( cluster, sizeof( pvs ), pvs );
+        bytes = MIN( bytes, (int)sizeof( m_HumanPVS ) );
+
+        for ( int i = 0; i < bytes; ++i ) {
+            m_HumanPVS[i] |= pvs[i];
+        }
+    }
+}
+
+//================================================================================
+// Returns if the position is inside the PVS of any human in this frame
+//================================================================================
+bool CBotManager::IsVisibleToHumans( const Vector &vecPosition )
+{
+    if ( m_HumanViews.Count() == 0 )
+        return false;
+
+    return IsClusterVisibleToHumans( engine->GetClusterForOrigin( vecPosition ) );
+}
+
+//================================================================================
+// Returns if the cluster is inside the PVS of any human in this frame
+//================================================================================
+bool CBotManager::IsClusterVisibleToHumans( int cluster )
+{
+    // Outside the world, we can not know
+    if ( cluster < 0 )
+        return (m_HumanViews.Count() > 0);
+
+    if ( cluster >= MAX_MAP_CLUSTERS )
+        return false;
+
+    return (m_HumanPVS[cluster >> 3] & (1 << (cluster & 7))) != 0;
+}
+
+//================================================================================
+// Updates the level of detail of the bot if it is automatic
+//================================================================================
+void CBotManager::UpdateLevelOfDetail( IBot *pBot )
+{
+    if ( pBot->GetPerformance() != BOT_PERFORMANCE_LOD )
+        return;
+
+    pBot->SetLevelOfDetail( ComputeLevelOfDetail( pBot ) );
+}
+
+//================================================================================
+// Returns the level of detail that the bot should use according
+// to its relevance to the human players.
+//================================================================================
+BotLevelOfDetail CBotManager::ComputeLevelOfDetail( IBot *pBot )
+{
+    // Nobody is watching
+    if ( m_HumanViews.Count() == 0 )
+        return BOT_LOD_MINIMAL;
+
+    Vector vecOrigin = pBot->GetHost()->WorldSpaceCenter();
+    float closest = FLT_MAX;
+
+    FOR_EACH_VEC( m_HumanViews, it )
+    {
+        const HumanView_t &view = m_HumanViews[it];
+
+        Vector vecDelta = vecOrigin - view.eyePosition;
+        float distance = vecDelta.NormalizeInPlace();
+
+        if ( distance <= bot_lod_near_distance.GetFloat() )
+            return BOT_LOD_HIGH;
+
+        // Inside the view cone, too far to notice the difference on open maps
+        if ( distance <= bot_lod_view_cone_distance.GetFloat() && DotProduct( view.forward, vecDelta ) >= bot_lod_view_cone.GetFloat() )
+            return BOT_LOD_HIGH;
+
+        closest = MIN( closest, distance );
+    }
+
+    // We are fighting, our enemy can be a human or it can be close to one.
+    if ( closest <= bot_lod_medium_distance.GetFloat() || pBot->IsCombating() )
+        return BOT_LOD_MEDIUM;
+
+    if ( closest <= bot_lod_far_distance.GetFloat() )
+        return BOT_LOD_LOW;
+
+    return BOT_LOD_MINIMAL;
+}
+
+//================================================================================
+// Returns if the bot can process its A.I. in this frame
+//================================================================================
+bool CBotManager::IsThinkGranted( IBot *pBot )
+{
+    return GetThinkInfo( pBot ).granted;
+}
+
+//================================================================================
+// The bot has processed its A.I. with the specified cost (in ms)
+//================================================================================
+void CBotManager::OnBotThink( IBot *pBot, float cost )
+{
+    int index = pBot->GetHost()->entindex();
+    Assert( index >= 0 && index < ARRAYSIZE( m_ThinkInfo ) );
+
+    BotThinkInfo_t &info = m_ThinkInfo[index];
+
+    if ( info.lastThinkTick == -1 )
+        info.cost = cost;
+    else
+        info.cost = (info.cost * 0.7f) + (cost * 0.3f);
+
+    info.lastThinkTick = TheBotWorld->GetTickCount();
+    info.granted = false;
+
+    m_flThinkCost += cost;
+}
+
+//================================================================================
+// Returns the number of ticks since the bot processed its A.I.
+//================================================================================
+int CBotManager::GetThinkStaleness( IBot *pBot )
+{
+    const BotThinkInfo_t &info = GetThinkInfo( pBot );
+
+    if ( info.lastThinkTick == -1 || info.lastThinkTick > TheBotWorld->GetTickCount() )
+        return TheBotWorld->GetTickCount() + 1;
+
+    return TheBotWorld->GetTickCount() - info.lastThinkTick;
+}
+
+//================================================================================
+//================================================================================
+const BotThinkInfo_t &CBotManager::GetThinkInfo( IBot *pBot )
+{
+    int index = pBot->GetHost()->entindex();
+    Assert( index >= 0 && index < ARRAYSIZE( m_ThinkInfo ) );
+
+    return m_ThinkInfo[index];
+}
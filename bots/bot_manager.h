@@ -9,21 +9,200 @@
 #pragma once
 #endif
 
+#include "bots\bot_defs.h"
+#include "bots\bot_timer_wheel.h"
+#include "bspfile.h"
+
+class IBot;
+
+//================================================================================
+// Scheduling information of a bot
+//================================================================================
+struct BotThinkInfo_t
+{
+    BotThinkInfo_t()
+    {
+        Reset();
+    }
+
+    void Reset()
+    {
+        lastThinkTick = -1;
+        cost = 0.0f;
+        priority = 0.0f;
+        granted = false;
+    }
+
+    // Tick in which the bot processed its A.I. for the last time
+    int lastThinkTick;
+
+    // Smoothed cost of RunAI() in ms
+    float cost;
+
+    // Priority of the bot in the last queue
+    float priority;
+
+    // The bot can process its A.I. in this frame
+    bool granted;
+};
+
+//================================================================================
+//================================================================================
+struct BotThinkCandidate_t
+{
+    int index;
+    float priority;
+};
+
+//================================================================================
+// State of an entity in this tick, shared by all the bots.
+// It is taken the first time a bot asks for the entity in the tick
+// (the players are taken at the start of the frame) and the hitboxes
+// the first time a bot asks for them, so the bones of an entity
+// are set up only once per tick no matter how many bots are looking at it.
+//================================================================================
+struct BotEntitySnapshot_t
+{
+    EHANDLE entity;
+
+    // Tick in which the snapshot was taken
+    int tick;
+
+    Vector position;
+    Vector center;
+    Vector eyePosition;
+    Vector velocity;
+    QAngle angles;
+    Vector mins;
+    Vector maxs;
+    int team;
+    Class_T classify;
+    bool alive;
+
+    // Tick in which the hitboxes were calculated
+    int hitboxTick;
+    HitboxPositions hitbox;
+};
+
+//================================================================================
+// Point of view of a human player in this frame
+//================================================================================
+struct HumanView_t
+{
+    Vector eyePosition;
+    Vector forward;
+};
+
+//================================================================================
+// Door or breakable of the map and where it was the last time we checked
+//================================================================================
+struct BotSightBlocker_t
+{
+    EHANDLE entity;
+    Vector origin;
+    QAngle angles;
+
+    // World bounds in the last check
+    Vector mins;
+    Vector maxs;
+};
+
 //================================================================================
 // Sistema de bots
 //================================================================================
-class CBotManager : public CAutoGameSystemPerFrame
+class CBotManager : public CAutoGameSystemPerFrame, public IEntityListener
 {
 public:
     CBotManager();
 
     virtual bool Init();
+    virtual void Shutdown();
+
+    virtual void OnEntitySpawned( CBaseEntity *pEntity );
+    virtual void OnEntityDeleted( CBaseEntity *pEntity );
 
     virtual void LevelInitPostEntity();
     virtual void LevelShutdownPreEntity();
+    virtual void LevelShutdownPostEntity();
 
     virtual void FrameUpdatePreEntityThink();
     virtual void FrameUpdatePostEntityThink();
+
+    virtual void UpdateThinkQueue();
+    virtual float GetThinkRelevance( IBot *pBot );
+
+    virtual void UpdateHumanViews();
+    virtual void UpdateLevelOfDetail( IBot *pBot );
+    virtual BotLevelOfDetail ComputeLevelOfDetail( IBot *pBot );
+
+    virtual int GetHumanViewCount() { return m_HumanViews.Count(); }
+    virtual const HumanView_t &GetHumanView( int index ) { return m_HumanViews[index]; }
+
+    virtual bool IsVisibleToHumans( const Vector &vecPosition );
+    virtual bool IsClusterVisibleToHumans( int cluster );
+
+    virtual bool IsThinkGranted( IBot *pBot );
+    virtual void OnBotThink( IBot *pBot, float cost );
+
+    virtual void UpdatePerception();
+
+    virtual void UpdateEntitySnapshots();
+    virtual void TakeEntitySnapshot( BotEntitySnapshot_t &snapshot, CBaseEntity *pEntity );
+    virtual const BotEntitySnapshot_t *GetEntitySnapshot( CBaseEntity *pEntity );
+    virtual const BotEntitySnapshot_t *GetPlayerSnapshot( int index );
+    virtual bool GetEntityHitbox( CBaseEntity *pEntity, HitboxPositions &positions, bool bones = true );
+    virtual void GetAnalyticHitbox( const BotEntitySnapshot_t *snapshot, HitboxPositions &positions );
+
+    virtual int GetThinkStaleness( IBot *pBot );
+    virtual const BotThinkInfo_t &GetThinkInfo( IBot *pBot );
+
+    virtual float GetThinkCost() { return m_flThinkCost; }
+    virtual float GetThinkDebt() { return m_flThinkDebt; }
+    virtual int GetThinkGrantedCount() { return m_iThinkGranted; }
+    virtual int GetThinkDeferredCount() { return m_iThinkDeferred; }
+
+    virtual CBotTimerWheel *GetTimers() { return &m_Timers; }
+
+    virtual void FindSightBlockers();
+    virtual void AddSightBlocker( CBaseEntity *pEntity );
+    virtual void UpdateSightBlockers();
+    virtual void InvalidateSight( const Vector &mins, const Vector &maxs );
+    virtual int GetSightSerial() { return m_iSightSerial; }
+
+protected:
+    BotThinkInfo_t m_ThinkInfo[ MAX_PLAYERS + 1 ];
+
+    // Real cost of the bots that processed their A.I. in this frame
+    float m_flThinkCost;
+
+    // Time we went over the budget in the previous frame
+    float m_flThinkDebt;
+
+    int m_iThinkGranted;
+    int m_iThinkDeferred;
+
+    // Reused in each frame to avoid allocating memory
+    CUtlVector<BotThinkCandidate_t> m_ThinkCandidates;
+
+    // Humans playing in this frame
+    CUtlVector<HumanView_t> m_HumanViews;
+
+    // PVS clusters that can be seen by any human in this frame (one bit per cluster)
+    byte m_HumanPVS[ MAX_MAP_CLUSTERS / 8 ];
+
+    // Expirations of all the bots
+    CBotTimerWheel m_Timers;
+
+    // State of the entities in this tick, indexed by the entity index.
+    // The capacity is reserved for all the edicts so the pointers
+    // returned by GetEntitySnapshot are not moved when it grows.
+    CUtlVector<BotEntitySnapshot_t> m_EntitySnapshots;
+
+    // Doors and breakables that can change the line of sight,
+    // the answers that cross them are invalidated when they move or break.
+    // The serial increases when the map changes.
+    CUtlVector<BotSightBlocker_t> m_SightBlockers;
+    int m_iSightSerial;
 };
 
 extern CBotManager *TheBots;
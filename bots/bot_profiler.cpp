@@ -0,0 +1,663 @@
+//========= Copyright  1996-2005, Valve Corporation, All rights reserved. ============//
+// Authors: 
+// Ivn Bravo Bravo (linkedin.com/in/ivanbravobravo), 2017
+
+#include "cbase.h"
+#include "bots\bot_profiler.h"
+
+#include "bots\bot.h"
+#include "filesystem.h"
+#include "utlsymbol.h"
+
+#ifdef INSOURCE_DLL
+#include "in_utils.h"
+#else
+#include "bots\in_utils.h"
+#endif
+
+// memdbgon must be the last include file in a .cpp file!!!
+#include "tier0/memdbgon.h"
+
+CBotProfiler g_BotProfiler;
+CBotProfiler *TheBotProfiler = &g_BotProfiler;
+
+//================================================================================
+// Commands
+//================================================================================
+
+DECLARE_REPLICATED_COMMAND( bot_perf_histograms, "1", "Keeps timing histograms of each bot, component, schedule and task (see bot_perf_report)." )
+DECLARE_REPLICATED_COMMAND( bot_trace_budget, "0", "Maximum number of non-critical traces per bot in each frame, when exhausted the previous answer is used. 0 = Unlimited" )
+
+//================================================================================
+//================================================================================
+void CBotHistogram::Reset()
+{
+    Q_memset( m_Buckets, 0, sizeof( m_Buckets ) );
+    m_iCount = 0;
+    m_flMax = 0.0f;
+    m_flPreviousMax = 0.0f;
+}
+
+//================================================================================
+//================================================================================
+void CBotHistogram::AddSample( float ms )
+{
+    // The window is full, the old samples lose half of their weight
+    if ( m_iCount >= BOT_HISTOGRAM_WINDOW ) {
+        m_iCount = 0;
+
+        for ( int it = 0; it < BOT_HISTOGRAM_BUCKETS; ++it ) {
+            m_Buckets[it] >>= 1;
+            m_iCount += m_Buckets[it];
+        }
+
+        m_flPreviousMax = m_flMax;
+        m_flMax = 0.0f;
+    }
+
+    ++m_Buckets[ GetBucket( ms ) ];
+    ++m_iCount;
+
+    if ( ms > m_flMax )
+        m_flMax = ms;
+}
+
+//================================================================================
+//================================================================================
+void CBotHistogram::Merge( const CBotHistogram &other )
+{
+    for ( int it = 0; it < BOT_HISTOGRAM_BUCKETS; ++it ) {
+        m_Buckets[it] += other.m_Buckets[it];
+    }
+
+    m_iCount += other.m_iCount;
+    m_flMax = MAX( m_flMax, other.m_flMax );
+    m_flPreviousMax = MAX( m_flPreviousMax, other.m_flPreviousMax );
+}
+
+//================================================================================
+// Returns the time (in ms) below which are the [percentile] (0-1) of the samples
+//================================================================================
+float CBotHistogram::GetPercentile( float percentile ) const
+{
+    if ( m_iCount == 0 )
+        return 0.0f;
+
+    unsigned int target = (unsigned int)ceil( m_iCount * clamp( percentile, 0.0f, 1.0f ) );
+    unsigned int accumulated = 0;
+
+    for ( int it = 0; it < BOT_HISTOGRAM_BUCKETS; ++it ) {
+        accumulated += m_Buckets[it];
+
+        if ( accumulated < target || accumulated == 0 )
+            continue;
+
+        // The overflow bucket has no upper limit, the real maximum is the answer
+        if ( it == BOT_HISTOGRAM_OVERFLOW )
+            return GetMax();
+
+        return MIN( GetBucketValue( it ), GetMax() );
+    }
+
+    return GetMax();
+}
+
+//================================================================================
+//================================================================================
+int CBotHistogram::GetBucket( float ms )
+{
+    float us = ms * 1000.0f;
+
+    if ( us < 1.0f )
+        return 0;
+
+    int bucket = 1 + (int)(log2f( us ) * 4.0f);
+    return MIN( bucket, BOT_HISTOGRAM_OVERFLOW );
+}
+
+//================================================================================
+// Returns the upper limit of the bucket in ms
+//================================================================================
+float CBotHistogram::GetBucketValue( int bucket )
+{
+    return powf( 2.0f, bucket / 4.0f ) / 1000.0f;
+}
+
+//================================================================================
+//================================================================================
+void BotProfileData_t::Reset()
+{
+    runAI.Reset();
+
+    for ( int it = 0; it < ARRAYSIZE( components ); ++it )
+        components[it].Reset();
+
+    for ( int it = 0; it < ARRAYSIZE( schedules ); ++it )
+        schedules[it].Reset();
+
+    for ( int it = 0; it < ARRAYSIZE( tasks ); ++it )
+        tasks[it].Reset();
+}
+
+//================================================================================
+//================================================================================
+CBotProfiler::CBotProfiler()
+{
+    Q_memset( m_pBots, 0, sizeof( m_pBots ) );
+    m_iCurrentBot = -1;
+
+    Q_memset( m_iTraceTick, 0, sizeof( m_iTraceTick ) );
+    Q_memset( m_TraceCount, 0, sizeof( m_TraceCount ) );
+    Q_memset( m_iTraceSkipped, 0, sizeof( m_iTraceSkipped ) );
+
+    m_iFrameTick = 0;
+    Q_memset( m_FrameTraceCount, 0, sizeof( m_FrameTraceCount ) );
+    Q_memset( m_TotalTraceCount, 0, sizeof( m_TotalTraceCount ) );
+    m_iTotalTraceSkipped = 0;
+    m_iTotalFrames = 0;
+    m_iTotalPathCount = 0;
+    m_iDesireCount = 0;
+    m_iDesireCachedCount = 0;
+    m_iDesireMismatchCount = 0;
+}
+
+//================================================================================
+//================================================================================
+CBotProfiler::~CBotProfiler()
+{
+    for ( int it = 0; it < ARRAYSIZE( m_pBots ); ++it ) {
+        delete m_pBots[it];
+        m_pBots[it] = NULL;
+    }
+}
+
+//================================================================================
+//================================================================================
+bool CBotProfiler::IsEnabled()
+{
+    return bot_perf_histograms.GetBool();
+}
+
+//================================================================================
+//================================================================================
+void CBotProfiler::Reset()
+{
+    for ( int it = 0; it < ARRAYSIZE( m_pBots ); ++it ) {
+        ResetBot( it );
+    }
+
+    Q_memset( m_TotalTraceCount, 0, sizeof( m_TotalTraceCount ) );
+    m_iTotalTraceSkipped = 0;
+    m_iTotalFrames = 0;
+    m_iTotalPathCount = 0;
+    m_iDesireCount = 0;
+    m_iDesireCachedCount = 0;
+    m_iDesireMismatchCount = 0;
+}
+
+//================================================================================
+//================================================================================
+void CBotProfiler::ResetBot( int index )
+{
+    if ( index < 0 || index >= ARRAYSIZE( m_pBots ) )
+        return;
+
+    if ( m_pBots[index] )
+        m_pBots[index]->Reset();
+}
+
+//================================================================================
+// Adds the time (in ms) that the bot [index] has spent in something
+//================================================================================
+void CBotProfiler::AddSample( int index, BotProfileCategory category, int id, float ms )
+{
+    if ( !IsEnabled() )
+        return;
+
+    if ( index < 0 || index >= ARRAYSIZE( m_pBots ) )
+        return;
+
+    // Only the first time
+    if ( !m_pBots[index] ) {
+        BOT_COUNT_ALLOCATION();
+        m_pBots[index] = new BotProfileData_t();
+    }
+
+    CBotHistogram *pHistogram = GetHistogram( index, category, id );
+
+    if ( pHistogram )
+        pHistogram->AddSample( ms );
+}
+
+//================================================================================
+//================================================================================
+CBotHistogram *CBotProfiler::GetHistogram( int index, BotProfileCategory category, int id )
+{
+    if ( index < 0 || index >= ARRAYSIZE( m_pBots ) || !m_pBots[index] )
+        return NULL;
+
+    BotProfileData_t *data = m_pBots[index];
+
+    switch ( category ) {
+        case BOT_PROFILE_RUNAI:
+            return &data->runAI;
+
+        case BOT_PROFILE_COMPONENT:
+            if ( id < 0 || id >= LAST_COMPONENT )
+                return NULL;
+
+            return &data->components[id];
+
+        case BOT_PROFILE_SCHEDULE:
+            if ( id < 0 || id >= LAST_BOT_SCHEDULE )
+                return NULL;
+
+            return &data->schedules[id];
+
+        case BOT_PROFILE_TASK:
+            if ( id < 0 )
+                return NULL;
+
+            // Custom tasks
+            if ( id >= BLAST_TASK )
+                id = BLAST_TASK;
+
+            return &data->tasks[id];
+    }
+
+    return NULL;
+}
+
+//================================================================================
+//================================================================================
+int CBotProfiler::GetHistogramCount( BotProfileCategory category )
+{
+    switch ( category ) {
+        case BOT_PROFILE_RUNAI:
+            return 1;
+
+        case BOT_PROFILE_COMPONENT:
+            return LAST_COMPONENT;
+
+        case BOT_PROFILE_SCHEDULE:
+            return LAST_BOT_SCHEDULE;
+
+        case BOT_PROFILE_TASK:
+            return BLAST_TASK + 1;
+    }
+
+    return 0;
+}
+
+//================================================================================
+//================================================================================
+const char *CBotProfiler::GetHistogramName( BotProfileCategory category, int id )
+{
+    static const char *componentNames[LAST_COMPONENT] =
+    {
+        "VISION",
+        "LOCOMOTION",
+        "FOLLOW",
+        "MEMORY",
+        "ATTACK",
+        "DECISION"
+    };
+
+    switch ( category ) {
+        case BOT_PROFILE_RUNAI:
+            return "RunAI";
+
+        case BOT_PROFILE_COMPONENT:
+            if ( id >= 0 && id < LAST_COMPONENT )
+                return componentNames[id];
+
+            break;
+
+        case BOT_PROFILE_SCHEDULE:
+            if ( id >= 0 && id < LAST_BOT_SCHEDULE )
+                return g_BotSchedules[id];
+
+            break;
+
+        case BOT_PROFILE_TASK:
+            if ( id >= 0 && id < BLAST_TASK )
+                return g_BotTasks[id];
+
+            // The histogram where all the custom tasks are merged
+            if ( id == BLAST_TASK )
+                return "CUSTOM";
+
+            break;
+
+        default:
+            return "";
+    }
+
+    // Components, schedules or tasks of the mod, named like GetActiveTaskName().
+    // The timeline keeps the name, so it must live until the end.
+    static CUtlSymbolTable customNames;
+    static const char *prefixes[LAST_BOT_PROFILE] = { "", "CUSTOM COMPONENT", "CUSTOM SCHEDULE", "CUSTOM" };
+
+    char name[64];
+    Q_snprintf( name, sizeof( name ), "%s: %i", prefixes[category], id );
+
+    return customNames.String( customNames.AddString( name ) );
+}
+
+//================================================================================
+// Writes the aggregates of all the bots and the cost of each bot
+//================================================================================
+void CBotProfiler::Report( CUtlBuffer &buffer )
+{
+    buffer.Printf( "Bots timing report (ms) - tick %i\n\n", TheBotWorld->GetTickCount() );
+
+    for ( int category = 0; category < LAST_BOT_PROFILE; ++category ) {
+        buffer.Printf( "%-32s %8s %8s %8s %8s %8s\n", g_BotProfileCategories[category], "samples", "p50", "p95", "p99", "max" );
+
+        for ( int id = 0; id < GetHistogramCount( (BotProfileCategory)category ); ++id ) {
+            CBotHistogram total;
+
+            for ( int it = 0; it < ARRAYSIZE( m_pBots ); ++it ) {
+                CBotHistogram *pHistogram = GetHistogram( it, (BotProfileCategory)category, id );
+
+                if ( pHistogram )
+                    total.Merge( *pHistogram );
+            }
+
+            if ( total.GetCount() == 0 )
+                continue;
+
+            buffer.Printf( "%-32s %8i %8.3f %8.3f %8.3f %8.3f\n", GetHistogramName( (BotProfileCategory)category, id ), total.GetCount(), total.GetPercentile( 0.5f ), total.GetPercentile( 0.95f ), total.GetPercentile( 0.99f ), total.GetMax() );
+        }
+
+        buffer.Printf( "\n" );
+    }
+
+    buffer.Printf( "%-32s %8s %8s %8s %8s %8s\n", "Bot", "samples", "p50", "p95", "p99", "max" );
+
+    for ( int it = 1; it <= TheBotWorld->GetMaxPlayers(); ++it ) {
+        CPlayer *pPlayer = TheBotWorld->GetPlayer( it );
+
+        if ( !pPlayer || !pPlayer->IsBot() )
+            continue;
+
+        CBotHistogram *pHistogram = GetHistogram( it, BOT_PROFILE_RUNAI, 0 );
+
+        if ( !pHistogram || pHistogram->GetCount() == 0 )
+            continue;
+
+        buffer.Printf( "%-32s %8i %8.3f %8.3f %8.3f %8.3f\n", pPlayer->GetPlayerName(), pHistogram->GetCount(), pHistogram->GetPercentile( 0.5f ), pHistogram->GetPercentile( 0.95f ), pHistogram->GetPercentile( 0.99f ), pHistogram->GetMax() );
+    }
+}
+
+//================================================================================
+// Starts a new frame of traces for the bot [index] (-1 = All the bots)
+//================================================================================
+void CBotProfiler::UpdateTraceFrame( int index )
+{
+    if ( m_iFrameTick != TheBotWorld->GetTickCount() ) {
+        Q_memset( m_FrameTraceCount, 0, sizeof( m_FrameTraceCount ) );
+        m_iFrameTick = TheBotWorld->GetTickCount();
+        ++m_iTotalFrames;
+    }
+
+    if ( index < 0 || index >= ARRAYSIZE( m_iTraceTick ) )
+        return;
+
+    if ( m_iTraceTick[index] != TheBotWorld->GetTickCount() ) {
+        Q_memset( m_TraceCount[index], 0, sizeof( m_TraceCount[index] ) );
+        m_iTraceSkipped[index] = 0;
+        m_iTraceTick[index] = TheBotWorld->GetTickCount();
+    }
+}
+
+//================================================================================
+// The bot [index] has made [count] traces in [site]
+//================================================================================
+void CBotProfiler::CountTrace( int index, BotTraceSite site, int count )
+{
+    UpdateTraceFrame( index );
+
+    m_FrameTraceCount[site] += count;
+    m_TotalTraceCount[site] += count;
+
+    if ( index < 0 || index >= ARRAYSIZE( m_TraceCount ) )
+        return;
+
+    m_TraceCount[index][site] += count;
+}
+
+//================================================================================
+// Returns if the bot [index] can make a trace in [site]
+// When the budget of the frame is exhausted, the non-critical traces
+// must use their previous answer.
+//================================================================================
+bool CBotProfiler::CanTrace( int index, BotTraceSite site )
+{
+    if ( bot_trace_budget.GetInt() <= 0 )
+        return true;
+
+    if ( IsCriticalTrace( site ) )
+        return true;
+
+    if ( index < 0 || index >= ARRAYSIZE( m_TraceCount ) )
+        return true;
+
+    if ( GetTraceCount( index ) < bot_trace_budget.GetInt() )
+        return true;
+
+    ++m_iTraceSkipped[index];
+    ++m_iTotalTraceSkipped;
+    return false;
+}
+
+//================================================================================
+// Returns if the traces of [site] are always made, they have no previous answer
+// or the bots would stop fighting without them (line of fire)
+//================================================================================
+bool CBotProfiler::IsCriticalTrace( BotTraceSite site )
+{
+    switch ( site ) {
+        case BOT_TRACE_PERCEPTION:
+        case BOT_TRACE_VISIBILITY:
+        case BOT_TRACE_LINE_OF_SIGHT:
+        case BOT_TRACE_SQUAD_LOOKING:
+        case BOT_TRACE_GROUND:
+        case BOT_TRACE_PATH:
+            return true;
+    }
+
+    return false;
+}
+
+//================================================================================
+// Returns the traces of the bot [index] in this frame (LAST_BOT_TRACE = All)
+//================================================================================
+int CBotProfiler::GetTraceCount( int index, BotTraceSite site )
+{
+    if ( index < 0 || index >= ARRAYSIZE( m_TraceCount ) )
+        return 0;
+
+    UpdateTraceFrame( index );
+
+    if ( site != LAST_BOT_TRACE )
+        return m_TraceCount[index][site];
+
+    int count = 0;
+
+    for ( int it = 0; it < LAST_BOT_TRACE; ++it ) {
+        count += m_TraceCount[index][it];
+    }
+
+    return count;
+}
+
+//================================================================================
+// Returns the traces of all the bots in this frame (LAST_BOT_TRACE = All)
+//================================================================================
+int CBotProfiler::GetFrameTraceCount( BotTraceSite site )
+{
+    UpdateTraceFrame( -1 );
+
+    if ( site != LAST_BOT_TRACE )
+        return m_FrameTraceCount[site];
+
+    int count = 0;
+
+    for ( int it = 0; it < LAST_BOT_TRACE; ++it ) {
+        count += m_FrameTraceCount[it];
+    }
+
+    return count;
+}
+
+//================================================================================
+// Returns the traces of all the bots since the last reset (LAST_BOT_TRACE = All)
+//================================================================================
+int CBotProfiler::GetTotalTraceCount( BotTraceSite site )
+{
+    if ( site != LAST_BOT_TRACE )
+        return m_TotalTraceCount[site];
+
+    int count = 0;
+
+    for ( int it = 0; it < LAST_BOT_TRACE; ++it ) {
+        count += m_TotalTraceCount[it];
+    }
+
+    return count;
+}
+
+//================================================================================
+// Returns the traces of the bot [index] that were skipped in this frame by the budget
+//================================================================================
+int CBotProfiler::GetSkippedTraceCount( int index )
+{
+    if ( index < 0 || index >= ARRAYSIZE( m_iTraceSkipped ) )
+        return 0;
+
+    UpdateTraceFrame( index );
+    return m_iTraceSkipped[index];
+}
+
+//================================================================================
+// Writes the traces of each site and each bot
+//================================================================================
+void CBotProfiler::ReportTraces( CUtlBuffer &buffer )
+{
+    buffer.Printf( "Bots traces - %i frames since the last reset (budget: %i)\n\n", m_iTotalFrames, bot_trace_budget.GetInt() );
+    buffer.Printf( "%-32s %8s %10s %10s\n", "Site", "frame", "total", "per frame" );
+
+    for ( int it = 0; it < LAST_BOT_TRACE; ++it ) {
+        float average = (m_iTotalFrames > 0) ? (m_TotalTraceCount[it] / (float)m_iTotalFrames) : 0.0f;
+        buffer.Printf( "%-32s %8i %10i %10.2f\n", g_BotTraceSites[it], GetFrameTraceCount( (BotTraceSite)it ), m_TotalTraceCount[it], average );
+    }
+
+    buffer.Printf( "\n%-32s %8s %8s\n", "Bot", "frame", "skipped" );
+
+    for ( int it = 1; it <= TheBotWorld->GetMaxPlayers(); ++it ) {
+        CPlayer *pPlayer = TheBotWorld->GetPlayer( it );
+
+        if ( !pPlayer || !pPlayer->IsBot() )
+            continue;
+
+        buffer.Printf( "%-32s %8i %8i\n", pPlayer->GetPlayerName(), GetTraceCount( it ), GetSkippedTraceCount( it ) );
+    }
+}
+
+//================================================================================
+// Returns if the current bot can make a non-critical trace
+//================================================================================
+bool Bot_CanTrace( BotTraceSite site )
+{
+    return TheBotProfiler->CanTrace( TheBotProfiler->GetCurrentBot(), site );
+}
+
+//================================================================================
+//================================================================================
+void Bot_TraceLine( BotTraceSite site, const Vector &vecAbsStart, const Vector &vecAbsEnd, unsigned int mask, const IHandleEntity *ignore, int collisionGroup, trace_t *ptr )
+{
+    TheBotProfiler->CountTrace( TheBotProfiler->GetCurrentBot(), site );
+    TheBotWorld->TraceLine( vecAbsStart, vecAbsEnd, mask, ignore, collisionGroup, ptr );
+}
+
+//================================================================================
+//================================================================================
+void Bot_TraceLine( BotTraceSite site, const Vector &vecAbsStart, const Vector &vecAbsEnd, unsigned int mask, ITraceFilter *pFilter, trace_t *ptr )
+{
+    TheBotProfiler->CountTrace( TheBotProfiler->GetCurrentBot(), site );
+    TheBotWorld->TraceLine( vecAbsStart, vecAbsEnd, mask, pFilter, ptr );
+}
+
+//================================================================================
+//================================================================================
+void Bot_TraceHull( BotTraceSite site, const Vector &vecAbsStart, const Vector &vecAbsEnd, const Vector &hullMin, const Vector &hullMax, unsigned int mask, const IHandleEntity *ignore, int collisionGroup, trace_t *ptr )
+{
+    TheBotProfiler->CountTrace( TheBotProfiler->GetCurrentBot(), site );
+    TheBotWorld->TraceHull( vecAbsStart, vecAbsEnd, hullMin, hullMax, mask, ignore, collisionGroup, ptr );
+}
+
+//================================================================================
+//================================================================================
+bool Bot_IsWalkableTraceLineClear( BotTraceSite site, const Vector &from, const Vector &to, unsigned int flags )
+{
+    TheBotProfiler->CountTrace( TheBotProfiler->GetCurrentBot(), site );
+    return TheBotWorld->IsWalkableTraceLineClear( from, to, flags );
+}
+
+//================================================================================
+// Prints a report line by line, the console can not print very long strings
+//================================================================================
+static void PrintReport( CUtlBuffer &buffer )
+{
+    buffer.PutChar( 0 );
+    const char *pReport = (const char *)buffer.Base();
+    char line[256];
+
+    while ( *pReport ) {
+        const char *pEnd = Q_strstr( pReport, "\n" );
+        int length = (pEnd) ? (pEnd - pReport) + 1 : Q_strlen( pReport );
+
+        Q_strncpy( line, pReport, MIN( length + 1, (int)sizeof( line ) ) );
+        Msg( "%s", line );
+
+        pReport += length;
+    }
+}
+
+//================================================================================
+// Prints the report in the console or writes it to a file
+//================================================================================
+CON_COMMAND_F( bot_perf_report, "Prints the timing histograms of the bots. Usage: bot_perf_report [filename]", FCVAR_SERVER )
+{
+    CUtlBuffer buffer( 0, 0, CUtlBuffer::TEXT_BUFFER );
+    TheBotProfiler->Report( buffer );
+
+    if ( args.ArgC() > 1 ) {
+        if ( filesystem->WriteFile( args.Arg( 1 ), "MOD", buffer ) )
+            Msg( "Bots timing report saved in %s\n", args.Arg( 1 ) );
+        else
+            Warning( "The report could not be saved in %s\n", args.Arg( 1 ) );
+
+        return;
+    }
+
+    PrintReport( buffer );
+}
+
+//================================================================================
+//================================================================================
+CON_COMMAND_F( bot_trace_report, "Prints the traces made by the bots in each site", FCVAR_SERVER )
+{
+    CUtlBuffer buffer( 0, 0, CUtlBuffer::TEXT_BUFFER );
+    TheBotProfiler->ReportTraces( buffer );
+
+    PrintReport( buffer );
+}
+
+//================================================================================
+//================================================================================
+CON_COMMAND_F( bot_perf_reset, "Resets the timing histograms of the bots", FCVAR_SERVER )
+{
+    TheBotProfiler->Reset();
+}
@@ -0,0 +1,249 @@
+//========= Copyright  1996-2005, Valve Corporation, All rights reserved. ============//
+// Authors: 
+// Ivn Bravo Bravo (linkedin.com/in/ivanbravobravo), 2017
+
+#ifndef BOT_PROFILER_H
+#define BOT_PROFILER_H
+
+#ifdef _WIN32
+#pragma once
+#endif
+
+#include "bots\bot_defs.h"
+#include "utlbuffer.h"
+
+//================================================================================
+// Histogram of times with logarithmic buckets (4 per power of 2, from 1us to ~14s)
+// The last bucket gets the slower samples, its percentile is the real maximum.
+// Adding a sample is constant and it can be merged with others.
+// When the window is full the buckets are halved, so old samples
+// lose weight and the percentiles follow the recent behavior.
+//================================================================================
+
+#define BOT_HISTOGRAM_BUCKETS 96
+#define BOT_HISTOGRAM_OVERFLOW (BOT_HISTOGRAM_BUCKETS - 1)
+#define BOT_HISTOGRAM_WINDOW 2048
+
+class CBotHistogram
+{
+public:
+    CBotHistogram()
+    {
+        Reset();
+    }
+
+    void Reset();
+    void AddSample( float ms );
+    void Merge( const CBotHistogram &other );
+
+    int GetCount() const {
+        return m_iCount;
+    }
+
+    float GetMax() const {
+        return MAX( m_flMax, m_flPreviousMax );
+    }
+
+    float GetPercentile( float percentile ) const;
+
+    static int GetBucket( float ms );
+    static float GetBucketValue( int bucket );
+
+protected:
+    unsigned int m_Buckets[ BOT_HISTOGRAM_BUCKETS ];
+    int m_iCount;
+    float m_flMax;
+    float m_flPreviousMax;
+};
+
+//================================================================================
+// What is being measured
+//================================================================================
+enum BotProfileCategory
+{
+    BOT_PROFILE_RUNAI = 0,
+    BOT_PROFILE_COMPONENT,
+    BOT_PROFILE_SCHEDULE,
+    BOT_PROFILE_TASK,
+
+    LAST_BOT_PROFILE
+};
+
+static const char *g_BotProfileCategories[LAST_BOT_PROFILE] =
+{
+    "RunAI",
+    "Component",
+    "Schedule",
+    "Task"
+};
+
+//================================================================================
+// Places where the bots make traces
+//================================================================================
+enum BotTraceSite
+{
+    BOT_TRACE_PERCEPTION = 0,   // CBotManager::UpdatePerception
+    BOT_TRACE_VISIBILITY,       // IsAbleToSee() without perception result
+    BOT_TRACE_LINE_OF_SIGHT,    // IsLineOfSightClear() without perception result
+    BOT_TRACE_JUMP,             // ShouldJump()
+    BOT_TRACE_TELEPORT,         // ShouldTeleport()
+    BOT_TRACE_CROUCH_ATTACK,    // ShouldCrouchAttack()
+    BOT_TRACE_SQUAD_LOOKING,    // CSquad::IsSomeoneLooking()
+    BOT_TRACE_GROUND,           // GetGround() and GetGroundNormal()
+    BOT_TRACE_PATH,             // CNavPath and CNavPathFollower
+
+    LAST_BOT_TRACE
+};
+
+static const char *g_BotTraceSites[LAST_BOT_TRACE] =
+{
+    "PERCEPTION",
+    "VISIBILITY",
+    "LINE_OF_SIGHT",
+    "JUMP",
+    "TELEPORT",
+    "CROUCH_ATTACK",
+    "SQUAD_LOOKING",
+    "GROUND",
+    "PATH"
+};
+
+//================================================================================
+// Histograms of a bot
+//================================================================================
+struct BotProfileData_t
+{
+    void Reset();
+
+    CBotHistogram runAI;
+    CBotHistogram components[ LAST_COMPONENT ];
+    CBotHistogram schedules[ LAST_BOT_SCHEDULE ];
+
+    // The last one is for the custom tasks (BCUSTOM_TASK)
+    CBotHistogram tasks[ BLAST_TASK + 1 ];
+};
+
+//================================================================================
+// Timing histograms of all the bots.
+// Used to find which schedule or task is responsible for the tail latency
+// of the tick without attaching a profiler (see bot_perf_report)
+//================================================================================
+class CBotProfiler
+{
+public:
+    CBotProfiler();
+    ~CBotProfiler();
+
+    virtual bool IsEnabled();
+
+    virtual void Reset();
+    virtual void ResetBot( int index );
+
+    virtual void AddSample( int index, BotProfileCategory category, int id, float ms );
+
+    virtual CBotHistogram *GetHistogram( int index, BotProfileCategory category, int id );
+    virtual int GetHistogramCount( BotProfileCategory category );
+    virtual const char *GetHistogramName( BotProfileCategory category, int id );
+
+    virtual void Report( CUtlBuffer &buffer );
+
+    // Traces
+    virtual void SetCurrentBot( int index ) { m_iCurrentBot = index; }
+    virtual int GetCurrentBot() { return m_iCurrentBot; }
+
+    virtual void CountTrace( int index, BotTraceSite site, int count = 1 );
+    virtual bool CanTrace( int index, BotTraceSite site );
+    virtual bool IsCriticalTrace( BotTraceSite site );
+
+    virtual int GetTraceCount( int index, BotTraceSite site = LAST_BOT_TRACE );
+    virtual int GetFrameTraceCount( BotTraceSite site = LAST_BOT_TRACE );
+    virtual int GetSkippedTraceCount( int index );
+
+    virtual int GetTotalTraceCount( BotTraceSite site = LAST_BOT_TRACE );
+    virtual int GetTotalSkippedTraceCount() { return m_iTotalTraceSkipped; }
+
+    virtual void ReportTraces( CUtlBuffer &buffer );
+
+    // Paths
+    virtual void CountPath() { ++m_iTotalPathCount; }
+    virtual int GetPathCount() { return m_iTotalPathCount; }
+
+    // Desire cache of the schedules (see bot_desire_cache_verify)
+    virtual void CountDesire( bool cached ) {
+        ++m_iDesireCount;
+
+        if ( cached )
+            ++m_iDesireCachedCount;
+    }
+
+    virtual void CountDesireMismatch() { ++m_iDesireMismatchCount; }
+
+    virtual int GetDesireCount() { return m_iDesireCount; }
+    virtual int GetDesireCachedCount() { return m_iDesireCachedCount; }
+    virtual int GetDesireMismatchCount() { return m_iDesireMismatchCount; }
+
+protected:
+    virtual void UpdateTraceFrame( int index );
+
+protected:
+    BotProfileData_t *m_pBots[ MAX_PLAYERS + 1 ];
+
+    // Bot that is processing its A.I. in the main thread (-1 = None)
+    int m_iCurrentBot;
+
+    // Traces of each bot in the current frame
+    int m_iTraceTick[ MAX_PLAYERS + 1 ];
+    int m_TraceCount[ MAX_PLAYERS + 1 ][ LAST_BOT_TRACE ];
+    int m_iTraceSkipped[ MAX_PLAYERS + 1 ];
+
+    // Traces of all the bots in the current frame and since the last reset
+    int m_iFrameTick;
+    int m_FrameTraceCount[ LAST_BOT_TRACE ];
+    int m_TotalTraceCount[ LAST_BOT_TRACE ];
+    int m_iTotalTraceSkipped;
+    int m_iTotalFrames;
+
+    // Paths computed since the last reset
+    int m_iTotalPathCount;
+
+    // Desires asked, answered by the cache and wrong answers of the cache since the last reset
+    int m_iDesireCount;
+    int m_iDesireCachedCount;
+    int m_iDesireMismatchCount;
+};
+
+//================================================================================
+// Traces of the bots, they are counted for the current bot (see bot_trace_budget)
+//================================================================================
+
+extern bool Bot_CanTrace( BotTraceSite site );
+
+extern void Bot_TraceLine( BotTraceSite site, const Vector &vecAbsStart, const Vector &vecAbsEnd, unsigned int mask, const IHandleEntity *ignore, int collisionGroup, trace_t *ptr );
+extern void Bot_TraceLine( BotTraceSite site, const Vector &vecAbsStart, const Vector &vecAbsEnd, unsigned int mask, ITraceFilter *pFilter, trace_t *ptr );
+extern void Bot_TraceHull( BotTraceSite site, const Vector &vecAbsStart, const Vector &vecAbsEnd, const Vector &hullMin, const Vector &hullMax, unsigned int mask, const IHandleEntity *ignore, int collisionGroup, trace_t *ptr );
+extern bool Bot_IsWalkableTraceLineClear( BotTraceSite site, const Vector &from, const Vector &to, unsigned int flags = 0 );
+
+extern CBotProfiler *TheBotProfiler;
+
+//================================================================================
+// Marks a bot as the current one until the end of the scope
+//================================================================================
+class CBotProfilerScope
+{
+public:
+    CBotProfilerScope( int index )
+    {
+        m_iPrevious = TheBotProfiler->GetCurrentBot();
+        TheBotProfiler->SetCurrentBot( index );
+    }
+
+    ~CBotProfilerScope()
+    {
+        TheBotProfiler->SetCurrentBot( m_iPrevious );
+    }
+
+protected:
+    int m_iPrevious;
+};
+
+#endif // BOT_PROFILER_H
@@ -80,7 +80,7 @@ void CBot::OnLooked( CBaseEntity *pSightEnt )
             CPlayer *pSightPlayer = ToInPlayer( pSightEnt );
 
             if ( GetDecision()->ShouldHelpDejectedFriend( pSightPlayer ) ) {
-                GetMemory()->UpdateDataMemory( "DejectedFriend", pSightEnt, 30.0f );
+                GetMemory()->UpdateDataMemory( MEMORY_DEJECTED_FRIEND, pSightEnt, 30.0f );
                 SetCondition( BCOND_SEE_DEJECTED_FRIEND );
             }
         }
@@ -92,7 +92,7 @@ void CBot::OnLooked( CBaseEntity *pSightEnt )
             Assert( pWeapon );
 
             if ( GetDecision()->ShouldGrabWeapon( pWeapon ) ) {
-                GetMemory()->UpdateDataMemory( "BestWeapon", pSightEnt, 30.0f );
+                GetMemory()->UpdateDataMemory( MEMORY_BEST_WEAPON, pSightEnt, 30.0f );
                 SetCondition( BCOND_BETTER_WEAPON_AVAILABLE );
             }
         }
@@ -49,6 +49,7 @@ void CBotProfile::SetSkill( int skill )
             SetAttackDelay( RandomFloat( 0.01f, 0.05f ) );
             SetFavoriteHitbox( HITGROUP_STOMACH );
             SetAggression( 30.0f );
+            SetHitboxBonesDistance( 800.0f );
             break;
 
         case SKILL_MEDIUM:
@@ -60,6 +61,7 @@ void CBotProfile::SetSkill( int skill )
             SetAttackDelay( RandomFloat( 0.005f, 0.01f ) );
             SetFavoriteHitbox( RandomInt( HITGROUP_CHEST, HITGROUP_STOMACH ) );
             SetAggression( 60.0f );
+            SetHitboxBonesDistance( 1200.0f );
             break;
 
         case SKILL_HARD:
@@ -70,6 +72,7 @@ void CBotProfile::SetSkill( int skill )
             SetAttackDelay( RandomFloat( 0.0001f, 0.005f ) );
             SetFavoriteHitbox( RandomInt( HITGROUP_CHEST, HITGROUP_STOMACH ) );
             SetAggression( 100.0f );
+            SetHitboxBonesDistance( 2000.0f );
             break;
 #else
         case SKILL_EASY:
@@ -80,6 +83,7 @@ void CBotProfile::SetSkill( int skill )
             SetAttackDelay( RandomFloat(0.5f, 0.8f) );
             SetFavoriteHitbox( HITGROUP_STOMACH );
             SetAggression( RandomInt(10.0f, 20.0f) );
+            SetHitboxBonesDistance( 800.0f );
             break;
 
         case SKILL_MEDIUM:
@@ -91,6 +95,7 @@ void CBotProfile::SetSkill( int skill )
             SetAttackDelay( RandomFloat( 0.3f, 0.5f ) );
             SetFavoriteHitbox( RandomInt( HITGROUP_CHEST, HITGROUP_STOMACH ) );
             SetAggression( RandomInt( 30.0f, 40.0f ) );
+            SetHitboxBonesDistance( 1200.0f );
             break;
 
         case SKILL_HARD:
@@ -101,6 +106,7 @@ void CBotProfile::SetSkill( int skill )
             SetAttackDelay( RandomFloat( 0.1f, 0.3f ) );
             SetFavoriteHitbox( RandomInt( HITGROUP_HEAD, HITGROUP_STOMACH ) );
             SetAggression( RandomInt( 50.0f, 60.0f ) );
+            SetHitboxBonesDistance( 2000.0f );
             break;
 #endif
 
@@ -113,6 +119,7 @@ void CBotProfile::SetSkill( int skill )
             SetAttackDelay( RandomFloat( 0.01f, 0.3f ) );
             SetFavoriteHitbox( RandomInt( HITGROUP_HEAD, HITGROUP_CHEST ) );
             SetAggression( RandomInt( 60.0f, 70.0f ) );
+            SetHitboxBonesDistance( 2500.0f );
             break;
 
         case SKILL_ULTRA_HARD:
@@ -123,6 +130,7 @@ void CBotProfile::SetSkill( int skill )
             SetAttackDelay( RandomFloat( 0.005f, 0.1f ) );
             SetFavoriteHitbox( RandomInt( HITGROUP_HEAD, HITGROUP_CHEST ) );
             SetAggression( RandomInt( 80.0f, 90.0f ) );
+            SetHitboxBonesDistance( 3500.0f );
             break;
 
         case SKILL_IMPOSIBLE:
@@ -133,6 +141,7 @@ void CBotProfile::SetSkill( int skill )
             SetAttackDelay( RandomFloat( 0.001f, 0.01f ) );
             SetFavoriteHitbox( RandomInt( HITGROUP_HEAD, HITGROUP_CHEST ) );
             SetAggression( 100.0f );
+            SetHitboxBonesDistance( 0.0f );
             break;
 #endif
     }
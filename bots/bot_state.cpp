@@ -4,6 +4,7 @@
 
 #include "cbase.h"
 #include "bots\bot.h"
+#include "bots\bot_manager.h"
 
 #ifdef INSOURCE_DLL
 #include "in_utils.h"
@@ -50,8 +51,12 @@ void CBot::SetState( BotState state, float duration )
     m_iState = state;
     m_iStateTimer.Invalidate();
 
+    TheBots->GetTimers()->Remove( m_hStateTimer );
+    m_hStateTimer = BOT_TIMER_INVALID;
+
     if ( duration > 0 ) {
         m_iStateTimer.Start( duration );
+        m_hStateTimer = TheBots->GetTimers()->Add( this, BOT_TIMER_STATE, 0, duration );
     }
 }
 
@@ -70,6 +75,45 @@ void CBot::CleanState()
     }
 }
 
+//================================================================================
+// A timer registered by the bot has expired (see CBotTimerWheel)
+//================================================================================
+void CBot::OnTimerExpired( BotTimerHandle handle, BotTimerType type, int param )
+{
+    switch ( type ) {
+        case BOT_TIMER_STATE:
+        {
+            if ( handle != m_hStateTimer )
+                return;
+
+            m_hStateTimer = BOT_TIMER_INVALID;
+            m_iStateTimer.Invalidate();
+
+            CleanState();
+            break;
+        }
+
+        case BOT_TIMER_SCHEDULE_WAIT:
+        {
+            IBotSchedule *pSchedule = GetSchedule( param );
+
+            if ( pSchedule )
+                pSchedule->OnWaitFinished( handle );
+
+            break;
+        }
+
+        case BOT_TIMER_DATA_MEMORY:
+        case BOT_TIMER_ENTITY_MEMORY:
+        {
+            if ( GetMemory() )
+                GetMemory()->OnTimerExpired( handle, type, param );
+
+            break;
+        }
+    }
+}
+
 //================================================================================
 // Put the bot in a state of panic where you can not do anything
 //================================================================================
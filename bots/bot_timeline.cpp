@@ -0,0 +1,189 @@
+//========= Copyright  1996-2005, Valve Corporation, All rights reserved. ============//
+// Authors: 
+// Ivn Bravo Bravo (linkedin.com/in/ivanbravobravo), 2017
+
+#include "cbase.h"
+#include "bots\bot_timeline.h"
+
+#include "bots\bot.h"
+#include "bots\bot_profiler.h"
+#include "filesystem.h"
+
+#ifdef INSOURCE_DLL
+#include "in_utils.h"
+#else
+#include "bots\in_utils.h"
+#endif
+
+// memdbgon must be the last include file in a .cpp file!!!
+#include "tier0/memdbgon.h"
+
+CBotTimeline g_BotTimeline;
+CBotTimeline *TheBotTimeline = &g_BotTimeline;
+
+//================================================================================
+//================================================================================
+CBotTimeline::CBotTimeline()
+{
+    m_bRecording = false;
+    m_flEndTime = 0.0f;
+    m_szFilename[0] = '\0';
+    m_iWrite = 0;
+}
+
+//================================================================================
+// Starts recording the events for [duration] seconds
+//================================================================================
+void CBotTimeline::Start( float duration, const char *pFilename )
+{
+    m_iWrite = 0;
+    m_flEndTime = TheBotWorld->GetTime() + duration;
+    Q_strncpy( m_szFilename, pFilename, sizeof( m_szFilename ) );
+
+    m_bRecording = true;
+    Msg( "Recording the timeline of the bots for %.1fs...\n", duration );
+}
+
+//================================================================================
+// Stops recording and writes the file
+//================================================================================
+void CBotTimeline::Stop()
+{
+    if ( !m_bRecording )
+        return;
+
+    m_bRecording = false;
+
+    CUtlBuffer buffer( 0, 0, CUtlBuffer::TEXT_BUFFER );
+    Write( buffer );
+
+    if ( filesystem->WriteFile( m_szFilename, "MOD", buffer ) )
+        Msg( "Timeline of the bots saved in %s (%i events)\n", m_szFilename, MIN( (int)m_iWrite, BOT_TIMELINE_EVENTS ) );
+    else
+        Warning( "The timeline could not be saved in %s\n", m_szFilename );
+}
+
+//================================================================================
+// Called at the end of each frame
+//================================================================================
+void CBotTimeline::Update()
+{
+    if ( !m_bRecording )
+        return;
+
+    if ( TheBotWorld->GetTime() >= m_flEndTime )
+        Stop();
+}
+
+//================================================================================
+// Adds an event for the bot that is being processed.
+// It can be called from any thread, each event gets its own slot.
+//================================================================================
+void CBotTimeline::AddEvent( const char *name, const char *category, bool begin )
+{
+    if ( !m_bRecording )
+        return;
+
+    int index = (++m_iWrite) - 1;
+    BotTimelineEvent_t &event = m_Events[ index % BOT_TIMELINE_EVENTS ];
+
+    event.name = name;
+    event.category = category;
+    event.timestamp = Plat_FloatTime();
+    event.bot = TheBotProfiler->GetCurrentBot();
+    event.begin = begin;
+}
+
+//================================================================================
+// Copies the text escaping the characters that are not valid inside a JSON string
+//================================================================================
+static void EscapeJSON( const char *pText, char *pResult, int size )
+{
+    int length = 0;
+
+    for ( ; *pText != '\0'; ++pText ) {
+        unsigned char c = (unsigned char)*pText;
+        char escaped[8];
+
+        if ( c == '"' || c == '\\' ) {
+            Q_snprintf( escaped, sizeof( escaped ), "\\%c", c );
+        }
+        else if ( c < 0x20 ) {
+            Q_snprintf( escaped, sizeof( escaped ), "\\u%04x", c );
+        }
+        else {
+            escaped[0] = c;
+            escaped[1] = '\0';
+        }
+
+        int escapedLength = Q_strlen( escaped );
+
+        if ( length + escapedLength >= size )
+            break;
+
+        Q_memcpy( pResult + length, escaped, escapedLength );
+        length += escapedLength;
+    }
+
+    pResult[length] = '\0';
+}
+
+//================================================================================
+// Writes the events in the Chrome trace format (JSON)
+// Each bot is a thread of the timeline.
+//================================================================================
+void CBotTimeline::Write( CUtlBuffer &buffer )
+{
+    int count = m_iWrite;
+    int first = MAX( 0, count - BOT_TIMELINE_EVENTS );
+
+    buffer.Printf( "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n" );
+
+    // Names of the bots
+    for ( int it = 1; it <= TheBotWorld->GetMaxPlayers(); ++it ) {
+        CPlayer *pPlayer = TheBotWorld->GetPlayer( it );
+
+        if ( !pPlayer || !pPlayer->IsBot() )
+            continue;
+
+        char name[MAX_PLAYER_NAME_LENGTH * 6];
+        EscapeJSON( pPlayer->GetPlayerName(), name, sizeof( name ) );
+
+        buffer.Printf( "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%i,\"args\":{\"name\":\"%s\"}},\n", it, name );
+    }
+
+    buffer.Printf( "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"Bot Manager\"}}" );
+
+    if ( count > 0 ) {
+        double start = m_Events[ first % BOT_TIMELINE_EVENTS ].timestamp;
+
+        for ( int it = first; it < count; ++it ) {
+            const BotTimelineEvent_t &event = m_Events[ it % BOT_TIMELINE_EVENTS ];
+            double us = (event.timestamp - start) * 1000000.0;
+
+            buffer.Printf( ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"%s\",\"ts\":%.3f,\"pid\":1,\"tid\":%i}", event.name, event.category, (event.begin) ? "B" : "E", us, MAX( event.bot, 0 ) );
+        }
+    }
+
+    buffer.Printf( "\n]}\n" );
+}
+
+//================================================================================
+//================================================================================
+CON_COMMAND_F( bot_trace_record, "Records the timeline of the bots and saves it in the Chrome trace format. Usage: bot_trace_record <seconds> [filename]", FCVAR_SERVER )
+{
+    if ( args.ArgC() < 2 ) {
+        Msg( "Usage: bot_trace_record <seconds> [filename]\n" );
+        return;
+    }
+
+    float duration = atof( args.Arg( 1 ) );
+
+    if ( duration <= 0.0f ) {
+        TheBotTimeline->Stop();
+        return;
+    }
+
+    const char *pFilename = (args.ArgC() > 2) ? args.Arg( 2 ) : "bot_timeline.json";
+    TheBotTimeline->Start( duration, pFilename );
+}
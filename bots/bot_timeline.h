@@ -0,0 +1,101 @@
+//========= Copyright  1996-2005, Valve Corporation, All rights reserved. ============//
+// Authors: 
+// Ivn Bravo Bravo (linkedin.com/in/ivanbravobravo), 2017
+
+#ifndef BOT_TIMELINE_H
+#define BOT_TIMELINE_H
+
+#ifdef _WIN32
+#pragma once
+#endif
+
+#include "tier0/threadtools.h"
+#include "utlbuffer.h"
+
+//================================================================================
+// Begin/End event of the timeline
+//================================================================================
+struct BotTimelineEvent_t
+{
+    // They must be static strings
+    const char *name;
+    const char *category;
+
+    double timestamp;
+    int bot;
+    bool begin;
+};
+
+//================================================================================
+// Records the order of the events inside the frames of the bots
+// and writes them in the Chrome trace format (chrome://tracing or Perfetto)
+// The events are saved in a ring buffer without locks, when it is full
+// the oldest events are overwritten.
+//================================================================================
+
+#define BOT_TIMELINE_EVENTS 65536
+
+class CBotTimeline
+{
+public:
+    CBotTimeline();
+
+    virtual bool IsRecording() const {
+        return m_bRecording;
+    }
+
+    virtual void Start( float duration, const char *pFilename );
+    virtual void Stop();
+    virtual void Update();
+
+    virtual void AddEvent( const char *name, const char *category, bool begin );
+
+    virtual void Write( CUtlBuffer &buffer );
+
+protected:
+    bool m_bRecording;
+    float m_flEndTime;
+    char m_szFilename[ MAX_PATH ];
+
+    CInterlockedInt m_iWrite;
+    BotTimelineEvent_t m_Events[ BOT_TIMELINE_EVENTS ];
+};
+
+extern CBotTimeline *TheBotTimeline;
+
+//================================================================================
+// Adds a begin event when created and an end event when destroyed
+//================================================================================
+class CBotTimelineScope
+{
+public:
+    CBotTimelineScope( const char *name, const char *category )
+    {
+        m_pName = NULL;
+
+        if ( !name || !TheBotTimeline->IsRecording() )
+            return;
+
+        m_pName = name;
+        m_pCategory = category;
+        TheBotTimeline->AddEvent( m_pName, m_pCategory, true );
+    }
+
+    ~CBotTimelineScope()
+    {
+        if ( m_pName )
+            TheBotTimeline->AddEvent( m_pName, m_pCategory, false );
+    }
+
+protected:
+    const char *m_pName;
+    const char *m_pCategory;
+};
+
+#define BOT_TIMELINE_CONCAT2( a, b ) a##b
+#define BOT_TIMELINE_CONCAT( a, b ) BOT_TIMELINE_CONCAT2( a, b )
+
+// [name] is only evaluated while recording, it can build the name
+#define BOT_TIMELINE_SCOPE( name, category ) CBotTimelineScope BOT_TIMELINE_CONCAT( timelineScope, __LINE__ )( (TheBotTimeline->IsRecording()) ? (name) : NULL, category )
+
+#endif // BOT_TIMELINE_H
@@ -0,0 +1,310 @@
+//========= Copyright  1996-2005, Valve Corporation, All rights reserved. ============//
+// Authors: 
+// Ivn Bravo Bravo (linkedin.com/in/ivanbravobravo), 2017
+
+#include "cbase.h"
+#include "bots\bot_timer_wheel.h"
+
+#include "bots\bot.h"
+#include "bots\bot_timeline.h"
+
+#ifdef INSOURCE_DLL
+#include "in_utils.h"
+#else
+#include "bots\in_utils.h"
+#endif
+
+// memdbgon must be the last include file in a .cpp file!!!
+#include "tier0/memdbgon.h"
+
+// Handle = serial (32 bits) | index + 1 (32 bits)
+#define BOT_TIMER_INDEX_BITS 32
+#define BOT_TIMER_INDEX_MASK 0xFFFFFFFFull
+#define BOT_TIMER_MAX_TIMERS 0x7FFFFFFF
+
+//================================================================================
+//================================================================================
+CBotTimerWheel::CBotTimerWheel()
+{
+    Clear();
+}
+
+//================================================================================
+// Forgets all the timers, the handles given until now are not valid anymore.
+// The timers are kept to not restart their serials, an old handle
+// must never match a timer that is added after the clear.
+//================================================================================
+void CBotTimerWheel::Clear()
+{
+    m_iCurrentTick = -1;
+    m_iCount = 0;
+
+    m_FreeTimers.RemoveAll();
+    m_Expired.RemoveAll();
+
+    FOR_EACH_VEC( m_Timers, it )
+    {
+        BotTimer_t &timer = m_Timers[it];
+
+        if ( timer.pending ) {
+            timer.pending = false;
+            timer.owner = NULL;
+            ++timer.serial;
+        }
+
+        timer.slot = -1;
+        timer.next = -1;
+        timer.prev = -1;
+
+        m_FreeTimers.AddToTail( it );
+    }
+
+    for ( int it = 0; it < ARRAYSIZE( m_Slots ); ++it ) {
+        m_Slots[it] = -1;
+    }
+}
+
+//================================================================================
+// Processes all the ticks until [tick] and notifies the expired timers
+//================================================================================
+void CBotTimerWheel::Advance( int tick )
+{
+    VPROF_BUDGET( "CBotTimerWheel::Advance", VPROF_BUDGETGROUP_BOTS );
+    BOT_TIMELINE_SCOPE( "CBotTimerWheel::Advance", "Manager" );
+
+    if ( m_iCurrentTick < 0 )
+        m_iCurrentTick = tick;
+
+    while ( m_iCurrentTick <= tick ) {
+        int index = m_iCurrentTick & BOT_TIMER_WHEEL_MASK;
+
+        // We have completed a turn of the lower level,
+        // the timers of the next slot of the upper levels go down.
+        if ( index == 0 ) {
+            for ( int level = 1; level < BOT_TIMER_WHEEL_LEVELS; ++level ) {
+                int slot = (m_iCurrentTick >> (BOT_TIMER_WHEEL_BITS * level)) & BOT_TIMER_WHEEL_MASK;
+                Cascade( level, slot );
+
+                if ( slot != 0 )
+                    break;
+            }
+        }
+
+        // We take the timers out of the slot before notifying them,
+        // the bots can add or remove timers while we are doing it.
+        m_Expired.RemoveAll();
+
+        for ( int it = m_Slots[index]; it != -1; it = m_Timers[it].next ) {
+            m_Timers[it].slot = -1;
+            m_Expired.AddToTail( GetHandle( it ) );
+        }
+
+        m_Slots[index] = -1;
+        ++m_iCurrentTick;
+
+        FOR_EACH_VEC( m_Expired, it )
+        {
+            BotTimerHandle handle = m_Expired[it];
+            int timer = GetIndex( handle );
+
+            // Removed by another timer of this tick
+            if ( timer == -1 )
+                continue;
+
+            CPlayer *pPlayer = ToInPlayer( m_Timers[timer].owner.Get() );
+            BotTimerType type = m_Timers[timer].type;
+            int param = m_Timers[timer].param;
+
+            Release( timer );
+
+            if ( !pPlayer || !pPlayer->GetBotController() )
+                continue;
+
+            pPlayer->GetBotController()->OnTimerExpired( handle, type, param );
+        }
+    }
+}
+
+//================================================================================
+// Registers a timer that will expire in [seconds]
+//================================================================================
+BotTimerHandle CBotTimerWheel::Add( IBot *pBot, BotTimerType type, int param, float seconds )
+{
+    Assert( pBot );
+
+    int index;
+
+    if ( m_FreeTimers.Count() > 0 ) {
+        index = m_FreeTimers.Tail();
+        m_FreeTimers.RemoveMultipleFromTail( 1 );
+    }
+    else {
+        if ( m_Timers.Count() >= BOT_TIMER_MAX_TIMERS ) {
+            AssertMsg( false, "Too many bot timers" );
+            return BOT_TIMER_INVALID;
+        }
+
+        index = m_Timers.AddToTail();
+        m_Timers[index].serial = 0;
+        m_Timers[index].pending = false;
+    }
+
+    int now = TheBotWorld->GetTickCount();
+    int ticks = MAX( 1, (int)ceil( seconds / TheBotWorld->GetTickInterval() ) );
+
+    if ( m_iCurrentTick < 0 )
+        m_iCurrentTick = now;
+
+    BotTimer_t &timer = m_Timers[index];
+    timer.expireTick = now + ticks;
+    timer.owner = pBot->GetHost();
+    timer.type = type;
+    timer.param = param;
+    timer.pending = true;
+
+    Link( index );
+    ++m_iCount;
+
+    return GetHandle( index );
+}
+
+//================================================================================
+// Removes the timer before it expires, invalid handles are ignored
+//================================================================================
+void CBotTimerWheel::Remove( BotTimerHandle handle )
+{
+    int index = GetIndex( handle );
+
+    if ( index == -1 )
+        return;
+
+    if ( m_Timers[index].slot != -1 )
+        Unlink( index );
+
+    Release( index );
+}
+
+//================================================================================
+//================================================================================
+bool CBotTimerWheel::IsPending( BotTimerHandle handle ) const
+{
+    return (GetIndex( handle ) != -1);
+}
+
+//================================================================================
+// Puts the timer in the slot that corresponds to its expiration
+//================================================================================
+void CBotTimerWheel::Link( int index )
+{
+    BotTimer_t &timer = m_Timers[index];
+
+    int delta = timer.expireTick - m_iCurrentTick;
+    int slot;
+
+    if ( delta < 0 ) {
+        // Expired, it will be notified in the next tick we process
+        slot = m_iCurrentTick & BOT_TIMER_WHEEL_MASK;
+    }
+    else {
+        int level = 0;
+
+        while ( level < BOT_TIMER_WHEEL_LEVELS - 1 && delta >= (1 << (BOT_TIMER_WHEEL_BITS * (level + 1))) ) {
+            ++level;
+        }
+
+        // Beyond the range of the wheel
+        if ( delta >= (1 << (BOT_TIMER_WHEEL_BITS * BOT_TIMER_WHEEL_LEVELS)) ) {
+            timer.expireTick = m_iCurrentTick + (1 << (BOT_TIMER_WHEEL_BITS * BOT_TIMER_WHEEL_LEVELS)) - 1;
+        }
+
+        slot = (level * BOT_TIMER_WHEEL_SLOTS) + ((timer.expireTick >> (BOT_TIMER_WHEEL_BITS * level)) & BOT_TIMER_WHEEL_MASK);
+    }
+
+    timer.slot = slot;
+    timer.prev = -1;
+    timer.next = m_Slots[slot];
+
+    if ( timer.next != -1 )
+        m_Timers[timer.next].prev = index;
+
+    m_Slots[slot] = index;
+}
+
+//================================================================================
+//================================================================================
+void CBotTimerWheel::Unlink( int index )
+{
+    BotTimer_t &timer = m_Timers[index];
+    Assert( timer.slot != -1 );
+
+    if ( timer.prev != -1 )
+        m_Timers[timer.prev].next = timer.next;
+    else
+        m_Slots[timer.slot] = timer.next;
+
+    if ( timer.next != -1 )
+        m_Timers[timer.next].prev = timer.prev;
+
+    timer.slot = -1;
+    timer.next = -1;
+    timer.prev = -1;
+}
+
+//================================================================================
+// The timer can be reused, its handle is no longer valid
+//================================================================================
+void CBotTimerWheel::Release( int index )
+{
+    BotTimer_t &timer = m_Timers[index];
+    Assert( timer.pending );
+
+    timer.pending = false;
+    timer.owner = NULL;
+    ++timer.serial;
+
+    m_FreeTimers.AddToTail( index );
+    --m_iCount;
+}
+
+//================================================================================
+// Moves the timers of a slot of an upper level to the lower levels
+//================================================================================
+void CBotTimerWheel::Cascade( int level, int slot )
+{
+    int first = (level * BOT_TIMER_WHEEL_SLOTS) + slot;
+    int it = m_Slots[first];
+
+    m_Slots[first] = -1;
+
+    while ( it != -1 ) {
+        int next = m_Timers[it].next;
+        Link( it );
+        it = next;
+    }
+}
+
+//================================================================================
+//================================================================================
+BotTimerHandle CBotTimerWheel::GetHandle( int index ) const
+{
+    return ((BotTimerHandle)m_Timers[index].serial << BOT_TIMER_INDEX_BITS) | (BotTimerHandle)(index + 1);
+}
+
+//================================================================================
+// Returns the index of the timer, -1 if the handle is not pending
+//================================================================================
+int CBotTimerWheel::GetIndex( BotTimerHandle handle ) const
+{
+    if ( handle == BOT_TIMER_INVALID )
+        return -1;
+
+    int64 index = (int64)(handle & BOT_TIMER_INDEX_MASK) - 1;
+
+    if ( index < 0 || index >= m_Timers.Count() )
+        return -1;
+
+    if ( !m_Timers[index].pending || GetHandle( (int)index ) != handle )
+        return -1;
+
+    return (int)index;
+}
@@ -0,0 +1,96 @@
+//========= Copyright  1996-2005, Valve Corporation, All rights reserved. ============//
+// Authors: 
+// Ivn Bravo Bravo (linkedin.com/in/ivanbravobravo), 2017
+
+#ifndef BOT_TIMER_WHEEL_H
+#define BOT_TIMER_WHEEL_H
+
+#ifdef _WIN32
+#pragma once
+#endif
+
+#include "bots\bot_defs.h"
+
+class IBot;
+
+// Each level of the wheel has 64 slots, 4 levels cover 2^24 ticks
+#define BOT_TIMER_WHEEL_BITS 6
+#define BOT_TIMER_WHEEL_SLOTS (1 << BOT_TIMER_WHEEL_BITS)
+#define BOT_TIMER_WHEEL_MASK (BOT_TIMER_WHEEL_SLOTS - 1)
+#define BOT_TIMER_WHEEL_LEVELS 4
+
+//================================================================================
+// Timer registered in the wheel
+//================================================================================
+struct BotTimer_t
+{
+    // Tick in which the timer expires
+    int expireTick;
+
+    // Bot that will be notified
+    CHandle<CBasePlayer> owner;
+
+    BotTimerType type;
+    int param;
+
+    // Increases every time the timer is released, the handles of the
+    // released timers are not valid anymore.
+    uint32 serial;
+    bool pending;
+
+    // Links of the slot list, [slot] is -1 when the timer is not linked
+    int slot;
+    int next;
+    int prev;
+};
+
+//================================================================================
+// Hierarchical timer wheel shared by all the bots.
+// The components register expirations (data memory, entity memory,
+// state duration, schedule waits...) instead of checking them every tick,
+// each tick only the slot of the tick is visited and the timers of the
+// upper levels are moved down when their slot is reached.
+// When a timer expires the bot is notified through IBot::OnTimerExpired,
+// the bot must check that the handle is still the one it is waiting for.
+//================================================================================
+class CBotTimerWheel
+{
+public:
+    CBotTimerWheel();
+
+    virtual void Clear();
+    virtual void Advance( int tick );
+
+    virtual BotTimerHandle Add( IBot *pBot, BotTimerType type, int param, float seconds );
+    virtual void Remove( BotTimerHandle handle );
+    virtual bool IsPending( BotTimerHandle handle ) const;
+
+    virtual int GetCount() const {
+        return m_iCount;
+    }
+
+protected:
+    virtual void Link( int index );
+    virtual void Unlink( int index );
+    virtual void Release( int index );
+    virtual void Cascade( int level, int slot );
+
+    virtual BotTimerHandle GetHandle( int index ) const;
+    virtual int GetIndex( BotTimerHandle handle ) const;
+
+protected:
+    // Next tick to process
+    int m_iCurrentTick;
+    int m_iCount;
+
+    CUtlVector<BotTimer_t> m_Timers;
+    CUtlVector<int> m_FreeTimers;
+
+    // First timer of each slot
+    int m_Slots[BOT_TIMER_WHEEL_LEVELS * BOT_TIMER_WHEEL_SLOTS];
+
+    // Reused in each tick to avoid allocating memory
+    CUtlVector<BotTimerHandle> m_Expired;
+};
+
+#endif // BOT_TIMER_WHEEL_H
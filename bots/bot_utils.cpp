@@ -7,6 +7,9 @@
 
 #include "bots\bot_defs.h"
 #include "bots\bot.h"
+#include "bots\bot_manager.h"
+
+#include "collisionutils.h"
 
 #ifdef INSOURCE_DLL
 #include "in_utils.h"
@@ -19,19 +22,74 @@
 // memdbgon must be the last include file in a .cpp file!!!
 #include "tier0/memdbgon.h"
 
+extern ConVar bot_debug_memory;
+
+DECLARE_REPLICATED_COMMAND( bot_hitbox_early_exit, "1", "Indicates if the bots stop checking the hitboxes of their enemy when they find one that they can aim at." )
+DECLARE_REPLICATED_COMMAND( bot_los_cache, "1", "Indicates if the bots can reuse the answers of the line of sight checks of the previous ticks." )
+DECLARE_REPLICATED_COMMAND( bot_los_cache_tolerance, "8", "Distance that the eyes of the bot or its target can move before the line of sight is checked again." )
+DECLARE_REPLICATED_COMMAND( bot_los_cache_max_age, "0.5", "Maximum time in seconds that an answer of the line of sight cache is used." )
+
 //================================================================================
 //================================================================================
 CEntityMemory::CEntityMemory( IBot *pBot, CBaseEntity *pEntity, CBaseEntity *pInformer )
+{
+    m_iGeneration = 0;
+    m_hLostTimer = BOT_TIMER_INVALID;
+    Init( pBot, pEntity, pInformer );
+}
+
+//================================================================================
+// Prepares the memory for a new entity
+// The records are reused by the memory component (see IBotMemory)
+//================================================================================
+void CEntityMemory::Init( IBot *pBot, CBaseEntity *pEntity, CBaseEntity *pInformer )
 {
     m_hEntity = pEntity;
     m_hInformer = pInformer;
+    m_iEntityIndex = (pEntity) ? pEntity->entindex() : -1;
+    ++m_iGeneration;
+    StopTimers();
     m_vecLastPosition.Invalidate();
+    m_vecIdealPosition.Invalidate();
+    m_Hitbox.Reset();
+    m_VisibleHitbox.Reset();
+    m_iProbedHitboxes = 0;
+    m_iLastVisibleHitbox = HITGROUP_GENERIC;
     m_bVisible = false;
     m_LastVisible.Invalidate();
     m_LastUpdate.Invalidate();
+    m_flFrameLastUpdate = -1.0f;
     m_pBot = pBot;
 }
 
+//================================================================================
+//================================================================================
+void CEntityMemory::UpdatePosition( const Vector &pos )
+{
+    m_vecLastPosition = pos;
+    m_vecIdealPosition = pos;
+    m_LastUpdate.Start();
+
+    // The memory was lost, we start counting again
+    if ( m_hLostTimer == BOT_TIMER_INVALID ) {
+        m_hLostTimer = TheBots->GetTimers()->Add( m_pBot, BOT_TIMER_ENTITY_MEMORY, m_iEntityIndex, GetTimeLeft() );
+    }
+
+    m_pBot->GetMemory()->SyncEntityMemory( this );
+}
+
+//================================================================================
+//================================================================================
+void CEntityMemory::UpdateVisibility( bool visible )
+{
+    m_bVisible = visible;
+
+    if ( visible ) {
+        m_LastVisible.Start();
+        m_pBot->GetMemory()->SyncEntityMemory( this );
+    }
+}
+
 //================================================================================
 // Returns the amount of time left before this memory is considered lost.
 //================================================================================
@@ -50,7 +108,38 @@ bool CEntityMemory::IsLost()
     if ( GetEntity() == NULL || GetEntity()->IsMarkedForDeletion() || !GetEntity()->IsAlive() )
         return true;
 
-    return (GetTimeLeft() <= 0);
+    return (m_hLostTimer == BOT_TIMER_INVALID);
+}
+
+//================================================================================
+// The time limit of our memory has been reached.
+// The timer is not moved in each update, if we have received
+// an update since then we wait for the time that is left.
+//================================================================================
+void CEntityMemory::OnTimerExpired( BotTimerHandle handle )
+{
+    if ( handle != m_hLostTimer )
+        return;
+
+    m_hLostTimer = BOT_TIMER_INVALID;
+
+    float timeLeft = GetTimeLeft();
+
+    if ( timeLeft > 0.0f ) {
+        m_hLostTimer = TheBots->GetTimers()->Add( m_pBot, BOT_TIMER_ENTITY_MEMORY, m_iEntityIndex, timeLeft );
+        return;
+    }
+
+    // The memory is lost, the queries must stop counting it
+    m_pBot->GetMemory()->SyncEntityMemory( this );
+}
+
+//================================================================================
+//================================================================================
+void CEntityMemory::StopTimers()
+{
+    TheBots->GetTimers()->Remove( m_hLostTimer );
+    m_hLostTimer = BOT_TIMER_INVALID;
 }
 
 //================================================================================
@@ -79,6 +168,15 @@ bool CEntityMemory::IsHitboxVisible( HitboxType part )
     return false;
 }
 
+//================================================================================
+// Returns whether the hitbox was traced in the last update,
+// a hitbox that was not traced is not visible but could be.
+//================================================================================
+bool CEntityMemory::IsHitboxProbed( HitboxType part ) const
+{
+    return (m_iProbedHitboxes & (1 << part)) != 0;
+}
+
 //================================================================================
 //================================================================================
 float CEntityMemory::GetDistance() const
@@ -171,38 +269,311 @@ bool CEntityMemory::GetVisibleHitboxPosition( Vector & vecPosition, HitboxType f
 
 //================================================================================
 // Update hitbox positions and visibility
+// We only need one hitbox to aim, so we try the favorite hitbox, then the
+// hitbox that was visible in the previous update and finally the rest
+// in the order of GetVisibleHitboxPosition, stopping at the first visible one.
 //================================================================================
 void CEntityMemory::UpdateHitboxAndVisibility()
 {
     UpdateVisibility( false );
     m_Hitbox.Reset();
     m_VisibleHitbox.Reset();
+    m_iProbedHitboxes = 0;
 
-    Utils::GetHitboxPositions( GetEntity(), m_Hitbox );
+    // The positions were already calculated in the perception stage of this frame
+    if ( !m_pBot->GetPerception()->GetHitbox( GetEntity(), m_Hitbox ) ) {
+        TheBots->GetEntityHitbox( GetEntity(), m_Hitbox, m_pBot->ShouldAimWithBones( GetDistance() ) );
+    }
 
-    if ( !m_Hitbox.IsValid() )
+    if ( !m_Hitbox.IsValid() ) {
+        m_iLastVisibleHitbox = HITGROUP_GENERIC;
         return;
+    }
+
+    HitboxType favorite = m_pBot->GetProfile()->GetFavoriteHitbox();
+    HitboxType probes[] = { favorite, m_iLastVisibleHitbox, HITGROUP_CHEST, HITGROUP_HEAD, HITGROUP_LEFTLEG, HITGROUP_RIGHTLEG };
+
+    // The debug output needs all the hitboxes
+    bool fullScan = (!bot_hitbox_early_exit.GetBool() || bot_debug_memory.GetBool());
+    m_iLastVisibleHitbox = HITGROUP_GENERIC;
+
+    for ( int it = 0; it < ARRAYSIZE( probes ); ++it ) {
+        HitboxType part = probes[it];
+
+        // No hitbox was visible in the previous update
+        if ( part == HITGROUP_GENERIC && it == 1 )
+            continue;
+
+        // Any other group is the chest (see HitboxPositions::Get)
+        if ( part != HITGROUP_HEAD && part != HITGROUP_LEFTLEG && part != HITGROUP_RIGHTLEG )
+            part = HITGROUP_CHEST;
 
-    if ( m_pBot->GetDecision()->IsAbleToSee( m_Hitbox.head ) ) {
-        m_VisibleHitbox.head = m_Hitbox.head;
+        if ( IsHitboxProbed( part ) )
+            continue;
+
+        m_iProbedHitboxes |= (1 << part);
+
+        if ( !m_pBot->GetDecision()->IsAbleToSee( m_Hitbox.Get( part ) ) )
+            continue;
+
+        m_VisibleHitbox.Get( part ) = m_Hitbox.Get( part );
         UpdateVisibility( true );
+
+        if ( m_iLastVisibleHitbox == HITGROUP_GENERIC )
+            m_iLastVisibleHitbox = part;
+
+        if ( !fullScan )
+            break;
     }
 
-    if ( m_pBot->GetDecision()->IsAbleToSee( m_Hitbox.chest ) ) {
-        m_VisibleHitbox.chest = m_Hitbox.chest;
-        UpdateVisibility( true );
+    // We update the ideal position
+    GetVisibleHitboxPosition( m_vecIdealPosition, favorite );
+}
+
+//================================================================================
+// Removes the queries of the previous frame
+//================================================================================
+void CBotPerception::Clear()
+{
+    // RemoveAll keeps the memory so we do not allocate again in the next frame
+    m_Requests.RemoveAll();
+    m_hHitboxEntity = NULL;
+    m_Hitbox.Reset();
+    m_iTick = TheBotWorld->GetTickCount();
+
+    // The stats are of this frame
+    m_iHits = 0;
+    m_iMisses = 0;
+}
+
+//================================================================================
+// Posts a line trace that will be executed before the bot runs its A.I.
+//================================================================================
+void CBotPerception::AddQuery( int type, CBaseEntity *pHost, const Vector &vecStart, const Vector &vecEnd, CBaseEntity *pIgnore )
+{
+    if ( FindQuery( type, vecStart, vecEnd ) != -1 )
+        return;
+
+    BotVisibilityHandle handle = TheBotVisibility->Post( type, pHost, vecStart, vecEnd, pIgnore );
+
+    if ( handle == BOT_VISIBILITY_INVALID )
+        return;
+
+    int index = m_Requests.AddToTail();
+    PerceptionRequest_t &request = m_Requests[index];
+
+    request.type = type;
+    request.vecStart = vecStart;
+    request.vecEnd = vecEnd;
+    request.handle = handle;
+}
+
+//================================================================================
+//================================================================================
+int CBotPerception::FindQuery( int type, const Vector &vecStart, const Vector &vecEnd ) const
+{
+    FOR_EACH_VEC( m_Requests, it )
+    {
+        const PerceptionRequest_t &request = m_Requests[it];
+
+        if ( request.type != type )
+            continue;
+
+        if ( request.vecEnd != vecEnd || request.vecStart != vecStart )
+            continue;
+
+        return it;
     }
 
-    if ( m_pBot->GetDecision()->IsAbleToSee( m_Hitbox.leftLeg ) ) {
-        m_VisibleHitbox.leftLeg = m_Hitbox.leftLeg;
-        UpdateVisibility( true );
+    return -1;
+}
+
+//================================================================================
+// Returns the result of a trace that was executed in this frame
+// or NULL if we need to do the trace ourselves.
+// Only the queries that were posted count as a miss.
+//================================================================================
+const PerceptionQuery_t *CBotPerception::GetResult( int type, const Vector &vecStart, const Vector &vecEnd )
+{
+    if ( !IsCurrent() )
+        return NULL;
+
+    int index = FindQuery( type, vecStart, vecEnd );
+
+    if ( index == -1 )
+        return NULL;
+
+    const PerceptionQuery_t *query = TheBotVisibility->Resolve( m_Requests[index].handle );
+
+    if ( query == NULL ) {
+        ++m_iMisses;
+        return NULL;
     }
 
-    if ( m_pBot->GetDecision()->IsAbleToSee( m_Hitbox.rightLeg ) ) {
-        m_VisibleHitbox.rightLeg = m_Hitbox.rightLeg;
-        UpdateVisibility( true );
+    ++m_iHits;
+    return query;
+}
+
+//================================================================================
+//================================================================================
+void CBotPerception::SetHitbox( CBaseEntity *pEntity, const HitboxPositions &positions )
+{
+    m_hHitboxEntity = pEntity;
+    m_Hitbox = positions;
+}
+
+//================================================================================
+//================================================================================
+bool CBotPerception::GetHitbox( CBaseEntity *pEntity, HitboxPositions &positions ) const
+{
+    if ( !IsCurrent() )
+        return false;
+
+    if ( pEntity == NULL || m_hHitboxEntity.Get() != pEntity )
+        return false;
+
+    positions = m_Hitbox;
+    return true;
+}
+
+//================================================================================
+//================================================================================
+void CBotSightCache::Reset()
+{
+    for ( int it = 0; it < BOT_SIGHT_CACHE_SIZE; ++it ) {
+        m_Entries[it].used = false;
+        m_Entries[it].target = NULL;
+        m_Entries[it].hit = NULL;
     }
 
-    // We update the ideal position
-    GetVisibleHitboxPosition( m_vecIdealPosition, m_pBot->GetProfile()->GetFavoriteHitbox() );
-}
\ No newline at end of file
+    m_iHits = 0;
+    m_iMisses = 0;
+    m_iInvalidations = 0;
+}
+
+//================================================================================
+// Returns the previous answer if it is still valid
+//================================================================================
+bool CBotSightCache::Find( int type, CBaseEntity *pTarget, const Vector &vecEye, const Vector &vecTarget, bool &clear, CBaseEntity **hit )
+{
+    if ( !bot_los_cache.GetBool() )
+        return false;
+
+    float tolerance = bot_los_cache_tolerance.GetFloat();
+
+    int cell[3];
+    Bot_SnapPosition( vecTarget, tolerance, cell );
+
+    int index = FindEntry( type, pTarget, cell );
+
+    if ( index == -1 ) {
+        ++m_iMisses;
+        return false;
+    }
+
+    BotSightEntry_t &entry = m_Entries[index];
+    float toleranceSqr = tolerance * tolerance;
+
+    bool valid = (entry.serial == TheBots->GetSightSerial());
+    valid = valid && (TheBotWorld->GetTime() - entry.time) <= bot_los_cache_max_age.GetFloat();
+    valid = valid && entry.vecEye.DistToSqr( vecEye ) <= toleranceSqr;
+    valid = valid && entry.vecTarget.DistToSqr( vecTarget ) <= toleranceSqr;
+
+    if ( !valid ) {
+        entry.used = false;
+        ++m_iInvalidations;
+        ++m_iMisses;
+        return false;
+    }
+
+    ++m_iHits;
+    clear = entry.clear;
+
+    if ( hit ) *hit = entry.hit.Get();
+    return true;
+}
+
+//================================================================================
+// Saves the answer of a check, replacing the oldest one if there is no room
+//================================================================================
+void CBotSightCache::Store( int type, CBaseEntity *pTarget, const Vector &vecEye, const Vector &vecTarget, bool clear, CBaseEntity *hit )
+{
+    if ( !bot_los_cache.GetBool() )
+        return;
+
+    int cell[3];
+    Bot_SnapPosition( vecTarget, bot_los_cache_tolerance.GetFloat(), cell );
+
+    int index = FindEntry( type, pTarget, cell );
+
+    if ( index == -1 ) {
+        for ( int it = 0; it < BOT_SIGHT_CACHE_SIZE; ++it ) {
+            if ( !m_Entries[it].used ) {
+                index = it;
+                break;
+            }
+
+            if ( index == -1 || m_Entries[it].time < m_Entries[index].time )
+                index = it;
+        }
+    }
+
+    BotSightEntry_t &entry = m_Entries[index];
+    entry.used = true;
+    entry.type = type;
+    entry.target = pTarget;
+    entry.cell[0] = cell[0];
+    entry.cell[1] = cell[1];
+    entry.cell[2] = cell[2];
+    entry.vecEye = vecEye;
+    entry.vecTarget = vecTarget;
+    entry.time = TheBotWorld->GetTime();
+    entry.serial = TheBots->GetSightSerial();
+    entry.clear = clear;
+    entry.hit = hit;
+}
+
+//================================================================================
+// Forgets the answers whose line crosses the bounds
+//================================================================================
+void CBotSightCache::Invalidate( const Vector &mins, const Vector &maxs )
+{
+    float tolerance = bot_los_cache_tolerance.GetFloat();
+
+    for ( int it = 0; it < BOT_SIGHT_CACHE_SIZE; ++it ) {
+        BotSightEntry_t &entry = m_Entries[it];
+
+        if ( !entry.used )
+            continue;
+
+        if ( !IsBoxIntersectingRay( mins, maxs, entry.vecEye, entry.vecTarget - entry.vecEye, tolerance ) )
+            continue;
+
+        entry.used = false;
+        ++m_iInvalidations;
+    }
+}
+
+//================================================================================
+// Checks of an entity are found by the entity, checks of a position
+// are found by the cell of the position.
+//================================================================================
+int CBotSightCache::FindEntry( int type, CBaseEntity *pTarget, const int *cell ) const
+{
+    for ( int it = 0; it < BOT_SIGHT_CACHE_SIZE; ++it ) {
+        const BotSightEntry_t &entry = m_Entries[it];
+
+        if ( !entry.used || entry.type != type )
+            continue;
+
+        if ( entry.target.Get() != pTarget )
+            continue;
+
+        if ( pTarget == NULL && (entry.cell[0] != cell[0] || entry.cell[1] != cell[1] || entry.cell[2] != cell[2]) )
+            continue;
+
+        return it;
+    }
+
+    return -1;
+}
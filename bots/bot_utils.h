@@ -14,6 +14,7 @@
 #endif
 
 #include "bots\bot_defs.h"
+#include "bots\bot_visibility.h"
 
 #ifdef time
 #undef time
@@ -31,10 +32,21 @@ public:
 
     CEntityMemory( IBot *pBot, CBaseEntity *pEntity, CBaseEntity *pInformer = NULL );
 
+    virtual void Init( IBot *pBot, CBaseEntity *pEntity, CBaseEntity *pInformer = NULL );
+
     virtual CBaseEntity *GetEntity() const {
         return m_hEntity.Get();
     }
 
+    virtual int GetEntityIndex() const {
+        return m_iEntityIndex;
+    }
+
+    // Increases every time the record is reused for another entity
+    virtual int GetGeneration() const {
+        return m_iGeneration;
+    }
+
     virtual bool Is( CBaseEntity *pEntity ) const {
         return (GetEntity() == pEntity);
     }
@@ -47,24 +59,14 @@ public:
         m_hInformer = pInformer;
     }
 
-    virtual void UpdatePosition( const Vector &pos ) {
-        m_vecLastPosition = pos;
-        m_vecIdealPosition = pos;
-        m_LastUpdate.Start();
-    }
+    virtual void UpdatePosition( const Vector &pos );
 
     // Visibility
     virtual bool IsVisible() const {
         return m_bVisible;
     }
 
-    virtual void UpdateVisibility( bool visible ) {
-        m_bVisible = visible;
-
-        if ( visible ) {
-            m_LastVisible.Start();
-        }
-    }
+    virtual void UpdateVisibility( bool visible );
 
     virtual bool IsVisibleRecently( float seconds ) const {
         return m_LastVisible.IsLessThen( seconds );
@@ -115,6 +117,9 @@ public:
     virtual float GetTimeLeft();
     virtual bool IsLost();
 
+    virtual void OnTimerExpired( BotTimerHandle handle );
+    virtual void StopTimers();
+
     virtual const HitboxPositions GetHitbox() const {
         return m_Hitbox;
     }
@@ -124,9 +129,14 @@ public:
     }
 
     virtual bool IsHitboxVisible( HitboxType part );
+    virtual bool IsHitboxProbed( HitboxType part ) const;
+
+    virtual HitboxType GetLastVisibleHitbox() const {
+        return m_iLastVisibleHitbox;
+    }
 
     virtual CNavArea *GetLastKnownArea() const {
-        return TheNavMesh->GetNearestNavArea( m_vecLastPosition );
+        return TheBotWorld->GetNearestNavArea( m_vecLastPosition );
     }
 
     virtual float GetDistance() const;
@@ -150,6 +160,12 @@ protected:
     EHANDLE m_hEntity;
     EHANDLE m_hInformer;
 
+    int m_iEntityIndex;
+    int m_iGeneration;
+
+    // Pending while the memory is not lost
+    BotTimerHandle m_hLostTimer;
+
     IBot *m_pBot;
 
     Vector m_vecLastPosition;
@@ -158,6 +174,11 @@ protected:
     HitboxPositions m_Hitbox;
     HitboxPositions m_VisibleHitbox;
 
+    // Hitboxes traced in the last update (one bit per hitbox group)
+    // and the first one that was visible, it is tried first in the next update.
+    int m_iProbedHitboxes;
+    HitboxType m_iLastVisibleHitbox;
+
     bool m_bVisible;
 
     IntervalTimer m_LastVisible;
@@ -176,26 +197,38 @@ public:
 
     CDataMemory() : BaseClass()
     {
+        m_flForget = -1.0f;
+        m_hExpireTimer = BOT_TIMER_INVALID;
     }
 
     CDataMemory( int value ) : BaseClass( value )
     {
+        m_flForget = -1.0f;
+        m_hExpireTimer = BOT_TIMER_INVALID;
     }
 
     CDataMemory( Vector value ) : BaseClass( value )
     {
+        m_flForget = -1.0f;
+        m_hExpireTimer = BOT_TIMER_INVALID;
     }
 
     CDataMemory( float value ) : BaseClass( value )
     {
+        m_flForget = -1.0f;
+        m_hExpireTimer = BOT_TIMER_INVALID;
     }
 
     CDataMemory( const char *value ) : BaseClass( value )
     {
+        m_flForget = -1.0f;
+        m_hExpireTimer = BOT_TIMER_INVALID;
     }
 
     CDataMemory( CBaseEntity *value ) : BaseClass( value )
     {
+        m_flForget = -1.0f;
+        m_hExpireTimer = BOT_TIMER_INVALID;
     }
 
     virtual void Reset() {
@@ -203,13 +236,19 @@ public:
 
         m_LastUpdate.Invalidate();
         m_flForget = -1.0f;
+        m_hExpireTimer = BOT_TIMER_INVALID;
     }
 
     virtual void OnSet() {
         m_LastUpdate.Start();
     }
 
-    bool IsExpired() {
+    // Returns if a value has been saved since the last reset
+    bool IsSet() const {
+        return m_LastUpdate.HasStarted();
+    }
+
+    bool IsExpired() const {
         // Never expires
         if ( m_flForget <= 0.0f )
             return false;
@@ -232,9 +271,162 @@ public:
         m_flForget = time;
     }
 
+    // Timer that will forget the memory (see CBotMemory::SetExpiration)
+    BotTimerHandle GetExpireTimer() const {
+        return m_hExpireTimer;
+    }
+
+    void SetExpireTimer( BotTimerHandle handle ) {
+        m_hExpireTimer = handle;
+    }
+
 protected:
     IntervalTimer m_LastUpdate;
     float m_flForget;
+    BotTimerHandle m_hExpireTimer;
+};
+
+//================================================================================
+// Line traces that a bot needs in this frame.
+// They are posted to the visibility service (see CBotVisibility) before the
+// bot runs its A.I., the bot keeps the handles to read the results.
+//================================================================================
+struct PerceptionRequest_t
+{
+    int type;
+
+    Vector vecStart;
+    Vector vecEnd;
+
+    BotVisibilityHandle handle;
+};
+
+class CBotPerception
+{
+public:
+    DECLARE_CLASS_NOBASE( CBotPerception );
+
+    CBotPerception()
+    {
+        m_iTick = -1;
+        m_iHits = 0;
+        m_iMisses = 0;
+        m_Hitbox.Reset();
+    }
+
+    virtual void Clear();
+
+    virtual void AddQuery( int type, CBaseEntity *pHost, const Vector &vecStart, const Vector &vecEnd, CBaseEntity *pIgnore = NULL );
+    virtual const PerceptionQuery_t *GetResult( int type, const Vector &vecStart, const Vector &vecEnd );
+
+    virtual void SetHitbox( CBaseEntity *pEntity, const HitboxPositions &positions );
+    virtual bool GetHitbox( CBaseEntity *pEntity, HitboxPositions &positions ) const;
+
+    virtual bool IsCurrent() const {
+        return (m_iTick == TheBotWorld->GetTickCount());
+    }
+
+    virtual int GetCount() const {
+        return m_Requests.Count();
+    }
+
+    virtual int GetHits() const {
+        return m_iHits;
+    }
+
+    virtual int GetMisses() const {
+        return m_iMisses;
+    }
+
+protected:
+    virtual int FindQuery( int type, const Vector &vecStart, const Vector &vecEnd ) const;
+
+protected:
+    CUtlVector<PerceptionRequest_t> m_Requests;
+
+    EHANDLE m_hHitboxEntity;
+    HitboxPositions m_Hitbox;
+
+    int m_iTick;
+    int m_iHits;
+    int m_iMisses;
+};
+
+//================================================================================
+// Answer of a visibility or line of fire check
+//================================================================================
+#define BOT_SIGHT_CACHE_SIZE 16
+
+struct BotSightEntry_t
+{
+    bool used;
+    int type;
+
+    // Target of the check, when there is none the entry
+    // is found by the snapped position of the target.
+    EHANDLE target;
+    int cell[3];
+
+    // Ends of the line when it was checked
+    Vector vecEye;
+    Vector vecTarget;
+
+    float time;
+    int serial;
+
+    bool clear;
+    EHANDLE hit;
+};
+
+//================================================================================
+// Line of sight between a bot and its targets rarely changes from one tick
+// to the next when neither of them moves, the answers are kept until
+// one of the ends moves too much, they are too old or a door or breakable
+// of the map that crosses the line changes (see CBotManager::UpdateSightBlockers)
+// The line of fire is not cached, the players and NPCs that cross it move every tick.
+//================================================================================
+class CBotSightCache
+{
+public:
+    DECLARE_CLASS_NOBASE( CBotSightCache );
+
+    CBotSightCache()
+    {
+        Reset();
+    }
+
+    virtual void Reset();
+
+    virtual bool Find( int type, CBaseEntity *pTarget, const Vector &vecEye, const Vector &vecTarget, bool &clear, CBaseEntity **hit = NULL );
+    virtual void Store( int type, CBaseEntity *pTarget, const Vector &vecEye, const Vector &vecTarget, bool clear, CBaseEntity *hit = NULL );
+    virtual void Invalidate( const Vector &mins, const Vector &maxs );
+
+    virtual int GetHits() const {
+        return m_iHits;
+    }
+
+    virtual int GetMisses() const {
+        return m_iMisses;
+    }
+
+    virtual int GetInvalidations() const {
+        return m_iInvalidations;
+    }
+
+    virtual float GetHitRate() const {
+        int total = m_iHits + m_iMisses;
+        return (total > 0) ? ((float)m_iHits / (float)total) : 0.0f;
+    }
+
+protected:
+    virtual int FindEntry( int type, CBaseEntity *pTarget, const int *cell ) const;
+
+protected:
+    BotSightEntry_t m_Entries[BOT_SIGHT_CACHE_SIZE];
+
+    int m_iHits;
+    int m_iMisses;
+    int m_iInvalidations;
 };
 
 //================================================================================
@@ -347,6 +539,16 @@ public:
         m_flReactionDelay = delay;
     }
 
+    // Beyond this distance the bot aims to positions calculated from
+    // the bounds of the target instead of its bones (0 = Always bones)
+    virtual float GetHitboxBonesDistance() {
+        return m_flHitboxBonesDistance;
+    }
+
+    virtual void SetHitboxBonesDistance( float distance ) {
+        m_flHitboxBonesDistance = distance;
+    }
+
 protected:
     int m_iSkillLevel;
     float m_flMemoryDuration;
@@ -354,6 +556,7 @@ protected:
     float m_flAlertDuration;
     float m_flAggression;
     float m_flReactionDelay;
+    float m_flHitboxBonesDistance;
 
     int m_iMinAimSpeed;
     int m_iMaxAimSpeed;
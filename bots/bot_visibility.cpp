@@ -0,0 +1,368 @@
+//========= Copyright  1996-2005, Valve Corporation, All rights reserved. ============//
+// Authors: 
+// Ivn Bravo Bravo (linkedin.com/in/ivanbravobravo), 2017
+
+#include "cbase.h"
+#include "bots\bot_visibility.h"
+
+#include "bots\bot_profiler.h"
+#include "bots\bot_timeline.h"
+
+#include "vstdlib/jobthread.h"
+
+// memdbgon must be the last include file in a .cpp file!!!
+#include "tier0/memdbgon.h"
+
+CBotVisibility g_BotVisibility;
+CBotVisibility *TheBotVisibility = &g_BotVisibility;
+
+DECLARE_REPLICATED_COMMAND( bot_visibility_grid, "1", "Size of the grid to which the ends of the rays are snapped to merge the duplicated rays (0 = Exact)." )
+
+// Handle = tick (11 bits) | index + 1 (20 bits)
+#define BOT_VISIBILITY_INDEX_BITS 20
+#define BOT_VISIBILITY_INDEX_MASK ((1 << BOT_VISIBILITY_INDEX_BITS) - 1)
+#define BOT_VISIBILITY_TICK_MASK 0x7FF
+
+//================================================================================
+// Snaps the position to a grid of [grid] units
+//================================================================================
+void Bot_SnapPosition( const Vector &vecPosition, float grid, int *result )
+{
+    for ( int it = 0; it < 3; ++it ) {
+        if ( grid > 0.0f ) {
+            result[it] = (int)floor( (vecPosition[it] / grid) + 0.5f );
+        }
+        else {
+            // Exact, we use the bits of the float
+            V_memcpy( &result[it], &vecPosition[it], sizeof( int ) );
+        }
+    }
+}
+
+//================================================================================
+// Returns if the end [a] goes before the end [b]
+//================================================================================
+static bool IsLessEnd( const int *a, int entityA, const int *b, int entityB )
+{
+    for ( int it = 0; it < 3; ++it ) {
+        if ( a[it] != b[it] )
+            return (a[it] < b[it]);
+    }
+
+    return (entityA < entityB);
+}
+
+//================================================================================
+//================================================================================
+static void RunWorldQuery( PerceptionQuery_t *&query )
+{
+    CBotVisibility::RunWorldQuery( *query );
+}
+
+//================================================================================
+//================================================================================
+CBotVisibility::CBotVisibility()
+{
+    SetDefLessFunc( m_Lookup );
+
+    m_iTick = -1;
+    m_iPosted = 0;
+    m_iSymmetric = 0;
+}
+
+//================================================================================
+// Starts the collection phase of a new tick, the handles of the
+// previous tick are not valid anymore.
+//================================================================================
+void CBotVisibility::Clear()
+{
+    // RemoveAll keeps the memory so we do not allocate again in the next frame
+    m_Rays.RemoveAll();
+    m_Lookup.RemoveAll();
+    m_Pending.RemoveAll();
+
+    m_iTick = TheBotWorld->GetTickCount();
+    m_iPosted = 0;
+    m_iSymmetric = 0;
+}
+
+//================================================================================
+// Adds a line trace for this tick and returns the handle to resolve it.
+// If the same ray (or the opposite ray for visibility) was already posted
+// we share it instead of adding a new one.
+//================================================================================
+BotVisibilityHandle CBotVisibility::Post( int type, CBaseEntity *pHost, const Vector &vecStart, const Vector &vecEnd, CBaseEntity *pIgnore )
+{
+    if ( !vecStart.IsValid() || !vecEnd.IsValid() )
+        return BOT_VISIBILITY_INVALID;
+
+    // First ray of this tick
+    if ( !IsCurrent() )
+        Clear();
+
+    ++m_iPosted;
+
+    BotVisibilityKey_t key;
+    bool swapped = false;
+    unsigned int hash = BuildKey( key, type, pHost, vecStart, vecEnd, pIgnore, swapped );
+
+    unsigned short node = m_Lookup.Find( hash );
+
+    if ( m_Lookup.IsValidIndex( node ) ) {
+        int index = FindRay( key, m_Lookup[node] );
+
+        if ( index != -1 ) {
+            if ( m_Rays[index].swapped != swapped )
+                ++m_iSymmetric;
+
+            return GetHandle( index );
+        }
+    }
+
+    if ( m_Rays.Count() >= BOT_VISIBILITY_INDEX_MASK ) {
+        AssertMsg( false, "Too many visibility rays" );
+        return BOT_VISIBILITY_INVALID;
+    }
+
+    int index = m_Rays.AddToTail();
+    BotVisibilityRay_t &ray = m_Rays[index];
+
+    ray.key = key;
+    ray.swapped = swapped;
+
+    ray.query.type = type;
+    ray.query.vecStart = vecStart;
+    ray.query.vecEnd = vecEnd;
+    ray.query.pHost = pHost;
+    ray.query.pIgnore = pIgnore;
+    ray.query.done = false;
+    ray.query.clear = false;
+    ray.query.pHit = NULL;
+
+    if ( m_Lookup.IsValidIndex( node ) ) {
+        ray.next = m_Lookup[node];
+        m_Lookup[node] = index;
+    }
+    else {
+        ray.next = -1;
+        m_Lookup.Insert( hash, index );
+    }
+
+    return GetHandle( index );
+}
+
+//================================================================================
+// Executes all the rays that have not been answered yet.
+// The traces with entity filters read the state of the entities and they are
+// not thread safe, only the first pass against the world geometry
+// is spread across worker threads. The visibility rays blocked by the world
+// are answered there, the rest are traced on the main thread.
+//================================================================================
+void CBotVisibility::Execute( bool bParallel, int minParallel )
+{
+    VPROF_BUDGET( "CBotVisibility::Execute", VPROF_BUDGETGROUP_BOTS );
+    BOT_TIMELINE_SCOPE( "CBotVisibility::Execute", "Manager" );
+
+    m_Pending.RemoveAll();
+
+    if ( !IsCurrent() )
+        return;
+
+    FOR_EACH_VEC( m_Rays, it )
+    {
+        if ( !m_Rays[it].query.done )
+            m_Pending.AddToTail( &m_Rays[it].query );
+    }
+
+    if ( m_Pending.Count() == 0 )
+        return;
+
+    if ( bParallel && m_Pending.Count() >= minParallel ) {
+        ParallelProcess( "CBotVisibility::Execute", m_Pending.Base(), m_Pending.Count(), &RunWorldQuery );
+    }
+
+    FOR_EACH_VEC( m_Pending, it )
+    {
+        if ( !m_Pending[it]->done )
+            RunQuery( *m_Pending[it] );
+    }
+
+    m_Pending.RemoveAll();
+}
+
+//================================================================================
+// Returns the answer of the ray or NULL if the handle is not from this tick.
+// Rays posted after the batch are traced now.
+//================================================================================
+const PerceptionQuery_t *CBotVisibility::Resolve( BotVisibilityHandle handle )
+{
+    int index = GetIndex( handle );
+
+    if ( index == -1 )
+        return NULL;
+
+    PerceptionQuery_t &query = m_Rays[index].query;
+
+    if ( !query.done ) {
+        TheBotProfiler->CountTrace( TheBotProfiler->GetCurrentBot(), BOT_TRACE_PERCEPTION );
+        RunQuery( query );
+    }
+
+    return &query;
+}
+
+//================================================================================
+// Traces a visibility ray only against the world geometry, if the world
+// blocks it the ray is answered (the hit is the world), otherwise
+// it is left for RunQuery. The line of fire needs the first entity that is hit.
+// NOTE: This is called from a worker thread, it must only read the world!
+//================================================================================
+void CBotVisibility::RunWorldQuery( PerceptionQuery_t &query )
+{
+    if ( query.type != PERCEPTION_VISIBILITY )
+        return;
+
+    CTraceFilterWorldOnly traceFilter;
+    trace_t tr;
+
+    TheBotWorld->TraceLine( query.vecStart, query.vecEnd, MASK_BLOCKLOS, &traceFilter, &tr );
+
+    if ( tr.fraction == 1.0f )
+        return;
+
+    query.clear = false;
+    query.pHit = tr.m_pEnt;
+    query.done = true;
+}
+
+//================================================================================
+// Executes the trace of the query.
+// NOTE: The filters read the entities, this must be called from the main thread.
+//================================================================================
+void CBotVisibility::RunQuery( PerceptionQuery_t &query )
+{
+    trace_t tr;
+
+    if ( query.type == PERCEPTION_LINE_OF_FIRE ) {
+        // We draw a line pretending to be the bullets
+        CBulletsTraceFilter traceFilter( COLLISION_GROUP_NONE );
+        traceFilter.AddEntityToIgnore( query.pHost );
+        traceFilter.AddEntityToIgnore( query.pIgnore );
+
+        TheBotWorld->TraceLine( query.vecStart, query.vecEnd, MASK_SHOT, &traceFilter, &tr );
+    }
+    else if ( query.pIgnore ) {
+        // Both ends are ignored so the answer is the same from the other side
+        CTraceFilterSkipTwoEntities traceFilter( query.pHost, query.pIgnore, COLLISION_GROUP_NONE );
+        TheBotWorld->TraceLine( query.vecStart, query.vecEnd, MASK_BLOCKLOS, &traceFilter, &tr );
+    }
+    else {
+        TheBotWorld->TraceLine( query.vecStart, query.vecEnd, MASK_BLOCKLOS, query.pHost, COLLISION_GROUP_NONE, &tr );
+    }
+
+    query.clear = (tr.fraction == 1.0f);
+    query.pHit = tr.m_pEnt;
+    query.done = true;
+}
+
+//================================================================================
+// Returns if [pHost] can see from [vecStart] to [vecEnd], the entities of both
+// ends are ignored. The ray is shared with the bots that ask for it in this tick.
+//================================================================================
+bool Bot_IsVisibilityClear( CBaseEntity *pHost, const Vector &vecStart, const Vector &vecEnd, CBaseEntity *pIgnore )
+{
+    const PerceptionQuery_t *result = TheBotVisibility->Resolve( TheBotVisibility->Post( PERCEPTION_VISIBILITY, pHost, vecStart, vecEnd, pIgnore ) );
+
+    if ( result )
+        return result->clear;
+
+    // The ray could not be posted, we trace it without sharing it
+    PerceptionQuery_t query;
+    query.type = PERCEPTION_VISIBILITY;
+    query.vecStart = vecStart;
+    query.vecEnd = vecEnd;
+    query.pHost = pHost;
+    query.pIgnore = pIgnore;
+
+    TheBotProfiler->CountTrace( TheBotProfiler->GetCurrentBot(), BOT_TRACE_PERCEPTION );
+    CBotVisibility::RunQuery( query );
+
+    return query.clear;
+}
+
+//================================================================================
+// Fills the identity of the ray and returns its hash
+//================================================================================
+unsigned int CBotVisibility::BuildKey( BotVisibilityKey_t &key, int type, CBaseEntity *pHost, const Vector &vecStart, const Vector &vecEnd, CBaseEntity *pIgnore, bool &swapped ) const
+{
+    float grid = bot_visibility_grid.GetFloat();
+
+    key.type = type;
+    key.host = (pHost) ? pHost->entindex() : -1;
+    key.ignore = (pIgnore) ? pIgnore->entindex() : -1;
+
+    Bot_SnapPosition( vecStart, grid, key.start );
+    Bot_SnapPosition( vecEnd, grid, key.end );
+
+    swapped = false;
+
+    // The visibility traces ignore the entities of both ends,
+    // the ray from the other side gives the same answer.
+    if ( type == PERCEPTION_VISIBILITY && IsLessEnd( key.end, key.ignore, key.start, key.host ) ) {
+        for ( int it = 0; it < 3; ++it ) {
+            V_swap( key.start[it], key.end[it] );
+        }
+
+        V_swap( key.host, key.ignore );
+        swapped = true;
+    }
+
+    // FNV-1a
+    const int *data = (const int *)&key;
+    unsigned int hash = 2166136261u;
+
+    for ( int it = 0; it < sizeof( BotVisibilityKey_t ) / sizeof( int ); ++it ) {
+        hash = (hash ^ (unsigned int)data[it]) * 16777619u;
+    }
+
+    return hash;
+}
+
+//================================================================================
+// Returns the ray with the same identity in the hash chain, -1 if none
+//================================================================================
+int CBotVisibility::FindRay( const BotVisibilityKey_t &key, int first ) const
+{
+    for ( int it = first; it != -1; it = m_Rays[it].next ) {
+        if ( V_memcmp( &m_Rays[it].key, &key, sizeof( BotVisibilityKey_t ) ) == 0 )
+            return it;
+    }
+
+    return -1;
+}
+
+//================================================================================
+//================================================================================
+BotVisibilityHandle CBotVisibility::GetHandle( int index ) const
+{
+    return ((m_iTick & BOT_VISIBILITY_TICK_MASK) << BOT_VISIBILITY_INDEX_BITS) | (index + 1);
+}
+
+//================================================================================
+// Returns the index of the ray, -1 if the handle is not from this tick
+//================================================================================
+int CBotVisibility::GetIndex( BotVisibilityHandle handle ) const
+{
+    if ( handle == BOT_VISIBILITY_INVALID || !IsCurrent() )
+        return -1;
+
+    int index = (handle & BOT_VISIBILITY_INDEX_MASK) - 1;
+
+    if ( !m_Rays.IsValidIndex( index ) )
+        return -1;
+
+    if ( GetHandle( index ) != handle )
+        return -1;
+
+    return index;
+}
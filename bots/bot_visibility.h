@@ -0,0 +1,132 @@
+//========= Copyright  1996-2005, Valve Corporation, All rights reserved. ============//
+// Authors: 
+// Ivn Bravo Bravo (linkedin.com/in/ivanbravobravo), 2017
+
+#ifndef BOT_VISIBILITY_H
+#define BOT_VISIBILITY_H
+
+#ifdef _WIN32
+#pragma once
+#endif
+
+#include "bots\bot_defs.h"
+
+//================================================================================
+// Line traces that the bots need in this frame.
+// They are posted to the visibility service and executed in a single batch
+// before the bots run their A.I. (see CBotVisibility::Execute)
+//================================================================================
+enum PerceptionQueryType
+{
+    PERCEPTION_VISIBILITY = 0, // Same as FVisible()
+    PERCEPTION_LINE_OF_FIRE,   // Same as IsLineOfSightClear()
+
+    LAST_PERCEPTION_QUERY
+};
+
+struct PerceptionQuery_t
+{
+    int type;
+
+    Vector vecStart;
+    Vector vecEnd;
+
+    CBaseEntity *pHost;
+    CBaseEntity *pIgnore;
+
+    // Results
+    bool done;
+    bool clear;
+    CBaseEntity *pHit;
+};
+
+//================================================================================
+// Identity of a ray, the ends are snapped to a grid.
+// The visibility rays are stored with their ends in a fixed order
+// so A -> B and B -> A are the same ray.
+//================================================================================
+struct BotVisibilityKey_t
+{
+    int type;
+    int start[3];
+    int end[3];
+    int host;
+    int ignore;
+};
+
+struct BotVisibilityRay_t
+{
+    BotVisibilityKey_t key;
+    PerceptionQuery_t query;
+
+    // The ends were swapped to build the key
+    bool swapped;
+
+    // Next ray with the same hash
+    int next;
+};
+
+//================================================================================
+// Visibility query service shared by all the bots.
+// During the collection phase the bots post the rays they will need and
+// receive a handle, identical or symmetric rays of the same tick are
+// merged into one. The rays are answered in one batch by Execute and the bots
+// resolve their handles later in the tick, a ray posted after the batch
+// is traced when it is resolved.
+//================================================================================
+class CBotVisibility
+{
+public:
+    CBotVisibility();
+
+    virtual void Clear();
+
+    virtual BotVisibilityHandle Post( int type, CBaseEntity *pHost, const Vector &vecStart, const Vector &vecEnd, CBaseEntity *pIgnore = NULL );
+    virtual void Execute( bool bParallel, int minParallel );
+    virtual const PerceptionQuery_t *Resolve( BotVisibilityHandle handle );
+
+    virtual bool IsCurrent() const {
+        return (m_iTick == TheBotWorld->GetTickCount());
+    }
+
+    // Stats of this tick
+    virtual int GetPostedCount() const {
+        return m_iPosted;
+    }
+
+    virtual int GetRayCount() const {
+        return m_Rays.Count();
+    }
+
+    virtual int GetSymmetricCount() const {
+        return m_iSymmetric;
+    }
+
+    static void RunWorldQuery( PerceptionQuery_t &query );
+    static void RunQuery( PerceptionQuery_t &query );
+
+protected:
+    virtual unsigned int BuildKey( BotVisibilityKey_t &key, int type, CBaseEntity *pHost, const Vector &vecStart, const Vector &vecEnd, CBaseEntity *pIgnore, bool &swapped ) const;
+    virtual int FindRay( const BotVisibilityKey_t &key, int first ) const;
+
+    virtual BotVisibilityHandle GetHandle( int index ) const;
+    virtual int GetIndex( BotVisibilityHandle handle ) const;
+
+protected:
+    int m_iTick;
+    int m_iPosted;
+    int m_iSymmetric;
+
+    CUtlVector<BotVisibilityRay_t> m_Rays;
+    CUtlMap<unsigned int, int> m_Lookup;
+
+    // Reused in each tick to avoid allocating memory
+    CUtlVector<PerceptionQuery_t *> m_Pending;
+};
+
+extern CBotVisibility *TheBotVisibility;
+
+extern void Bot_SnapPosition( const Vector &vecPosition, float grid, int *result );
+extern bool Bot_IsVisibilityClear( CBaseEntity *pHost, const Vector &vecStart, const Vector &vecEnd, CBaseEntity *pIgnore = NULL );
+
+#endif // BOT_VISIBILITY_H
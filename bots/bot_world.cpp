@@ -0,0 +1,439 @@
+//========= Copyright  1996-2005, Valve Corporation, All rights reserved. ============//
+// Authors: 
+// Ivn Bravo Bravo (linkedin.com/in/ivanbravobravo), 2017
+
+#include "cbase.h"
+#include "bots\bot_world.h"
+
+#include "bots\bot.h"
+#include "nav_mesh.h"
+#include "ai_hint.h"
+
+#ifdef INSOURCE_DLL
+#include "in_utils.h"
+#else
+#include "bots\in_utils.h"
+#endif
+
+// memdbgon must be the last include file in a .cpp file!!!
+#include "tier0/memdbgon.h"
+
+CBotEngineWorld g_BotEngineWorld;
+CBotEngineWorld *TheBotEngineWorld = &g_BotEngineWorld;
+
+CBotMockWorld g_BotMockWorld;
+CBotMockWorld *TheBotMockWorld = &g_BotMockWorld;
+
+IBotWorld *TheBotWorld = &g_BotEngineWorld;
+
+//================================================================================
+//================================================================================
+void Bot_SetWorld( IBotWorld *pWorld )
+{
+    if ( pWorld == NULL )
+        pWorld = TheBotEngineWorld;
+
+    if ( pWorld == TheBotWorld )
+        return;
+
+    TheBotWorld = pWorld;
+    DevMsg( "The bots are now using the world: %s\n", pWorld->GetName() );
+}
+
+//================================================================================
+//================================================================================
+float CBotEngineWorld::GetTime() const
+{
+    return gpGlobals->curtime;
+}
+
+//================================================================================
+//================================================================================
+int CBotEngineWorld::GetTickCount() const
+{
+    return gpGlobals->tickcount;
+}
+
+//================================================================================
+//================================================================================
+float CBotEngineWorld::GetTickInterval() const
+{
+    return gpGlobals->interval_per_tick;
+}
+
+//================================================================================
+//================================================================================
+void CBotEngineWorld::TraceLine( const Vector &vecAbsStart, const Vector &vecAbsEnd, unsigned int mask, const IHandleEntity *ignore, int collisionGroup, trace_t *ptr )
+{
+    UTIL_TraceLine( vecAbsStart, vecAbsEnd, mask, ignore, collisionGroup, ptr );
+}
+
+//================================================================================
+//================================================================================
+void CBotEngineWorld::TraceLine( const Vector &vecAbsStart, const Vector &vecAbsEnd, unsigned int mask, ITraceFilter *pFilter, trace_t *ptr )
+{
+    UTIL_TraceLine( vecAbsStart, vecAbsEnd, mask, pFilter, ptr );
+}
+
+//================================================================================
+//================================================================================
+void CBotEngineWorld::TraceHull( const Vector &vecAbsStart, const Vector &vecAbsEnd, const Vector &hullMin, const Vector &hullMax, unsigned int mask, const IHandleEntity *ignore, int collisionGroup, trace_t *ptr )
+{
+    UTIL_TraceHull( vecAbsStart, vecAbsEnd, hullMin, hullMax, mask, ignore, collisionGroup, ptr );
+}
+
+//================================================================================
+//================================================================================
+bool CBotEngineWorld::IsWalkableTraceLineClear( const Vector &from, const Vector &to, unsigned int flags )
+{
+    return ::IsWalkableTraceLineClear( from, to, flags );
+}
+
+//================================================================================
+//================================================================================
+bool CBotEngineWorld::IsNavMeshLoaded() const
+{
+    return (TheNavMesh->GetNavAreaCount() > 0);
+}
+
+//================================================================================
+//================================================================================
+CNavArea *CBotEngineWorld::GetNavArea( const Vector &pos ) const
+{
+    return TheNavMesh->GetNavArea( pos );
+}
+
+//================================================================================
+//================================================================================
+CNavArea *CBotEngineWorld::GetNearestNavArea( const Vector &pos ) const
+{
+    return TheNavMesh->GetNearestNavArea( pos );
+}
+
+//================================================================================
+//================================================================================
+CNavArea *CBotEngineWorld::GetNearestNavArea( CBaseEntity *pEntity ) const
+{
+    return TheNavMesh->GetNearestNavArea( pEntity );
+}
+
+//================================================================================
+//================================================================================
+bool CBotEngineWorld::GetGroundHeight( const Vector &pos, float *height, Vector *normal ) const
+{
+    return TheNavMesh->GetGroundHeight( pos, height, normal );
+}
+
+//================================================================================
+//================================================================================
+bool CBotEngineWorld::GetSimpleGroundHeight( const Vector &pos, float *height, Vector *normal ) const
+{
+    return TheNavMesh->GetSimpleGroundHeight( pos, height, normal );
+}
+
+//================================================================================
+//================================================================================
+int CBotEngineWorld::GetMaxPlayers() const
+{
+    return gpGlobals->maxClients;
+}
+
+//================================================================================
+//================================================================================
+CPlayer *CBotEngineWorld::GetPlayer( int index ) const
+{
+    return ToInPlayer( UTIL_PlayerByIndex( index ) );
+}
+
+//================================================================================
+//================================================================================
+int CBotEngineWorld::FindHints( const Vector &vecOrigin, const CHintCriteria &criteria, CUtlVector<CAI_Hint *> *pResult )
+{
+    return CAI_HintManager::FindAllHints( vecOrigin, criteria, pResult );
+}
+
+//================================================================================
+//================================================================================
+CBotMockWorld::CBotMockWorld()
+{
+    m_flGround = 0.0f;
+}
+
+//================================================================================
+//================================================================================
+void CBotMockWorld::Clear()
+{
+    m_Boxes.Purge();
+}
+
+//================================================================================
+//================================================================================
+void CBotMockWorld::SetGround( float z )
+{
+    m_flGround = z;
+}
+
+//================================================================================
+//================================================================================
+void CBotMockWorld::AddBox( const Vector &mins, const Vector &maxs )
+{
+    BotMockBox_t box;
+    box.mins = mins;
+    box.maxs = maxs;
+
+    m_Boxes.AddToTail( box );
+}
+
+//================================================================================
+// Removes the boxes that cover the square of [radius] around the position
+//================================================================================
+void CBotMockWorld::ClearBoxes( const Vector &vecPosition, float radius )
+{
+    FOR_EACH_VEC_BACK( m_Boxes, it )
+    {
+        const BotMockBox_t &box = m_Boxes[it];
+
+        if ( box.maxs.x < vecPosition.x - radius || box.mins.x > vecPosition.x + radius )
+            continue;
+
+        if ( box.maxs.y < vecPosition.y - radius || box.mins.y > vecPosition.y + radius )
+            continue;
+
+        m_Boxes.Remove( it );
+    }
+}
+
+//================================================================================
+// Places [count] boxes around the center, the same seed gives the same scene
+//================================================================================
+void CBotMockWorld::Generate( int seed, int count, const Vector &vecCenter, float radius )
+{
+    CUniformRandomStream random;
+    random.SetSeed( seed );
+
+    Clear();
+    SetGround( vecCenter.z );
+    m_Boxes.EnsureCapacity( count );
+
+    for ( int it = 0; it < count; ++it ) {
+        Vector size( random.RandomFloat( 32.0f, 256.0f ), random.RandomFloat( 32.0f, 256.0f ), random.RandomFloat( 48.0f, 192.0f ) );
+        Vector origin( vecCenter.x + random.RandomFloat( -radius, radius ), vecCenter.y + random.RandomFloat( -radius, radius ), m_flGround );
+
+        Vector mins( origin.x - size.x * 0.5f, origin.y - size.y * 0.5f, m_flGround );
+        Vector maxs( origin.x + size.x * 0.5f, origin.y + size.y * 0.5f, m_flGround + size.z );
+
+        AddBox( mins, maxs );
+    }
+}
+
+//================================================================================
+//================================================================================
+void CBotMockWorld::TraceLine( const Vector &vecAbsStart, const Vector &vecAbsEnd, unsigned int mask, const IHandleEntity *ignore, int collisionGroup, trace_t *ptr )
+{
+    Trace( vecAbsStart, vecAbsEnd, vec3_origin, vec3_origin, mask, NULL, ptr );
+}
+
+//================================================================================
+//================================================================================
+void CBotMockWorld::TraceLine( const Vector &vecAbsStart, const Vector &vecAbsEnd, unsigned int mask, ITraceFilter *pFilter, trace_t *ptr )
+{
+    Trace( vecAbsStart, vecAbsEnd, vec3_origin, vec3_origin, mask, pFilter, ptr );
+}
+
+//================================================================================
+//================================================================================
+void CBotMockWorld::TraceHull( const Vector &vecAbsStart, const Vector &vecAbsEnd, const Vector &hullMin, const Vector &hullMax, unsigned int mask, const IHandleEntity *ignore, int collisionGroup, trace_t *ptr )
+{
+    Trace( vecAbsStart, vecAbsEnd, hullMin, hullMax, mask, NULL, ptr );
+}
+
+//================================================================================
+//================================================================================
+bool CBotMockWorld::IsWalkableTraceLineClear( const Vector &from, const Vector &to, unsigned int flags )
+{
+    CTraceFilterWorldOnly traceFilter;
+    trace_t tr;
+    Trace( from, to, vec3_origin, vec3_origin, MASK_NPCSOLID, &traceFilter, &tr );
+
+    return (tr.fraction == 1.0f);
+}
+
+//================================================================================
+// Returns the top of the highest box under the position.
+// The paths are computed with the navigation mesh of the engine, so the ground
+// under the boxes is the ground of the engine (the flat ground if there is none)
+//================================================================================
+bool CBotMockWorld::GetGroundHeight( const Vector &pos, float *height, Vector *normal ) const
+{
+    float ground;
+
+    if ( !CBotEngineWorld::GetGroundHeight( pos, &ground ) )
+        ground = m_flGround;
+
+    return GetBoxHeight( pos, ground, height, normal );
+}
+
+//================================================================================
+//================================================================================
+bool CBotMockWorld::GetSimpleGroundHeight( const Vector &pos, float *height, Vector *normal ) const
+{
+    float ground;
+
+    if ( !CBotEngineWorld::GetSimpleGroundHeight( pos, &ground ) )
+        ground = m_flGround;
+
+    return GetBoxHeight( pos, ground, height, normal );
+}
+
+//================================================================================
+// Returns the top of the highest box under the position that is over [ground]
+//================================================================================
+bool CBotMockWorld::GetBoxHeight( const Vector &pos, float ground, float *height, Vector *normal ) const
+{
+    FOR_EACH_VEC( m_Boxes, it )
+    {
+        const BotMockBox_t &box = m_Boxes[it];
+
+        if ( pos.x < box.mins.x || pos.x > box.maxs.x || pos.y < box.mins.y || pos.y > box.maxs.y )
+            continue;
+
+        if ( box.maxs.z > pos.z || box.maxs.z < ground )
+            continue;
+
+        ground = box.maxs.z;
+    }
+
+    if ( height )
+        *height = ground;
+
+    if ( normal )
+        normal->Init( 0.0f, 0.0f, 1.0f );
+
+    return true;
+}
+
+//================================================================================
+// Sweeps the hull against the ground and the boxes (slab test).
+// The boxes are expanded by the hull so the hull can be treated as a point.
+// The ground and the boxes are solid parts of the world (worldspawn), like
+// the engine they are skipped when the mask has no CONTENTS_SOLID or the
+// filter only wants the entities. The world is never passed to ShouldHitEntity.
+// NOTE: This can be called from a worker thread, it must only read the scene!
+//================================================================================
+void CBotMockWorld::Trace( const Vector &vecStart, const Vector &vecEnd, const Vector &hullMin, const Vector &hullMax, unsigned int mask, ITraceFilter *pFilter, trace_t *ptr ) const
+{
+    Q_memset( ptr, 0, sizeof( trace_t ) );
+
+    ptr->startpos = vecStart;
+    ptr->endpos = vecEnd;
+    ptr->fraction = 1.0f;
+
+    if ( !(mask & CONTENTS_SOLID) )
+        return;
+
+    if ( pFilter && pFilter->GetTraceType() == TRACE_ENTITIES_ONLY )
+        return;
+
+    CBaseEntity *pWorld = GetContainingEntity( INDEXENT( 0 ) );
+
+    Vector direction = vecEnd - vecStart;
+    Vector hitNormal = vec3_origin;
+
+    // The ground is one more box
+    int count = m_Boxes.Count() + 1;
+
+    for ( int it = 0; it < count; ++it ) {
+        Vector mins, maxs;
+
+        if ( it == m_Boxes.Count() ) {
+            mins.Init( -MAX_COORD_FLOAT, -MAX_COORD_FLOAT, m_flGround - 64.0f );
+            maxs.Init( MAX_COORD_FLOAT, MAX_COORD_FLOAT, m_flGround );
+        }
+        else {
+            mins = m_Boxes[it].mins;
+            maxs = m_Boxes[it].maxs;
+        }
+
+        mins -= hullMax;
+        maxs -= hullMin;
+
+        float enter = -FLT_MAX;
+        float exit = FLT_MAX;
+        int axis = -1;
+        bool hit = true;
+
+        for ( int i = 0; i < 3; ++i ) {
+            if ( fabs( direction[i] ) < 1e-6f ) {
+                if ( vecStart[i] < mins[i] || vecStart[i] > maxs[i] ) {
+                    hit = false;
+                    break;
+                }
+
+                continue;
+            }
+
+            float t1 = (mins[i] - vecStart[i]) / direction[i];
+            float t2 = (maxs[i] - vecStart[i]) / direction[i];
+
+            if ( t1 > t2 )
+                V_swap( t1, t2 );
+
+            if ( t1 > enter ) {
+                enter = t1;
+                axis = i;
+            }
+
+            exit = MIN( exit, t2 );
+        }
+
+        if ( !hit || enter > exit || exit < 0.0f || enter >= ptr->fraction )
+            continue;
+
+        // We started inside
+        if ( enter < 0.0f ) {
+            ptr->startsolid = true;
+            ptr->allsolid = (exit >= 1.0f);
+            ptr->fraction = 0.0f;
+            hitNormal = vec3_origin;
+            break;
+        }
+
+        ptr->fraction = enter;
+        hitNormal = vec3_origin;
+        hitNormal[axis] = (direction[axis] > 0.0f) ? -1.0f : 1.0f;
+    }
+
+    ptr->endpos = vecStart + direction * ptr->fraction;
+
+    if ( ptr->fraction < 1.0f ) {
+        ptr->plane.normal = hitNormal;
+        ptr->contents = CONTENTS_SOLID;
+        ptr->m_pEnt = pWorld;
+    }
+}
+
+//================================================================================
+//================================================================================
+CON_COMMAND_F( bot_world_mock, "Replaces the world of the bots with a synthetic scene of boxes around you. Usage: bot_world_mock <boxes> [seed] [radius] (0 = Engine)", FCVAR_SERVER )
+{
+    int count = (args.ArgC() > 1) ? atoi( args.Arg( 1 ) ) : 0;
+
+    if ( count <= 0 ) {
+        Bot_SetWorld( NULL );
+        return;
+    }
+
+    int seed = (args.ArgC() > 2) ? atoi( args.Arg( 2 ) ) : 0;
+    float radius = (args.ArgC() > 3) ? atof( args.Arg( 3 ) ) : 2048.0f;
+
+    Vector vecCenter = vec3_origin;
+    CBasePlayer *pPlayer = UTIL_GetCommandClient();
+
+    if ( pPlayer )
+        vecCenter = pPlayer->GetAbsOrigin();
+
+    TheBotMockWorld->Generate( seed, count, vecCenter, radius );
+    Bot_SetWorld( TheBotMockWorld );
+
+    Msg( "Synthetic world with %i boxes (seed %i)\n", TheBotMockWorld->GetBoxCount(), seed );
+}
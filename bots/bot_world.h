@@ -0,0 +1,108 @@
+//========= Copyright  1996-2005, Valve Corporation, All rights reserved. ============//
+// Authors: 
+// Ivn Bravo Bravo (linkedin.com/in/ivanbravobravo), 2017
+
+#ifndef BOT_WORLD_H
+#define BOT_WORLD_H
+
+#ifdef _WIN32
+#pragma once
+#endif
+
+#include "bots\interfaces\ibotworld.h"
+
+//================================================================================
+// The world of the game, everything is asked to the engine
+//================================================================================
+class CBotEngineWorld : public IBotWorld
+{
+public:
+    virtual const char *GetName() const {
+        return "Engine";
+    }
+
+    virtual float GetTime() const;
+    virtual int GetTickCount() const;
+    virtual float GetTickInterval() const;
+
+    virtual void TraceLine( const Vector &vecAbsStart, const Vector &vecAbsEnd, unsigned int mask, const IHandleEntity *ignore, int collisionGroup, trace_t *ptr );
+    virtual void TraceLine( const Vector &vecAbsStart, const Vector &vecAbsEnd, unsigned int mask, ITraceFilter *pFilter, trace_t *ptr );
+    virtual void TraceHull( const Vector &vecAbsStart, const Vector &vecAbsEnd, const Vector &hullMin, const Vector &hullMax, unsigned int mask, const IHandleEntity *ignore, int collisionGroup, trace_t *ptr );
+    virtual bool IsWalkableTraceLineClear( const Vector &from, const Vector &to, unsigned int flags = 0 );
+
+    virtual bool IsNavMeshLoaded() const;
+    virtual CNavArea *GetNavArea( const Vector &pos ) const;
+    virtual CNavArea *GetNearestNavArea( const Vector &pos ) const;
+    virtual CNavArea *GetNearestNavArea( CBaseEntity *pEntity ) const;
+    virtual bool GetGroundHeight( const Vector &pos, float *height, Vector *normal = NULL ) const;
+    virtual bool GetSimpleGroundHeight( const Vector &pos, float *height, Vector *normal = NULL ) const;
+
+    virtual int GetMaxPlayers() const;
+    virtual CPlayer *GetPlayer( int index ) const;
+
+    virtual int FindHints( const Vector &vecOrigin, const CHintCriteria &criteria, CUtlVector<CAI_Hint *> *pResult );
+};
+
+//================================================================================
+// Solid box of the synthetic scene
+//================================================================================
+struct BotMockBox_t
+{
+    Vector mins;
+    Vector maxs;
+};
+
+//================================================================================
+// Synthetic world made of a flat ground and boxes.
+// The traces and the ground height are solved against the boxes
+// without touching the physics of the engine, so the cost of the A.I.
+// can be measured without the noise of the map geometry.
+// The traces honour the mask and the filter, but the entities are not
+// part of the scene: only the world (the ground and the boxes) can be hit.
+// The navigation mesh, the entities, the time and the hints
+// are still taken from the engine, the ground height under the boxes
+// is the one of the engine so the paths and the ground agree.
+//================================================================================
+class CBotMockWorld : public CBotEngineWorld
+{
+public:
+    CBotMockWorld();
+
+    virtual const char *GetName() const {
+        return "Mock";
+    }
+
+    virtual void Clear();
+    virtual void SetGround( float z );
+    virtual void AddBox( const Vector &mins, const Vector &maxs );
+    virtual void ClearBoxes( const Vector &vecPosition, float radius );
+    virtual void Generate( int seed, int count, const Vector &vecCenter, float radius );
+
+    virtual int GetBoxCount() const {
+        return m_Boxes.Count();
+    }
+
+    virtual void TraceLine( const Vector &vecAbsStart, const Vector &vecAbsEnd, unsigned int mask, const IHandleEntity *ignore, int collisionGroup, trace_t *ptr );
+    virtual void TraceLine( const Vector &vecAbsStart, const Vector &vecAbsEnd, unsigned int mask, ITraceFilter *pFilter, trace_t *ptr );
+    virtual void TraceHull( const Vector &vecAbsStart, const Vector &vecAbsEnd, const Vector &hullMin, const Vector &hullMax, unsigned int mask, const IHandleEntity *ignore, int collisionGroup, trace_t *ptr );
+    virtual bool IsWalkableTraceLineClear( const Vector &from, const Vector &to, unsigned int flags = 0 );
+
+    virtual bool GetGroundHeight( const Vector &pos, float *height, Vector *normal = NULL ) const;
+    virtual bool GetSimpleGroundHeight( const Vector &pos, float *height, Vector *normal = NULL ) const;
+
+protected:
+    virtual bool GetBoxHeight( const Vector &pos, float ground, float *height, Vector *normal ) const;
+    virtual void Trace( const Vector &vecStart, const Vector &vecEnd, const Vector &hullMin, const Vector &hullMax, unsigned int mask, ITraceFilter *pFilter, trace_t *ptr ) const;
+
+protected:
+    float m_flGround;
+    CUtlVector<BotMockBox_t> m_Boxes;
+};
+
+extern CBotEngineWorld *TheBotEngineWorld;
+extern CBotMockWorld *TheBotMockWorld;
+
+// Replaces the world of the bots, NULL = Engine
+extern void Bot_SetWorld( IBotWorld *pWorld );
+
+#endif // BOT_WORLD_H
@@ -4,6 +4,7 @@
 
 #include "cbase.h"
 #include "bots\bot.h"
+#include "bots\bot_profiler.h"
 
 #ifdef INSOURCE_DLL
 #include "in_gamerules.h"
@@ -25,6 +26,94 @@ extern ConVar bot_debug_jump;
 extern ConVar bot_primary_attack;
 extern ConVar bot_dont_attack;
 
+DECLARE_REPLICATED_COMMAND( bot_decision_memo, "1", "Indicates if the bots remember the answers of their decision predicates during the tick." )
+DECLARE_REPLICATED_COMMAND( bot_trace_budget_tolerance, "16", "Distance that the positions of a check can move and still use its previous answer when the trace budget is exhausted." )
+
+//================================================================================
+// Returns if a check is close enough to the previous one to use its answer
+// when the trace budget is exhausted (see bot_trace_budget)
+//================================================================================
+static bool IsSameTraceQuestion( const Vector &vecPrevious, const Vector &vecCurrent )
+{
+    if ( !vecPrevious.IsValid() )
+        return false;
+
+    float tolerance = bot_trace_budget_tolerance.GetFloat();
+    return (vecPrevious.DistToSqr( vecCurrent ) <= tolerance * tolerance);
+}
+
+//================================================================================
+// Forgets the answers of the predicates. 
+// Called at the start of RunAI and when the conditions have been gathered.
+//================================================================================
+void CBotDecision::InvalidateMemo()
+{
+    ++m_iMemoEpoch;
+    m_iMemoTick = TheBotWorld->GetTickCount();
+    m_EntityMemo.RemoveAll();
+}
+
+//================================================================================
+// Returns if the predicate was already answered in this tick
+//================================================================================
+bool CBotDecision::GetMemo( BotDecisionMemo memo, bool &value, CBaseEntity *pEntity ) const
+{
+    if ( !bot_decision_memo.GetBool() )
+        return false;
+
+    // The answers are from another tick (we are asked outside RunAI)
+    if ( m_iMemoTick != TheBotWorld->GetTickCount() )
+        return false;
+
+    if ( pEntity ) {
+        FOR_EACH_VEC( m_EntityMemo, it )
+        {
+            const BotEntityMemo_t &entry = m_EntityMemo[it];
+
+            if ( entry.memo != memo || entry.pEntity != pEntity )
+                continue;
+
+            value = entry.value;
+            ++m_iMemoSaved;
+            return true;
+        }
+
+        return false;
+    }
+
+    if ( m_MemoEpoch[memo] != m_iMemoEpoch )
+        return false;
+
+    value = m_MemoValue[memo];
+    ++m_iMemoSaved;
+    return true;
+}
+
+//================================================================================
+// Remembers the answer of the predicate and returns it
+//================================================================================
+bool CBotDecision::SetMemo( BotDecisionMemo memo, bool value, CBaseEntity *pEntity ) const
+{
+    ++m_iMemoEvaluated;
+
+    if ( m_iMemoTick != TheBotWorld->GetTickCount() ) {
+        const_cast<CBotDecision *>(this)->InvalidateMemo();
+    }
+
+    if ( pEntity ) {
+        int index = m_EntityMemo.AddToTail();
+        m_EntityMemo[index].memo = memo;
+        m_EntityMemo[index].pEntity = pEntity;
+        m_EntityMemo[index].value = value;
+    }
+    else {
+        m_MemoEpoch[memo] = m_iMemoEpoch;
+        m_MemoValue[memo] = value;
+    }
+
+    return value;
+}
+
 //================================================================================
 //================================================================================
 bool CBotDecision::ShouldLookDangerSpot() const
@@ -140,8 +229,8 @@ bool CBotDecision::ShouldTeleport( const Vector &vecGoal ) const
         if ( ThePlayersSystem->IsVisible( vecGoal ) )
             return false;
 #else
-        for ( int i = 0; i <= gpGlobals->maxClients; ++i ) {
-            CPlayer *pPlayer = ToInPlayer( UTIL_PlayerByIndex( i ) );
+        for ( int i = 0; i <= TheBotWorld->GetMaxPlayers(); ++i ) {
+            CPlayer *pPlayer = TheBotWorld->GetPlayer( i );
 
             if ( !pPlayer )
                 continue;
@@ -155,7 +244,7 @@ bool CBotDecision::ShouldTeleport( const Vector &vecGoal ) const
             if ( pPlayer == GetHost() )
                 continue;
 
-            if ( pPlayer->FVisible( vecGoal ) && pPlayer->IsInFieldOfView( vecGoal ) )
+            if ( pPlayer->IsInFieldOfView( vecGoal ) && Bot_IsVisibilityClear( pPlayer, pPlayer->EyePosition(), vecGoal ) )
                 return false;
         }
 #endif
@@ -164,11 +253,21 @@ bool CBotDecision::ShouldTeleport( const Vector &vecGoal ) const
     Vector vUpBit = GetHost()->GetAbsOrigin();
     vUpBit.z += 1;
 
-    trace_t tr;
-    UTIL_TraceHull( vecGoal, vUpBit, GetHost()->WorldAlignMins(), GetHost()->WorldAlignMaxs(),
-                    MASK_SOLID, GetHost(), COLLISION_GROUP_NONE, &tr );
+    // Without trace budget we use the previous answer, only if it was for a close hull
+    if ( Bot_CanTrace( BOT_TRACE_TELEPORT ) ) {
+        trace_t tr;
+        Bot_TraceHull( BOT_TRACE_TELEPORT, vecGoal, vUpBit, GetHost()->WorldAlignMins(), GetHost()->WorldAlignMaxs(),
+                       MASK_SOLID, GetHost(), COLLISION_GROUP_NONE, &tr );
 
-    if ( tr.startsolid || tr.fraction < 1.0 )
+        m_bTeleportClear = (!tr.startsolid && tr.fraction == 1.0f);
+        m_vecTeleportGoal = vecGoal;
+        m_vecTeleportStart = vUpBit;
+    }
+    else if ( !IsSameTraceQuestion( m_vecTeleportGoal, vecGoal ) || !IsSameTraceQuestion( m_vecTeleportStart, vUpBit ) ) {
+        return false;
+    }
+
+    if ( !m_bTeleportClear )
         return false;
 
     return bot_locomotion_allow_teleport.GetBool();
@@ -315,12 +414,24 @@ bool CBotDecision::ShouldJump() const
         Vector vecForward;
         AngleVectors( angles, &vecForward );
 
+        // Without trace budget we use the previous answer, only if it was for a close spot
+        if ( !Bot_CanTrace( BOT_TRACE_JUMP ) ) {
+            if ( !IsSameTraceQuestion( m_vecJumpFeet, vecFeetBlocked ) || !IsSameTraceQuestion( m_vecJumpSpot, vecNextSpot ) )
+                return false;
+
+            return m_bShouldJump;
+        }
+
+        m_bShouldJump = false;
+        m_vecJumpFeet = vecFeetBlocked;
+        m_vecJumpSpot = vecNextSpot;
+
         // Trazamos dos lneas para verificar que podemos hacer el salto
         trace_t blocked;
-        UTIL_TraceLine( vecFeetBlocked, vecFeetBlocked + 30.0f * vecForward, MASK_SOLID, GetHost(), COLLISION_GROUP_NONE, &blocked );
+        Bot_TraceLine( BOT_TRACE_JUMP, vecFeetBlocked, vecFeetBlocked + 30.0f * vecForward, MASK_SOLID, GetHost(), COLLISION_GROUP_NONE, &blocked );
 
         trace_t clear;
-        UTIL_TraceLine( vecFeetClear, vecFeetClear + 30.0f * vecForward, MASK_SOLID, GetHost(), COLLISION_GROUP_NONE, &clear );
+        Bot_TraceLine( BOT_TRACE_JUMP, vecFeetClear, vecFeetClear + 30.0f * vecForward, MASK_SOLID, GetHost(), COLLISION_GROUP_NONE, &clear );
 
         if ( bot_debug_jump.GetBool() && GetBot()->ShouldShowDebug() ) {
             NDebugOverlay::Line( vecFeetBlocked, vecFeetBlocked + 30.0f * vecForward, 0, 0, 255, true, 0.1f );
@@ -352,6 +463,7 @@ bool CBotDecision::ShouldJump() const
                 NDebugOverlay::EntityBounds( GetHost(), 0, 255, 0, 5.0f, 0.1f );
             }
 
+            m_bShouldJump = true;
             return true;
         }
     }
@@ -382,7 +494,7 @@ bool CBotDecision::CanHuntThreat() const
             return false;
 
         // There are several more dangerous enemies, we should not go
-        if ( GetDataMemoryInt( "NearbyDangerousThreats" ) >= 3 )
+        if ( GetDataMemoryInt( MEMORY_NEARBY_DANGEROUS_THREATS ) >= 3 )
             return false;
     }
 
@@ -538,6 +650,18 @@ bool CBotDecision::ShouldSwitchToWeapon( CBaseWeapon *pWeapon ) const
 //================================================================================
 //================================================================================
 bool CBotDecision::ShouldHelpFriends() const
+{
+    bool value;
+
+    if ( GetMemo( BOT_MEMO_SHOULD_HELP_FRIENDS, value ) )
+        return value;
+
+    return SetMemo( BOT_MEMO_SHOULD_HELP_FRIENDS, EvaluateShouldHelpFriends() );
+}
+
+//================================================================================
+//================================================================================
+bool CBotDecision::EvaluateShouldHelpFriends() const
 {
     if ( GetProfile()->IsEasiest() )
         return false;
@@ -571,7 +695,7 @@ bool CBotDecision::ShouldHelpDejectedFriend( CPlayer *pDejected ) const
     if ( !pDejected->IsDejected() )
         return false;
 
-    CPlayer *pHelping = ToInPlayer( GetDataMemoryEntity( "DejectedFriend" ) );
+    CPlayer *pHelping = ToInPlayer( GetDataMemoryEntity( MEMORY_DEJECTED_FRIEND ) );
 
     if ( pHelping ) {
         // We must help him!
@@ -598,6 +722,18 @@ bool CBotDecision::ShouldHelpDejectedFriend( CPlayer *pDejected ) const
 // Returns if bot is low health and must be hidden
 //================================================================================
 bool CBotDecision::IsLowHealth() const
+{
+    bool value;
+
+    if ( GetMemo( BOT_MEMO_IS_LOW_HEALTH, value ) )
+        return value;
+
+    return SetMemo( BOT_MEMO_IS_LOW_HEALTH, EvaluateIsLowHealth() );
+}
+
+//================================================================================
+//================================================================================
+bool CBotDecision::EvaluateIsLowHealth() const
 {
     int lowHealth = 30;
 
@@ -624,6 +760,18 @@ bool CBotDecision::IsLowHealth() const
 // Returns if the bot can move
 //================================================================================
 bool CBotDecision::CanMove() const
+{
+    bool value;
+
+    if ( GetMemo( BOT_MEMO_CAN_MOVE, value ) )
+        return value;
+
+    return SetMemo( BOT_MEMO_CAN_MOVE, EvaluateCanMove() );
+}
+
+//================================================================================
+//================================================================================
+bool CBotDecision::EvaluateCanMove() const
 {
     if ( HasCondition( BCOND_DEJECTED ) )
         return false;
@@ -645,6 +793,18 @@ bool CBotDecision::CanMove() const
 //================================================================================
 //================================================================================
 bool CBotDecision::IsUsingFiregun() const
+{
+    bool value;
+
+    if ( GetMemo( BOT_MEMO_IS_USING_FIREGUN, value ) )
+        return value;
+
+    return SetMemo( BOT_MEMO_IS_USING_FIREGUN, EvaluateIsUsingFiregun() );
+}
+
+//================================================================================
+//================================================================================
+bool CBotDecision::EvaluateIsUsingFiregun() const
 {
     CBaseWeapon *pWeapon = GetHost()->GetActiveBaseWeapon();
 
@@ -657,6 +817,18 @@ bool CBotDecision::IsUsingFiregun() const
 //================================================================================
 //================================================================================
 bool CBotDecision::CanAttack() const
+{
+    bool value;
+
+    if ( GetMemo( BOT_MEMO_CAN_ATTACK, value ) )
+        return value;
+
+    return SetMemo( BOT_MEMO_CAN_ATTACK, EvaluateCanAttack() );
+}
+
+//================================================================================
+//================================================================================
+bool CBotDecision::EvaluateCanAttack() const
 {
     // Returns if Bot has the ability to attack
     if ( bot_dont_attack.GetBool() )
@@ -700,22 +872,32 @@ bool CBotDecision::ShouldCrouchAttack() const
     Vector vecEyePosition = GetHost()->GetAbsOrigin();
     vecEyePosition.z += VEC_DUCK_VIEW.z;
 
-    CBulletsTraceFilter traceFilter( COLLISION_GROUP_NONE );
-    traceFilter.SetPassEntity( GetHost() );
-
     Vector vecForward;
     GetHost()->GetVectors( &vecForward, NULL, NULL );
 
-    trace_t tr;
-    UTIL_TraceLine( vecEyePosition, vecEyePosition + vecForward * 3000.0f, MASK_SHOT, &traceFilter, &tr );
+    // Without trace budget we use the previous answer, only if it was
+    // for a close line (same direction within ~8 degrees) and the same target
+    if ( !Bot_CanTrace( BOT_TRACE_CROUCH_ATTACK ) ) {
+        if ( !IsSameTraceQuestion( m_vecCrouchAttackStart, vecEyePosition ) || DotProduct( m_vecCrouchAttackForward, vecForward ) < 0.99f || m_hCrouchAttackTarget.Get() != memory->GetEntity() )
+            return false;
 
-    if ( tr.m_pEnt == memory->GetEntity() ) {
-        //NDebugOverlay::Line( tr.startpos, tr.endpos, 0, 255, 0, true, 0.5f );
-        return true;
+        return m_bCrouchAttack;
     }
 
-    //NDebugOverlay::Line( tr.startpos, tr.endpos, 255, 0, 0, true, 0.5f );
-    return false;
+    m_vecCrouchAttackStart = vecEyePosition;
+    m_vecCrouchAttackForward = vecForward;
+    m_hCrouchAttackTarget = memory->GetEntity();
+
+    CBulletsTraceFilter traceFilter( COLLISION_GROUP_NONE );
+    traceFilter.SetPassEntity( GetHost() );
+
+    trace_t tr;
+    Bot_TraceLine( BOT_TRACE_CROUCH_ATTACK, vecEyePosition, vecEyePosition + vecForward * 3000.0f, MASK_SHOT, &traceFilter, &tr );
+
+    m_bCrouchAttack = (tr.m_pEnt == memory->GetEntity());
+
+    //NDebugOverlay::Line( tr.startpos, tr.endpos, 0, 255, 0, true, 0.5f );
+    return m_bCrouchAttack;
 }
 
 //================================================================================
@@ -742,6 +924,8 @@ bool CBotDecision::IsSelf( CBaseEntity * pEntity ) const
 }
 
 //================================================================================
+// Returns if [pIdeal] is a better enemy than [pPrevious]
+// By default the enemy with the highest threat score is better.
 //================================================================================
 bool CBotDecision::IsBetterEnemy( CBaseEntity * pIdeal, CBaseEntity * pPrevious ) const
 {
@@ -751,43 +935,46 @@ bool CBotDecision::IsBetterEnemy( CBaseEntity * pIdeal, CBaseEntity * pPrevious
     if ( pPrevious == NULL )
         return true;
 
-    if ( !GetProfile()->IsEasiest() ) {
-        if ( GetDecision()->IsAbleToSee( pIdeal ) && !GetDecision()->IsAbleToSee( pPrevious ) )
-            return true;
-    }
+    return (GetThreatScore( pIdeal ) > GetThreatScore( pPrevious ));
+}
 
-    int previousPriority = GetHost()->IRelationPriority( pPrevious );
-    int idealPriority = GetHost()->IRelationPriority( pIdeal );
+//================================================================================
+// Returns how much we want to attack the enemy, the memory picks
+// the enemy with the highest score as the ideal threat (see UpdateIdealThreat)
+// From most to least important: 
+// Visible, relationship priority, very close, dangerous and distance.
+//================================================================================
+float CBotDecision::GetThreatScore( CBaseEntity *pEnemy ) const
+{
+    if ( pEnemy == NULL )
+        return 0.0f;
 
-    float flPreviousDistance = pPrevious->GetAbsOrigin().DistTo( GetHost()->GetAbsOrigin() );
-    float flIdealDistance = pIdeal->GetAbsOrigin().DistTo( GetHost()->GetAbsOrigin() );
+    CEntityMemory *memory = (GetMemory()) ? GetMemory()->GetEntityMemory( pEnemy ) : NULL;
 
-    // The enemy to compare is further away
-    if ( flIdealDistance > flPreviousDistance ) {
-        // But has more priority
-        if ( idealPriority > previousPriority )
-            return true;
+    // We use what we know about the enemy in this tick instead of tracing again,
+    // without memory the ray goes through the visibility service (see IsAbleToSee)
+    bool visible = (memory) ? memory->IsVisible() : IsAbleToSee( pEnemy );
+    float distance = (memory) ? memory->GetDistance() : pEnemy->GetAbsOrigin().DistTo( GetHost()->GetAbsOrigin() );
 
-        return false;
-    }
+    float score = 0.0f;
 
-    // Has more priority
-    if ( idealPriority > previousPriority )
-        return true;
+    if ( visible && !GetProfile()->IsEasiest() )
+        score += 1000000.0f;
+
+    score += clamp( GetHost()->IRelationPriority( pEnemy ), -9, 90 ) * 10000.0f;
 
     // We certainly give priority to enemies very close
-    if ( flIdealDistance <= 200.0f )
-        return true;
+    if ( distance <= 200.0f )
+        score += 5000.0f;
 
     // Is more dangerous!
-    if ( IsDangerousEnemy( pIdeal ) && !IsDangerousEnemy( pPrevious ) )
-        return true;
+    if ( IsDangerousEnemy( pEnemy ) )
+        score += 2000.0f;
 
-    // It is the enemy of some member of the squadron
-    //if ( GetBot()->GetSquad() && GetBot()->GetSquad()->IsSquadEnemy( pIdeal, GetHost() ) )
-        //return true;
+    // The closer the better
+    score += 1000.0f * (1.0f - (MIN( distance, 10000.0f ) / 10000.0f));
 
-    return false;
+    return score;
 }
 
 //================================================================================
@@ -802,6 +989,18 @@ bool CBotDecision::IsDangerousEnemy( CBaseEntity *pEnemy ) const
     if ( pEnemy == NULL )
         return false;
 
+    bool value;
+
+    if ( GetMemo( BOT_MEMO_IS_DANGEROUS_ENEMY, value, pEnemy ) )
+        return value;
+
+    return SetMemo( BOT_MEMO_IS_DANGEROUS_ENEMY, EvaluateIsDangerousEnemy( pEnemy ), pEnemy );
+}
+
+//================================================================================
+//================================================================================
+bool CBotDecision::EvaluateIsDangerousEnemy( CBaseEntity *pEnemy ) const
+{
     if ( pEnemy->IsPlayer() ) {
         CPlayer *pPlayer = ToInPlayer( pEnemy );
 
@@ -864,7 +1063,7 @@ bool CBotDecision::ShouldMustBeCareful() const
     if ( GetProfile()->IsEasiest() )
         return false;
 
-    if ( GetDataMemoryInt("NearbyDangerousThreats") >= 2 )
+    if ( GetDataMemoryInt(MEMORY_NEARBY_DANGEROUS_THREATS) >= 2 )
         return true;
 
     if ( IsDangerousEnemy() )
@@ -1201,22 +1400,53 @@ BCOND CBotDecision::ShouldMeleeAttack2()
 //================================================================================
 bool CBotDecision::IsAbleToSee( CBaseEntity * entity, FieldOfViewCheckType checkFOV ) const
 {
-    if ( entity->MyCombatCharacterPointer() ) {
-        return GetHost()->IsAbleToSee( entity->MyCombatCharacterPointer(), (CBaseCombatCharacter::FieldOfViewCheckType)checkFOV );
-    }
+    // The field of view changes every time we aim, it is not cached
+    if ( checkFOV == USE_FOV && !IsInFieldOfView( entity ) )
+        return false;
+
+    CBotSightCache *pCache = GetBot()->GetSightCache();
+    Vector vecEyes = GetHost()->EyePosition();
+    Vector vecTarget = entity->WorldSpaceCenter();
+    bool visible;
+
+    if ( pCache->Find( PERCEPTION_VISIBILITY, entity, vecEyes, vecTarget, visible ) )
+        return visible;
+
+    // The trace goes through the world of the bots (see IBotWorld)
+    visible = Bot_IsVisibilityClear( GetHost(), vecEyes, vecTarget, entity );
 
-    return GetHost()->IsAbleToSee( entity, (CBaseCombatCharacter::FieldOfViewCheckType)checkFOV );
+    pCache->Store( PERCEPTION_VISIBILITY, entity, vecEyes, vecTarget, visible );
+    return visible;
 }
 
 //================================================================================
 //================================================================================
 bool CBotDecision::IsAbleToSee( const Vector & pos, FieldOfViewCheckType checkFOV ) const
 {
-#ifdef INSOURCE_DLL
-    return GetHost()->IsAbleToSee( pos, (CBaseCombatCharacter::FieldOfViewCheckType)checkFOV );
-#else
-    return (GetHost()->FVisible( pos ) && GetHost()->IsInFieldOfView( pos ));
-#endif
+    // The trace was already done in the perception stage
+    const PerceptionQuery_t *query = GetBot()->GetPerception()->GetResult( PERCEPTION_VISIBILITY, GetHost()->EyePosition(), pos );
+
+    if ( query ) {
+        if ( !query->clear )
+            return false;
+
+        return (checkFOV == DISREGARD_FOV || IsInFieldOfView( pos ));
+    }
+
+    if ( checkFOV == USE_FOV && !IsInFieldOfView( pos ) )
+        return false;
+
+    CBotSightCache *pCache = GetBot()->GetSightCache();
+    Vector vecEyes = GetHost()->EyePosition();
+    bool visible;
+
+    if ( pCache->Find( PERCEPTION_VISIBILITY, NULL, vecEyes, pos, visible ) )
+        return visible;
+
+    visible = Bot_IsVisibilityClear( GetHost(), vecEyes, pos );
+
+    pCache->Store( PERCEPTION_VISIBILITY, NULL, vecEyes, pos, visible );
+    return visible;
 }
 
 //================================================================================
@@ -1255,14 +1485,29 @@ bool CBotDecision::IsLineOfSightClear( const Vector & pos, CBaseEntity * entityT
     if ( !IsAbleToSee( pos ) )
         return false;
 
+    // The trace was already done in the perception stage
+    const PerceptionQuery_t *query = GetBot()->GetPerception()->GetResult( PERCEPTION_LINE_OF_FIRE, GetHost()->EyePosition(), pos );
+
+    if ( query && query->pIgnore == entityToIgnore ) {
+        if ( hit ) *hit = query->pHit;
+        return query->clear;
+    }
+
+    // The line of fire is not cached (see CBotSightCache),
+    // a friend can walk in front of us at any moment.
+    // It is a critical trace, the budget does not stop us from firing.
+    Vector vecEyes = GetHost()->EyePosition();
+
     // We draw a line pretending to be the bullets
     CBulletsTraceFilter traceFilter( COLLISION_GROUP_NONE );
     traceFilter.AddEntityToIgnore( GetHost() );
     traceFilter.AddEntityToIgnore( entityToIgnore );
 
     trace_t tr;
-    UTIL_TraceLine( GetHost()->EyePosition(), pos, MASK_SHOT, &traceFilter, &tr );
+    Bot_TraceLine( BOT_TRACE_LINE_OF_SIGHT, vecEyes, pos, MASK_SHOT, &traceFilter, &tr );
+
+    bool clear = (tr.fraction == 1.0f);
 
-    *hit = tr.m_pEnt;
-    return (tr.fraction == 1.0f);
+    if ( hit ) *hit = tr.m_pEnt;
+    return clear;
 }
@@ -5,6 +5,8 @@
 
 #include "cbase.h"
 #include "bots\bot.h"
+#include "bots\bot_profiler.h"
+#include "bots\bot_timeline.h"
 
 #ifdef INSOURCE_DLL
 #include "in_utils.h"
@@ -240,7 +242,8 @@ bool CBotLocomotion::ShouldComputePath()
         return true;
 
     // Building a path is very expensive for the engine, we limit this to once every 3s.
-    if ( GetPath()->GetElapsedTimeSinceBuild() < 3.0f )
+    // (or more with a lower level of detail)
+    if ( GetPath()->GetElapsedTimeSinceBuild() < GetBot()->GetLevelOfDetailInfo().pathInterval )
         return false;
 
     if ( IsStuck() && GetStuckDuration() >= 4.0f )
@@ -282,6 +285,9 @@ void CBotLocomotion::ComputePath()
     CSimpleBotPathCost cost( GetBot() );
 
     GetPathFollower()->Reset();
+
+    BOT_TIMELINE_SCOPE( "CNavPath::Compute", "Navigation" );
+    TheBotProfiler->CountPath();
     GetPath()->Compute( from, to, cost );
 }
 
@@ -324,7 +330,7 @@ CBaseEntity * CBotLocomotion::GetGround() const
     vecFloor.z -= 100.0f;
 
     trace_t tr;
-    UTIL_TraceLine( GetFeet(), vecFloor, MASK_SOLID, GetHost(), COLLISION_GROUP_NONE, &tr );
+    Bot_TraceLine( BOT_TRACE_GROUND, GetFeet(), vecFloor, MASK_SOLID, GetHost(), COLLISION_GROUP_NONE, &tr );
 
     // TODO: Something better?
     return tr.m_pEnt;
@@ -341,7 +347,7 @@ Vector & CBotLocomotion::GetGroundNormal() const
     vecFloor.z -= 100.0f;
 
     trace_t tr;
-    UTIL_TraceLine( GetFeet(), vecFloor, MASK_SOLID, GetHost(), COLLISION_GROUP_NONE, &tr );
+    Bot_TraceLine( BOT_TRACE_GROUND, GetFeet(), vecFloor, MASK_SOLID, GetHost(), COLLISION_GROUP_NONE, &tr );
 
     // TODO: Something better?
     return tr.plane.normal;
@@ -521,7 +527,7 @@ CNavArea *CBotLocomotion::GetLastKnownArea() const
 //================================================================================
 bool CBotLocomotion::GetSimpleGroundHeightWithFloor( const Vector &pos, float *height, Vector *normal )
 {
-    if ( TheNavMesh->GetSimpleGroundHeight( pos, height, normal ) ) {
+    if ( TheBotWorld->GetSimpleGroundHeight( pos, height, normal ) ) {
         // our current nav area also serves as a ground polygon
         if ( GetLastKnownArea() && GetLastKnownArea()->IsOverlapping( pos ) ) {
             *height = MAX( (*height), GetLastKnownArea()->GetZ( pos ) );
@@ -21,6 +21,33 @@
 // memdbgon must be the last include file in a .cpp file!!!
 #include "tier0/memdbgon.h"
 
+// Returned by GetDataMemoryOrEmpty when the memory does not exist,
+// it is shared by all the bots so nobody can modify it.
+static const CDataMemory s_EmptyDataMemory;
+
+//================================================================================
+// The records go back to the pool, their timers are stopped first
+// or the next entity that gets the record would stop a handle of another timer.
+//================================================================================
+void CBotMemory::Reset()
+{
+    FOR_EACH_VEC( m_Memory, it )
+    {
+        m_Memory[it]->StopTimers();
+    }
+
+    FOR_EACH_MAP_FAST( m_DataMemory, it )
+    {
+        TheBots->GetTimers()->Remove( m_DataMemory[it]->GetExpireTimer() );
+    }
+
+    for ( int it = 0; it < LAST_BOT_MEMORY; ++it ) {
+        TheBots->GetTimers()->Remove( m_Blackboard[it].GetExpireTimer() );
+    }
+
+    BaseClass::Reset();
+}
+
 //================================================================================
 //================================================================================
 void CBotMemory::Update()
@@ -44,24 +71,11 @@ void CBotMemory::UpdateMemory()
     int nearbyFriends = 0;
     int nearbyDangerousThreats = 0;
 
-    UpdateDataMemory( "NearbyThreats", 0 );
-    UpdateDataMemory( "NearbyFriends", 0 );
-    UpdateDataMemory( "NearbyDangerousThreats", 0 );
+    // The expired data memories are forgotten by their timer (see OnTimerExpired)
 
-    FOR_EACH_MAP_FAST( m_DataMemory, it )
-    {
-        CDataMemory *memory = m_DataMemory[it];
-        Assert( memory );
+    UpdateSquadMemory();
 
-        if ( memory->IsExpired() ) {
-            m_DataMemory.RemoveAt( it );
-            delete memory;
-            memory = NULL;
-            continue;
-        }
-    }
-
-    FOR_EACH_MAP_FAST( m_Memory, it )
+    FOR_EACH_ENTITY_MEMORY( it )
     {
         CEntityMemory *memory = m_Memory[it];
         Assert( memory );
@@ -77,27 +91,32 @@ void CBotMemory::UpdateMemory()
         // New frame, we need to recheck if we can see it.
         memory->UpdateVisibility( false );
 
-        if ( !memory->IsLost() ) {
+        // The team and the relationship can change, we refresh them once per tick
+        m_MemoryTeam[it] = pEntity->GetTeamNumber();
+        m_MemoryRelation[it] = GetRelation( pEntity );
+        m_MemoryValid[it] = (memory->IsLost()) ? 0 : 1;
+
+        if ( m_MemoryValid[it] ) {
             // The last known position of this entity is close to us.
             // We mark how many allied/enemy entities are close to us to make better decisions.
             if ( memory->IsInRange( m_flNearbyDistance ) ) {
-                if ( memory->IsEnemy() ) {
+                if ( m_MemoryRelation[it] == BOT_MEMORY_ENEMY ) {
                     if ( GetDecision()->IsDangerousEnemy( pEntity ) ) {
                         ++nearbyDangerousThreats;
                     }
 
                     ++nearbyThreats;
                 }
-                else if ( memory->IsFriend() ) {
+                else if ( m_MemoryRelation[it] == BOT_MEMORY_FRIEND ) {
                     ++nearbyFriends;
                 }
             }
         }
     }
 
-    UpdateDataMemory( "NearbyThreats", nearbyThreats );
-    UpdateDataMemory( "NearbyFriends", nearbyFriends );
-    UpdateDataMemory( "NearbyDangerousThreats", nearbyDangerousThreats );
+    UpdateDataMemory( MEMORY_NEARBY_THREATS, nearbyThreats );
+    UpdateDataMemory( MEMORY_NEARBY_FRIENDS, nearbyFriends );
+    UpdateDataMemory( MEMORY_NEARBY_DANGEROUS_THREATS, nearbyDangerousThreats );
 
     // We see, we smell, we feel
     if ( GetHost()->GetSenses() ) {
@@ -107,12 +126,17 @@ void CBotMemory::UpdateMemory()
 
 //================================================================================
 // Update who should be our main threat.
+// Each enemy is scored once and IsBetterEnemy has the last word
+// between the two enemies with the highest score.
 //================================================================================
 void CBotMemory::UpdateIdealThreat()
 {
     CEntityMemory *pIdeal = NULL;
+    CEntityMemory *pSecond = NULL;
+    float bestScore = 0.0f;
+    float secondScore = 0.0f;
 
-   FOR_EACH_MAP_FAST( m_Memory, it )
+    FOR_EACH_ENTITY_MEMORY( it )
     {
         CEntityMemory *memory = m_Memory[it];
         Assert( memory );
@@ -120,17 +144,32 @@ void CBotMemory::UpdateIdealThreat()
         if ( memory->IsLost() )
             continue;
 
-        if ( !memory->IsEnemy() )
+        // The relationship was refreshed in UpdateMemory
+        if ( m_MemoryRelation[it] != BOT_MEMORY_ENEMY )
             continue;
 
         CBaseEntity *pEnt = memory->GetEntity();
         Assert( pEnt );
 
-        if ( !pIdeal || GetDecision()->IsBetterEnemy( pEnt, pIdeal->GetEntity() ) ) {
+        float score = GetDecision()->GetThreatScore( pEnt );
+
+        if ( !pIdeal || score > bestScore ) {
+            pSecond = pIdeal;
+            secondScore = bestScore;
             pIdeal = memory;
+            bestScore = score;
+        }
+        else if ( !pSecond || score > secondScore ) {
+            pSecond = memory;
+            secondScore = score;
         }
     }
 
+    // A mod can rank the enemies with its own IsBetterEnemy
+    if ( pSecond && GetDecision()->IsBetterEnemy( pSecond->GetEntity(), pIdeal->GetEntity() ) ) {
+        pIdeal = pSecond;
+    }
+
     m_pIdealThreat = pIdeal;
 }
 
@@ -271,8 +310,7 @@ CEntityMemory * CBotMemory::UpdateEntityMemory( CBaseEntity * pEnt, const Vector
     }
 
     if ( !memory ) {
-        memory = new CEntityMemory( GetBot(), pEnt, pInformer );
-        m_Memory.Insert( pEnt->entindex(), memory );
+        memory = AllocEntityMemory( pEnt, pInformer );
     }
 
     memory->UpdatePosition( vecPosition );
@@ -282,19 +320,192 @@ CEntityMemory * CBotMemory::UpdateEntityMemory( CBaseEntity * pEnt, const Vector
     return memory;
 }
 
+//================================================================================
+// Reads the enemies that our squad has reported since the last time.
+// The table of the squad is the only copy of their positions, our memory
+// keeps the enemies that we have seen (our own visibility) and, when we have
+// no enemy, the closest enemy of the table so we can hunt it.
+// The position reported by a friend always has a margin of error,
+// a human can not know the exact position until seeing it with his own eyes.
+//================================================================================
+void CBotMemory::UpdateSquadMemory()
+{
+    VPROF_BUDGET( "CBotMemory::UpdateSquadMemory", VPROF_BUDGETGROUP_BOTS );
+
+    CSquad *pSquad = GetBot()->GetSquad();
+
+    if ( pSquad != m_pThreatSquad ) {
+        m_pThreatSquad = pSquad;
+        m_iThreatSequence = 0;
+    }
+
+    if ( !pSquad || pSquad->GetThreatSequence() == m_iThreatSequence )
+        return;
+
+    const SquadThreat_t *pClosest = NULL;
+    float closestDistance = FLT_MAX;
+
+    for ( int it = 0; it < pSquad->GetThreatCount(); ++it ) {
+        const SquadThreat_t &threat = pSquad->GetThreat( it );
+
+        if ( threat.sequence <= m_iThreatSequence )
+            continue;
+
+        CBaseEntity *pEnemy = threat.entity.Get();
+        CPlayer *pReporter = ToInPlayer( threat.reporter.Get() );
+
+        // We have reported it
+        if ( !pEnemy || !pReporter || pReporter == GetHost() )
+            continue;
+
+        GetBot()->OnMemberReportEnemy( pReporter, pEnemy );
+
+        // We remember it, the new position is only needed if we can not see it
+        // (UpdateEntityMemory ignores the informers of the visible enemies)
+        if ( GetEntityMemory( pEnemy ) ) {
+            UpdateEntityMemory( pEnemy, GetEstimatedPosition( threat.position ), pReporter );
+            continue;
+        }
+
+        if ( GetPrimaryThreat() )
+            continue;
+
+        float distance = GetHost()->GetAbsOrigin().DistToSqr( threat.position );
+
+        if ( distance < closestDistance ) {
+            pClosest = &threat;
+            closestDistance = distance;
+        }
+    }
+
+    if ( pClosest ) {
+        UpdateEntityMemory( pClosest->entity.Get(), GetEstimatedPosition( pClosest->position ), pClosest->reporter.Get() );
+    }
+
+    m_iThreatSequence = pSquad->GetThreatSequence();
+}
+
+//================================================================================
+// Returns the position reported by a friend with a margin of error
+//================================================================================
+Vector CBotMemory::GetEstimatedPosition( const Vector &vecPosition ) const
+{
+    const float errorDistance = 100.0f;
+
+    Vector vecEstimated = vecPosition;
+    vecEstimated.x += RandomFloat( -errorDistance, errorDistance );
+    vecEstimated.y += RandomFloat( -errorDistance, errorDistance );
+
+    return vecEstimated;
+}
+
+//================================================================================
+// Returns a memory for the entity, taken from the pool if possible
+//================================================================================
+CEntityMemory *CBotMemory::AllocEntityMemory( CBaseEntity *pEnt, CBaseEntity *pInformer )
+{
+    int entindex = pEnt->entindex();
+
+    if ( entindex >= m_MemorySlots.Count() ) {
+        int first = m_MemorySlots.AddMultipleToTail( entindex - m_MemorySlots.Count() + 1 );
+
+        for ( int it = first; it < m_MemorySlots.Count(); ++it ) {
+            m_MemorySlots[it].memory = NULL;
+            m_MemorySlots[it].serial = 0;
+            m_MemorySlots[it].live = -1;
+        }
+    }
+
+    // The index was used by an entity that no longer exists
+    if ( m_MemorySlots[entindex].memory ) {
+        ForgetEntity( m_MemorySlots[entindex].live );
+    }
+
+    CEntityMemory *memory = NULL;
+
+    if ( m_MemoryPool.Count() > 0 ) {
+        memory = m_MemoryPool.Tail();
+        m_MemoryPool.RemoveMultipleFromTail( 1 );
+        memory->Init( GetBot(), pEnt, pInformer );
+    }
+    else {
+        BOT_COUNT_ALLOCATION();
+        memory = new CEntityMemory( GetBot(), pEnt, pInformer );
+    }
+
+    BotMemorySlot_t &slot = m_MemorySlots[entindex];
+    slot.memory = memory;
+    slot.serial = pEnt->GetRefEHandle().GetSerialNumber();
+    slot.live = m_Memory.AddToTail( memory );
+
+    // Hot fields, the position and the times are set by SyncEntityMemory
+    m_MemoryPositionX.AddToTail( 0.0f );
+    m_MemoryPositionY.AddToTail( 0.0f );
+    m_MemoryPositionZ.AddToTail( 0.0f );
+    m_MemoryLastUpdate.AddToTail( -1.0f );
+    m_MemoryLastVisible.AddToTail( -1.0f );
+    m_MemoryTeam.AddToTail( pEnt->GetTeamNumber() );
+    m_MemoryRelation.AddToTail( GetRelation( pEnt ) );
+    m_MemoryValid.AddToTail( 0 );
+
+    return memory;
+}
+
+//================================================================================
+// Copies the hot fields of the memory to the arrays used by the queries
+//================================================================================
+void CBotMemory::SyncEntityMemory( CEntityMemory *memory )
+{
+    int entindex = memory->GetEntityIndex();
+
+    if ( entindex < 0 || entindex >= m_MemorySlots.Count() )
+        return;
+
+    int index = m_MemorySlots[entindex].live;
+
+    if ( !m_Memory.IsValidIndex( index ) || m_Memory[index] != memory )
+        return;
+
+    const Vector &position = memory->GetLastKnownPosition();
+
+    m_MemoryPositionX[index] = position.x;
+    m_MemoryPositionY[index] = position.y;
+    m_MemoryPositionZ[index] = position.z;
+    m_MemoryLastUpdate[index] = memory->GetTimeLastUpdate();
+    m_MemoryLastVisible[index] = memory->GetTimeLastVisible();
+    m_MemoryValid[index] = (memory->IsLost()) ? 0 : 1;
+}
+
+//================================================================================
+//================================================================================
+byte CBotMemory::GetRelation( CBaseEntity *pEntity ) const
+{
+    if ( GetDecision()->IsEnemy( pEntity ) )
+        return BOT_MEMORY_ENEMY;
+
+    if ( GetDecision()->IsFriend( pEntity ) )
+        return BOT_MEMORY_FRIEND;
+
+    return BOT_MEMORY_NEUTRAL;
+}
+
 //================================================================================
 // Removes the entity from memory
 //================================================================================
 void CBotMemory::ForgetEntity( CBaseEntity * pEnt )
 {
-    int index = m_Memory.Find( pEnt->entindex() );
-    ForgetEntity( index );
+    CEntityMemory *memory = GetEntityMemory( pEnt );
+
+    if ( !memory )
+        return;
+
+    ForgetEntity( m_MemorySlots[memory->GetEntityIndex()].live );
 }
 
 //================================================================================
 // Removes index from memory
 // Notes:
-// 1. It is the index in the array, not the index of the entity.
+// 1. It is the index in the list of live memories, not the index of the entity.
 // 2. Always use this function to safely remove an entity from memory and its known pointers.
 //================================================================================
 void CBotMemory::ForgetEntity( int index )
@@ -305,8 +516,26 @@ void CBotMemory::ForgetEntity( int index )
     CEntityMemory *memory = m_Memory.Element( index );
     Assert( memory );
 
-    // Remove from array
-    m_Memory.RemoveAt( index );
+    // Remove from the list, the last memory takes its place
+    m_Memory.FastRemove( index );
+    m_MemoryPositionX.FastRemove( index );
+    m_MemoryPositionY.FastRemove( index );
+    m_MemoryPositionZ.FastRemove( index );
+    m_MemoryLastUpdate.FastRemove( index );
+    m_MemoryLastVisible.FastRemove( index );
+    m_MemoryTeam.FastRemove( index );
+    m_MemoryRelation.FastRemove( index );
+    m_MemoryValid.FastRemove( index );
+
+    if ( m_Memory.IsValidIndex( index ) ) {
+        m_MemorySlots[m_Memory[index]->GetEntityIndex()].live = index;
+    }
+
+    BotMemorySlot_t &slot = m_MemorySlots[memory->GetEntityIndex()];
+    slot.memory = NULL;
+    slot.live = -1;
+
+    memory->StopTimers();
 
     // We check and set null all known pointers
     // Ivn: Noob question...
@@ -325,9 +554,8 @@ void CBotMemory::ForgetEntity( int index )
 
     DevMsg(2, "Deleting index %i from memory...\n", index);
 
-    // Delete pointer ???
-    delete memory;
-    memory = NULL;
+    // The record will be used for another entity
+    m_MemoryPool.AddToTail( memory );
 }
 
 //================================================================================
@@ -353,19 +581,28 @@ CEntityMemory * CBotMemory::GetEntityMemory( CBaseEntity * pEnt ) const
     if ( pEnt == NULL )
         return NULL;
 
-    return GetEntityMemory( pEnt->entindex() );
+    int entindex = pEnt->entindex();
+
+    if ( entindex < 0 || entindex >= m_MemorySlots.Count() )
+        return NULL;
+
+    const BotMemorySlot_t &slot = m_MemorySlots[entindex];
+
+    // The memory is from another entity that used the same index
+    if ( slot.memory && slot.serial != pEnt->GetRefEHandle().GetSerialNumber() )
+        return NULL;
+
+    return slot.memory;
 }
 
 //================================================================================
 //================================================================================
 CEntityMemory * CBotMemory::GetEntityMemory( int entindex ) const
 {
-    int index = m_Memory.Find( entindex );
-
-    if ( !m_Memory.IsValidIndex( index ) )
+    if ( entindex < 0 || entindex >= m_MemorySlots.Count() )
         return NULL;
 
-    return m_Memory.Element( index );
+    return m_MemorySlots[entindex].memory;
 }
 
 //================================================================================
@@ -376,61 +613,65 @@ float CBotMemory::GetMemoryDuration() const
 }
 
 //================================================================================
+// Returns the index of the closest live memory with the relationship or team (-1 = Any)
 //================================================================================
-CEntityMemory * CBotMemory::GetClosestThreat( float *distance ) const
+int CBotMemory::FindClosestMemory( int relation, int teamnum, float *distance ) const
 {
-    float closest = MAX_TRACE_LENGTH;
-    CEntityMemory *closestMemory = NULL;
+    const Vector &vecOrigin = GetHost()->GetAbsOrigin();
+    float expireTime = TheBotWorld->GetTime() - GetMemoryDuration();
 
-    FOR_EACH_MAP_FAST( m_Memory, it )
-    {
-        CEntityMemory *memory = m_Memory[it];
-        Assert( memory );
+    float closest = MAX_TRACE_LENGTH * MAX_TRACE_LENGTH;
+    int closestIndex = -1;
 
-        if ( memory->IsLost() )
+    for ( int it = 0; it < m_Memory.Count(); ++it ) {
+        if ( !m_MemoryValid[it] || m_MemoryLastUpdate[it] <= expireTime )
+            continue;
+
+        if ( relation != -1 && m_MemoryRelation[it] != relation )
             continue;
 
-        if ( !memory->IsEnemy() )
+        if ( teamnum != -1 && m_MemoryTeam[it] != teamnum )
             continue;
 
-        float distance = memory->GetDistance();
+        float dx = m_MemoryPositionX[it] - vecOrigin.x;
+        float dy = m_MemoryPositionY[it] - vecOrigin.y;
+        float dz = m_MemoryPositionZ[it] - vecOrigin.z;
+        float distanceSqr = dx * dx + dy * dy + dz * dz;
 
-        if ( distance < closest ) {
-            closest = distance;
-            closestMemory = memory;
+        if ( distanceSqr < closest ) {
+            closest = distanceSqr;
+            closestIndex = it;
         }
     }
 
     if ( distance ) {
-        distance = &closest;
+        *distance = FastSqrt( closest );
     }
 
-    return closestMemory;
+    return closestIndex;
 }
 
 //================================================================================
+// Returns the number of live memories with the relationship or team (-1 = Any) in the range (-1 = Any)
 //================================================================================
-int CBotMemory::GetThreatCount( float range ) const
+int CBotMemory::CountMemories( int relation, int teamnum, float range ) const
 {
+    const Vector &vecOrigin = GetHost()->GetAbsOrigin();
+    float expireTime = TheBotWorld->GetTime() - GetMemoryDuration();
+    float rangeSqr = (range < 0.0f) ? FLT_MAX : (range * range);
     int count = 0;
-    
-    FOR_EACH_MAP_FAST( m_Memory, it )
-    {
-        CEntityMemory *memory = m_Memory[it];
-        Assert( memory );
 
-        if ( memory->IsLost() )
-            continue;
+    for ( int it = 0; it < m_Memory.Count(); ++it ) {
+        float dx = m_MemoryPositionX[it] - vecOrigin.x;
+        float dy = m_MemoryPositionY[it] - vecOrigin.y;
+        float dz = m_MemoryPositionZ[it] - vecOrigin.z;
 
-        if ( !memory->IsEnemy() )
-            continue;
+        bool valid = (m_MemoryValid[it] != 0 && m_MemoryLastUpdate[it] > expireTime);
+        valid &= (relation == -1 || m_MemoryRelation[it] == relation);
+        valid &= (teamnum == -1 || m_MemoryTeam[it] == teamnum);
+        valid &= (dx * dx + dy * dy + dz * dz <= rangeSqr);
 
-        float distance = memory->GetDistance();
-
-        if ( distance > range )
-            continue;
-
-        ++count;
+        count += (valid) ? 1 : 0;
     }
 
     return count;
@@ -438,194 +679,78 @@ int CBotMemory::GetThreatCount( float range ) const
 
 //================================================================================
 //================================================================================
-int CBotMemory::GetThreatCount() const
+CEntityMemory * CBotMemory::GetClosestThreat( float *distance ) const
 {
-    int count = 0;
-
-    FOR_EACH_MAP_FAST( m_Memory, it )
-    {
-        CEntityMemory *memory = m_Memory[it];
-        Assert( memory );
-
-        if ( memory->IsLost() )
-            continue;
-
-        if ( !memory->IsEnemy() )
-            continue;
+    int index = FindClosestMemory( BOT_MEMORY_ENEMY, -1, distance );
+    return (index == -1) ? NULL : m_Memory[index];
+}
 
-        ++count;
-    }
+//================================================================================
+//================================================================================
+int CBotMemory::GetThreatCount( float range ) const
+{
+    return CountMemories( BOT_MEMORY_ENEMY, -1, range );
+}
 
-    return count;
+//================================================================================
+//================================================================================
+int CBotMemory::GetThreatCount() const
+{
+    return CountMemories( BOT_MEMORY_ENEMY, -1, -1.0f );
 }
 
 //================================================================================
 //================================================================================
 CEntityMemory * CBotMemory::GetClosestFriend( float *distance ) const
 {
-    float closest = MAX_TRACE_LENGTH;
-    CEntityMemory *closestMemory = NULL;
-
-    FOR_EACH_MAP_FAST( m_Memory, it )
-    {
-        CEntityMemory *memory = m_Memory[it];
-        Assert( memory );
-
-        if ( memory->IsLost() )
-            continue;
-
-        if ( !memory->IsFriend() )
-            continue;
-
-        float distance = memory->GetDistance();
-
-        if ( distance < closest ) {
-            closest = distance;
-            closestMemory = memory;
-        }
-    }
-
-    if ( distance ) {
-        distance = &closest;
-    }
-
-    return closestMemory;
+    int index = FindClosestMemory( BOT_MEMORY_FRIEND, -1, distance );
+    return (index == -1) ? NULL : m_Memory[index];
 }
 
 //================================================================================
 //================================================================================
 int CBotMemory::GetFriendCount( float range ) const
 {
-    int count = 0;
-
-    FOR_EACH_MAP_FAST( m_Memory, it )
-    {
-        CEntityMemory *memory = m_Memory[it];
-        Assert( memory );
-
-        if ( memory->IsLost() )
-            continue;
-
-        if ( !memory->IsFriend() )
-            continue;
-
-        float distance = memory->GetDistance();
-
-        if ( distance > range )
-            continue;
-
-        ++count;
-    }
-
-    return count;
+    return CountMemories( BOT_MEMORY_FRIEND, -1, range );
 }
 
 //================================================================================
 //================================================================================
 int CBotMemory::GetFriendCount() const
 {
-    int count = 0;
-
-    FOR_EACH_MAP_FAST( m_Memory, it )
-    {
-        CEntityMemory *memory = m_Memory[it];
-        Assert( memory );
-
-        if ( memory->IsLost() )
-            continue;
-
-        if ( !memory->IsFriend() )
-            continue;
-
-        ++count;
-    }
-
-    return count;
+    return CountMemories( BOT_MEMORY_FRIEND, -1, -1.0f );
 }
 
 //================================================================================
 //================================================================================
 CEntityMemory * CBotMemory::GetClosestKnown( int teamnum, float *distance ) const
 {
-    float closest = MAX_TRACE_LENGTH;
-    CEntityMemory *closestMemory = NULL;
-
-    FOR_EACH_MAP_FAST( m_Memory, it )
-    {
-        CEntityMemory *memory = m_Memory[it];
-        Assert( memory );
-
-        if ( memory->IsLost() )
-            continue;
-
-        if ( memory->GetEntity()->GetTeamNumber() != teamnum )
-            continue;
-
-        float distance = memory->GetDistance();
-
-        if ( distance < closest ) {
-            closest = distance;
-            closestMemory = memory;
-        }
-    }
-
-    if ( distance ) {
-        distance = &closest;
-    }
-
-    return closestMemory;
+    int index = FindClosestMemory( -1, teamnum, distance );
+    return (index == -1) ? NULL : m_Memory[index];
 }
 
 //================================================================================
 //================================================================================
 int CBotMemory::GetKnownCount( int teamnum, float range ) const
 {
-    int count = 0;
-
-    FOR_EACH_MAP_FAST( m_Memory, it )
-    {
-        CEntityMemory *memory = m_Memory[it];
-        Assert( memory );
-
-        if ( memory->IsLost() )
-            continue;
-
-        if ( memory->GetEntity()->GetTeamNumber() != teamnum )
-            continue;
-
-        float distance = memory->GetDistance();
-
-        if ( distance > range )
-            continue;
-
-        ++count;
-    }
-
-    return count;
+    return CountMemories( -1, teamnum, range );
 }
 
 //================================================================================
 //================================================================================
 float CBotMemory::GetTimeSinceVisible( int teamnum ) const
 {
+    float expireTime = TheBotWorld->GetTime() - GetMemoryDuration();
     float closest = -1.0f;
 
-    FOR_EACH_MAP_FAST( m_Memory, it )
-    {
-        CEntityMemory *memory = m_Memory[it];
-        Assert( memory );
-
-        if ( memory->IsLost() )
+    for ( int it = 0; it < m_Memory.Count(); ++it ) {
+        if ( !m_MemoryValid[it] || m_MemoryLastUpdate[it] <= expireTime )
             continue;
 
-        if ( memory->GetEntity()->GetTeamNumber() != teamnum )
+        if ( m_MemoryTeam[it] != teamnum )
             continue;
 
-        float time = memory->GetTimeLastVisible();
-
-        if ( time > closest ) {
-            closest = time;
-        }
+        closest = MAX( closest, m_MemoryLastVisible[it] );
     }
 
     return closest;
@@ -635,17 +760,23 @@ float CBotMemory::GetTimeSinceVisible( int teamnum ) const
 //================================================================================
 CDataMemory * CBotMemory::UpdateDataMemory( const char * name, const Vector & value, float forgetTime )
 {
+    BotMemoryKey key = GetMemoryKey( name );
+
+    if ( key != MEMORY_INVALID )
+        return UpdateDataMemory( key, value, forgetTime );
+
     CDataMemory *memory = GetDataMemory( name );
 
     if ( memory ) {
         memory->SetVector( value );
     }
     else {
+        BOT_COUNT_ALLOCATION();
         memory = new CDataMemory( value );
         m_DataMemory.Insert( AllocPooledString(name), memory );
     }
 
-    memory->ForgetIn( forgetTime );
+    SetExpiration( memory, LAST_BOT_MEMORY + m_DataMemory.Find( FindPooledString( name ) ), forgetTime );
     return memory;
 }
 
@@ -653,17 +784,23 @@ CDataMemory * CBotMemory::UpdateDataMemory( const char * name, const Vector & va
 //================================================================================
 CDataMemory * CBotMemory::UpdateDataMemory( const char * name, float value, float forgetTime )
 {
+    BotMemoryKey key = GetMemoryKey( name );
+
+    if ( key != MEMORY_INVALID )
+        return UpdateDataMemory( key, value, forgetTime );
+
     CDataMemory *memory = GetDataMemory( name );
 
     if ( memory ) {
         memory->SetFloat( value );
     }
     else {
+        BOT_COUNT_ALLOCATION();
         memory = new CDataMemory( value );
         m_DataMemory.Insert( AllocPooledString( name ), memory );
     }
 
-    memory->ForgetIn( forgetTime );
+    SetExpiration( memory, LAST_BOT_MEMORY + m_DataMemory.Find( FindPooledString( name ) ), forgetTime );
     return memory;
 }
 
@@ -671,17 +808,23 @@ CDataMemory * CBotMemory::UpdateDataMemory( const char * name, float value, floa
 //================================================================================
 CDataMemory * CBotMemory::UpdateDataMemory( const char * name, int value, float forgetTime )
 {
+    BotMemoryKey key = GetMemoryKey( name );
+
+    if ( key != MEMORY_INVALID )
+        return UpdateDataMemory( key, value, forgetTime );
+
     CDataMemory *memory = GetDataMemory( name );
 
     if ( memory ) {
         memory->SetInt( value );
     }
     else {
+        BOT_COUNT_ALLOCATION();
         memory = new CDataMemory( value );
         m_DataMemory.Insert( AllocPooledString( name ), memory );
     }
 
-    memory->ForgetIn( forgetTime );
+    SetExpiration( memory, LAST_BOT_MEMORY + m_DataMemory.Find( FindPooledString( name ) ), forgetTime );
     return memory;
 }
 
@@ -689,17 +832,23 @@ CDataMemory * CBotMemory::UpdateDataMemory( const char * name, int value, float
 //================================================================================
 CDataMemory * CBotMemory::UpdateDataMemory( const char * name, const char * value, float forgetTime )
 {
+    BotMemoryKey key = GetMemoryKey( name );
+
+    if ( key != MEMORY_INVALID )
+        return UpdateDataMemory( key, value, forgetTime );
+
     CDataMemory *memory = GetDataMemory( name );
 
     if ( memory ) {
         memory->SetString( value );
     }
     else {
+        BOT_COUNT_ALLOCATION();
         memory = new CDataMemory( value );
         m_DataMemory.Insert( AllocPooledString( name ), memory );
     }
 
-    memory->ForgetIn( forgetTime );
+    SetExpiration( memory, LAST_BOT_MEMORY + m_DataMemory.Find( FindPooledString( name ) ), forgetTime );
     return memory;
 }
 
@@ -710,17 +859,23 @@ CDataMemory * CBotMemory::UpdateDataMemory( const char * name, CBaseEntity * val
     if ( value == NULL || value->IsMarkedForDeletion() )
         return NULL;
 
+    BotMemoryKey key = GetMemoryKey( name );
+
+    if ( key != MEMORY_INVALID )
+        return UpdateDataMemory( key, value, forgetTime );
+
     CDataMemory *memory = GetDataMemory( name );
 
     if ( memory ) {
         memory->SetEntity( value );
     }
     else {
+        BOT_COUNT_ALLOCATION();
         memory = new CDataMemory( value );
         m_DataMemory.Insert( AllocPooledString( name ), memory );
     }
 
-    memory->ForgetIn( forgetTime );
+    SetExpiration( memory, LAST_BOT_MEMORY + m_DataMemory.Find( FindPooledString( name ) ), forgetTime );
     return memory;
 }
 
@@ -728,13 +883,23 @@ CDataMemory * CBotMemory::UpdateDataMemory( const char * name, CBaseEntity * val
 //================================================================================
 CDataMemory * CBotMemory::AddDataMemoryList( const char * name, CDataMemory * value, float forgetTime )
 {
+    BotMemoryKey key = GetMemoryKey( name );
     CDataMemory *memory = GetDataMemory( name );
 
-    if ( !memory ) {
+    if ( !memory && key != MEMORY_INVALID ) {
+        memory = &m_Blackboard[key];
+        memory->Reset();
+        SetExpiration( memory, key, forgetTime );
+    }
+    else if ( key != MEMORY_INVALID ) {
+        ++m_BlackboardSerial[key];
+    }
+    else if ( !memory ) {
+        BOT_COUNT_ALLOCATION();
         memory = new CDataMemory();
-        memory->ForgetIn( forgetTime );
 
-        m_DataMemory.Insert( AllocPooledString( name ), memory );
+        int index = m_DataMemory.Insert( AllocPooledString( name ), memory );
+        SetExpiration( memory, LAST_BOT_MEMORY + index, forgetTime );
     }
 
     memory->Add( value );
@@ -751,40 +916,263 @@ CDataMemory * CBotMemory::RemoveDataMemoryList( const char * name, CDataMemory *
         return NULL;
     }
 
+    BotMemoryKey key = GetMemoryKey( name );
+
+    if ( key != MEMORY_INVALID )
+        ++m_BlackboardSerial[key];
+
     memory->Remove( value );
     return memory;
 }
 
 //================================================================================
+// Returns the data memory with the name, NULL if it has not been saved
 //================================================================================
-CDataMemory * CBotMemory::GetDataMemory( const char * name, bool forceIfNotExists ) const
+CDataMemory * CBotMemory::GetDataMemory( const char * name ) const
 {
-    string_t szName = AllocPooledString( name );
-    int index = m_DataMemory.Find( szName );
+    BotMemoryKey key = GetMemoryKey( name );
 
-    if ( !m_DataMemory.IsValidIndex( index ) ) {
-        if ( forceIfNotExists ) {
-            return new CDataMemory();
-        }
-        else {
-            return NULL;
-        }
-    }
+    if ( key != MEMORY_INVALID )
+        return GetDataMemory( key );
+
+    // If the string is not in the pool then nobody has saved this memory
+    string_t szName = FindPooledString( name );
+    int index = (szName == NULL_STRING) ? m_DataMemory.InvalidIndex() : m_DataMemory.Find( szName );
+
+    if ( !m_DataMemory.IsValidIndex( index ) )
+        return NULL;
 
     return m_DataMemory.Element( index );
 }
 
+//================================================================================
+// Returns the data memory with the name, an empty memory if it has not been saved
+//================================================================================
+const CDataMemory * CBotMemory::GetDataMemoryOrEmpty( const char * name ) const
+{
+    const CDataMemory *memory = GetDataMemory( name );
+    return (memory) ? memory : &s_EmptyDataMemory;
+}
+
 //================================================================================
 //================================================================================
 void CBotMemory::ForgetData( const char * name )
 {
-    string_t szName = AllocPooledString( name );
-    m_DataMemory.Remove( szName );
+    BotMemoryKey key = GetMemoryKey( name );
+
+    if ( key != MEMORY_INVALID ) {
+        ForgetData( key );
+        return;
+    }
+
+    string_t szName = FindPooledString( name );
+
+    if ( szName == NULL_STRING )
+        return;
+
+    int index = m_DataMemory.Find( szName );
+
+    if ( !m_DataMemory.IsValidIndex( index ) )
+        return;
+
+    TheBots->GetTimers()->Remove( m_DataMemory[index]->GetExpireTimer() );
+
+    delete m_DataMemory.Element( index );
+    m_DataMemory.RemoveAt( index );
 }
 
 //================================================================================
 //================================================================================ 
 void CBotMemory::ForgetAllData()
 {
-    m_DataMemory.Purge();
+    FOR_EACH_MAP_FAST( m_DataMemory, it )
+    {
+        TheBots->GetTimers()->Remove( m_DataMemory[it]->GetExpireTimer() );
+    }
+
+    m_DataMemory.PurgeAndDeleteElements();
+
+    for ( int it = 0; it < LAST_BOT_MEMORY; ++it ) {
+        TheBots->GetTimers()->Remove( m_Blackboard[it].GetExpireTimer() );
+        m_Blackboard[it].Reset();
+        ++m_BlackboardSerial[it];
+    }
+}
+
+//================================================================================
+// Saves a data memory in the slot of the key, no allocations
+//================================================================================
+CDataMemory * CBotMemory::UpdateDataMemory( BotMemoryKey key, const Vector & value, float forgetTime )
+{
+    Assert( key > MEMORY_INVALID && key < LAST_BOT_MEMORY );
+
+    CDataMemory *memory = &m_Blackboard[key];
+    memory->SetVector( value );
+    SetExpiration( memory, key, forgetTime );
+    return memory;
+}
+
+//================================================================================
+//================================================================================
+CDataMemory * CBotMemory::UpdateDataMemory( BotMemoryKey key, float value, float forgetTime )
+{
+    Assert( key > MEMORY_INVALID && key < LAST_BOT_MEMORY );
+
+    CDataMemory *memory = &m_Blackboard[key];
+    memory->SetFloat( value );
+    SetExpiration( memory, key, forgetTime );
+    return memory;
+}
+
+//================================================================================
+//================================================================================
+CDataMemory * CBotMemory::UpdateDataMemory( BotMemoryKey key, int value, float forgetTime )
+{
+    Assert( key > MEMORY_INVALID && key < LAST_BOT_MEMORY );
+
+    CDataMemory *memory = &m_Blackboard[key];
+    memory->SetInt( value );
+    SetExpiration( memory, key, forgetTime );
+    return memory;
+}
+
+//================================================================================
+//================================================================================
+CDataMemory * CBotMemory::UpdateDataMemory( BotMemoryKey key, const char * value, float forgetTime )
+{
+    Assert( key > MEMORY_INVALID && key < LAST_BOT_MEMORY );
+
+    CDataMemory *memory = &m_Blackboard[key];
+    memory->SetString( value );
+    SetExpiration( memory, key, forgetTime );
+    return memory;
+}
+
+//================================================================================
+//================================================================================
+CDataMemory * CBotMemory::UpdateDataMemory( BotMemoryKey key, CBaseEntity * value, float forgetTime )
+{
+    Assert( key > MEMORY_INVALID && key < LAST_BOT_MEMORY );
+
+    if ( value == NULL || value->IsMarkedForDeletion() )
+        return NULL;
+
+    CDataMemory *memory = &m_Blackboard[key];
+    memory->SetEntity( value );
+    SetExpiration( memory, key, forgetTime );
+    return memory;
+}
+
+//================================================================================
+// Returns the data memory of the key, NULL if it has not been saved or it has expired
+//================================================================================
+CDataMemory * CBotMemory::GetDataMemory( BotMemoryKey key ) const
+{
+    Assert( key > MEMORY_INVALID && key < LAST_BOT_MEMORY );
+
+    const CDataMemory *memory = &m_Blackboard[key];
+
+    if ( !memory->IsSet() || memory->IsExpired() )
+        return NULL;
+
+    return const_cast<CDataMemory *>( memory );
+}
+
+//================================================================================
+// Returns the data memory of the key, an empty memory if it has not been saved
+//================================================================================
+const CDataMemory * CBotMemory::GetDataMemoryOrEmpty( BotMemoryKey key ) const
+{
+    const CDataMemory *memory = GetDataMemory( key );
+    return (memory) ? memory : &s_EmptyDataMemory;
+}
+
+//================================================================================
+//================================================================================
+void CBotMemory::ForgetData( BotMemoryKey key )
+{
+    Assert( key > MEMORY_INVALID && key < LAST_BOT_MEMORY );
+
+    TheBots->GetTimers()->Remove( m_Blackboard[key].GetExpireTimer() );
+    m_Blackboard[key].Reset();
+    ++m_BlackboardSerial[key];
+}
+
+//================================================================================
+// Sets when the data memory will be forgotten, [param] identifies the memory:
+// The key of its slot or LAST_BOT_MEMORY + the index in the map.
+//================================================================================
+void CBotMemory::SetExpiration( CDataMemory *memory, int param, float forgetTime )
+{
+    // Every update of the data memory goes through here
+    if ( param < LAST_BOT_MEMORY )
+        ++m_BlackboardSerial[param];
+
+    memory->ForgetIn( forgetTime );
+
+    TheBots->GetTimers()->Remove( memory->GetExpireTimer() );
+    memory->SetExpireTimer( BOT_TIMER_INVALID );
+
+    if ( forgetTime > 0.0f ) {
+        memory->SetExpireTimer( TheBots->GetTimers()->Add( GetBot(), BOT_TIMER_DATA_MEMORY, param, forgetTime ) );
+    }
+}
+
+//================================================================================
+// A timer of the memory has expired
+//================================================================================
+void CBotMemory::OnTimerExpired( BotTimerHandle handle, BotTimerType type, int param )
+{
+    if ( type == BOT_TIMER_ENTITY_MEMORY ) {
+        if ( param < 0 || param >= m_MemorySlots.Count() )
+            return;
+
+        CEntityMemory *memory = m_MemorySlots[param].memory;
+
+        if ( memory )
+            memory->OnTimerExpired( handle );
+
+        return;
+    }
+
+    if ( type != BOT_TIMER_DATA_MEMORY )
+        return;
+
+    // Memory with its own slot
+    if ( param < LAST_BOT_MEMORY ) {
+        if ( m_Blackboard[param].GetExpireTimer() == handle ) {
+            m_Blackboard[param].Reset();
+            ++m_BlackboardSerial[param];
+        }
+
+        return;
+    }
+
+    // Memory with a custom name
+    int index = param - LAST_BOT_MEMORY;
+
+    if ( !m_DataMemory.IsValidIndex( index ) )
+        return;
+
+    CDataMemory *memory = m_DataMemory[index];
+
+    // The record has been replaced by another one
+    if ( memory->GetExpireTimer() != handle )
+        return;
+
+    m_DataMemory.RemoveAt( index );
+    delete memory;
+}
+
+//================================================================================
+// Returns the key of the data memory with the given name
+//================================================================================
+BotMemoryKey CBotMemory::GetMemoryKey( const char *name ) const
+{
+    for ( int it = 0; it < LAST_BOT_MEMORY; ++it ) {
+        if ( FStrEq( name, g_BotMemoryKeys[it] ) )
+            return (BotMemoryKey)it;
+    }
+
+    return MEMORY_INVALID;
 }
\ No newline at end of file
@@ -4,6 +4,7 @@
 
 #include "cbase.h"
 #include "bots\bot.h"
+#include "bots\bot_manager.h"
 
 #ifdef INSOURCE_DLL
 #include "in_utils.h"
@@ -162,10 +163,18 @@ void CBotVision::GetEntityBestAimPosition( CBaseEntity *pEntity, Vector &vecLook
     }
     else if ( pEntity->MyCombatCharacterPointer() ) {
         // If it is a character, we try to aim to a hitbox
-        Utils::GetHitboxPosition( pEntity, vecLookAt, GetProfile()->GetFavoriteHitbox() );
+        // at long range we use the approximation of the bounds
+        float distance = GetHost()->GetAbsOrigin().DistTo( pEntity->GetAbsOrigin() );
+
+        HitboxPositions hitbox;
+        TheBots->GetEntityHitbox( pEntity, hitbox, GetBot()->ShouldAimWithBones( distance ) );
+
+        if ( hitbox.IsValid() )
+            vecLookAt = hitbox.Get( GetProfile()->GetFavoriteHitbox() );
     }
     else {
-        vecLookAt = pEntity->WorldSpaceCenter();
+        const BotEntitySnapshot_t *snapshot = TheBots->GetEntitySnapshot( pEntity );
+        vecLookAt = (snapshot) ? snapshot->center : pEntity->WorldSpaceCenter();
     }
 
     // No margin of error is required when shooting inanimate objects
@@ -371,7 +380,7 @@ void CBotVision::LookNavigation()
 void CBotVision::LookAround()
 {
     if ( GetMemory() ) {
-        int blocked = GetDataMemoryInt( "BlockLookAround" );
+        int blocked = GetDataMemoryInt( MEMORY_BLOCK_LOOK_AROUND );
 
         if ( blocked == 1 )
             return;
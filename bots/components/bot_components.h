@@ -205,15 +205,18 @@ public:
 
     CBotMemory( IBot *bot ) : BaseClass( bot )
     {
-        UpdateDataMemory( "NearbyThreats", 0 );
-        UpdateDataMemory( "NearbyFriends", 0 );
-        UpdateDataMemory( "NearbyDangerousThreats", 0 );
+        UpdateDataMemory( MEMORY_NEARBY_THREATS, 0 );
+        UpdateDataMemory( MEMORY_NEARBY_FRIENDS, 0 );
+        UpdateDataMemory( MEMORY_NEARBY_DANGEROUS_THREATS, 0 );
     }
 
+    virtual void Reset();
     virtual void Update();
 
 public:
     virtual void UpdateMemory();
+    virtual void UpdateSquadMemory();
+    virtual Vector GetEstimatedPosition( const Vector &vecPosition ) const;
     virtual void UpdateIdealThreat();
     virtual void UpdateThreat();
 
@@ -224,6 +227,8 @@ public:
     virtual void SetEnemy( CBaseEntity *pEnt, bool bUpdate = false );
 
     virtual CEntityMemory *UpdateEntityMemory( CBaseEntity *pEnt, const Vector &vecPosition, CBaseEntity *pInformer = NULL );
+    virtual void SyncEntityMemory( CEntityMemory *memory );
+
     virtual void ForgetEntity( CBaseEntity *pEnt );
     virtual void ForgetEntity( int index );
     virtual void ForgetAllEntities();
@@ -246,6 +251,13 @@ public:
 
     virtual float GetTimeSinceVisible( int teamnum ) const;
 
+protected:
+    virtual CEntityMemory *AllocEntityMemory( CBaseEntity *pEnt, CBaseEntity *pInformer );
+    virtual byte GetRelation( CBaseEntity *pEntity ) const;
+
+    virtual int FindClosestMemory( int relation, int teamnum, float *distance = NULL ) const;
+    virtual int CountMemories( int relation, int teamnum, float range ) const;
+
 public:
     virtual CDataMemory *UpdateDataMemory( const char *name, const Vector &value, float forgetTime = -1.0f );
     virtual CDataMemory *UpdateDataMemory( const char *name, float value, float forgetTime = -1.0f );
@@ -256,10 +268,28 @@ public:
     virtual CDataMemory *AddDataMemoryList( const char *name, CDataMemory *value, float forgetTime = -1.0f );
     virtual CDataMemory *RemoveDataMemoryList( const char *name, CDataMemory *value, float forgetTime = -1.0f );
 
-    virtual CDataMemory *GetDataMemory( const char *name, bool forceIfNotExists = false ) const;
+    virtual CDataMemory *GetDataMemory( const char *name ) const;
+    virtual const CDataMemory *GetDataMemoryOrEmpty( const char *name ) const;
 
     virtual void ForgetData( const char *name );
+
+    virtual CDataMemory *UpdateDataMemory( BotMemoryKey key, const Vector &value, float forgetTime = -1.0f );
+    virtual CDataMemory *UpdateDataMemory( BotMemoryKey key, float value, float forgetTime = -1.0f );
+    virtual CDataMemory *UpdateDataMemory( BotMemoryKey key, int value, float forgetTime = -1.0f );
+    virtual CDataMemory *UpdateDataMemory( BotMemoryKey key, const char *value, float forgetTime = -1.0f );
+    virtual CDataMemory *UpdateDataMemory( BotMemoryKey key, CBaseEntity *value, float forgetTime = -1.0f );
+
+    virtual CDataMemory *GetDataMemory( BotMemoryKey key ) const;
+    virtual const CDataMemory *GetDataMemoryOrEmpty( BotMemoryKey key ) const;
+
+    virtual void ForgetData( BotMemoryKey key );
     virtual void ForgetAllData();
+
+    virtual void OnTimerExpired( BotTimerHandle handle, BotTimerType type, int param );
+
+protected:
+    virtual BotMemoryKey GetMemoryKey( const char *name ) const;
+    virtual void SetExpiration( CDataMemory *memory, int param, float forgetTime );
 };
 
 //================================================================================
@@ -284,6 +314,28 @@ public:
     //virtual void OnAttack( int type );
 };
 
+//================================================================================
+// Predicates of the decision component that are remembered during a tick
+//================================================================================
+enum BotDecisionMemo
+{
+    BOT_MEMO_SHOULD_HELP_FRIENDS = 0,
+    BOT_MEMO_IS_LOW_HEALTH,
+    BOT_MEMO_CAN_MOVE,
+    BOT_MEMO_IS_USING_FIREGUN,
+    BOT_MEMO_CAN_ATTACK,
+    BOT_MEMO_IS_DANGEROUS_ENEMY,
+
+    LAST_BOT_DECISION_MEMO
+};
+
+struct BotEntityMemo_t
+{
+    BotDecisionMemo memo;
+    CBaseEntity *pEntity;
+    bool value;
+};
+
 //================================================================================
 // Decision component
 // Everything related to the decisions that the bot must take.
@@ -296,12 +348,42 @@ public:
 
     CBotDecision( IBot *bot ) : BaseClass( bot )
     {
+        m_bTeleportClear = false;
+        m_bShouldJump = false;
+        m_bCrouchAttack = false;
+
+        m_vecTeleportGoal.Invalidate();
+        m_vecTeleportStart.Invalidate();
+        m_vecJumpFeet.Invalidate();
+        m_vecJumpSpot.Invalidate();
+        m_vecCrouchAttackStart.Invalidate();
+        m_vecCrouchAttackForward.Invalidate();
+
+        m_iMemoTick = -1;
+        m_iMemoEpoch = 1;
+        m_iMemoSaved = 0;
+        m_iMemoEvaluated = 0;
+
+        for ( int it = 0; it < LAST_BOT_DECISION_MEMO; ++it ) {
+            m_MemoEpoch[it] = 0;
+            m_MemoValue[it] = false;
+        }
     }
 
     virtual void Update() {
 
     }
 
+    virtual void InvalidateMemo();
+
+    virtual int GetMemoSaved() const {
+        return m_iMemoSaved;
+    }
+
+    virtual int GetMemoEvaluated() const {
+        return m_iMemoEvaluated;
+    }
+
 public:
     virtual bool ShouldLookDangerSpot() const;
     virtual bool ShouldLookInterestingSpot() const;
@@ -347,6 +429,7 @@ public:
     virtual bool IsSelf( CBaseEntity *pEntity ) const;
 
     virtual bool IsBetterEnemy( CBaseEntity *pEnemy, CBaseEntity *pPrevious ) const;
+    virtual float GetThreatScore( CBaseEntity *pEnemy ) const;
 
     virtual bool CanBeEnemy( CBaseEntity *pEnemy ) const {
         return true;
@@ -378,11 +461,50 @@ public:
     virtual bool IsLineOfSightClear( CBaseEntity *entity, CBaseEntity **hit = NULL ) const;
     virtual bool IsLineOfSightClear( const Vector &pos, CBaseEntity *entityToIgnore = NULL, CBaseEntity **hit = NULL ) const;
 
+protected:
+    virtual bool GetMemo( BotDecisionMemo memo, bool &value, CBaseEntity *pEntity = NULL ) const;
+    virtual bool SetMemo( BotDecisionMemo memo, bool value, CBaseEntity *pEntity = NULL ) const;
+
+    // The predicates without memo
+    virtual bool EvaluateShouldHelpFriends() const;
+    virtual bool EvaluateIsLowHealth() const;
+    virtual bool EvaluateCanMove() const;
+    virtual bool EvaluateIsUsingFiregun() const;
+    virtual bool EvaluateCanAttack() const;
+    virtual bool EvaluateIsDangerousEnemy( CBaseEntity *pEnemy ) const;
+
 public:
     CountdownTimer m_RandomAimTimer;
     CountdownTimer m_IntestingAimTimer;
     CountdownTimer m_BlockLookAroundTimer;
     CountdownTimer m_ShotRateTimer;
+
+protected:
+    // Previous answers, used when the trace budget is exhausted
+    // and the question is close enough (see bot_trace_budget_tolerance)
+    mutable bool m_bTeleportClear;
+    mutable Vector m_vecTeleportGoal;
+    mutable Vector m_vecTeleportStart;
+
+    mutable bool m_bShouldJump;
+    mutable Vector m_vecJumpFeet;
+    mutable Vector m_vecJumpSpot;
+
+    mutable bool m_bCrouchAttack;
+    mutable Vector m_vecCrouchAttackStart;
+    mutable Vector m_vecCrouchAttackForward;
+    mutable EHANDLE m_hCrouchAttackTarget;
+
+    // Answers of the predicates in this tick, an answer is valid
+    // while its epoch is the current one (see InvalidateMemo)
+    mutable int m_iMemoTick;
+    mutable int m_iMemoEpoch;
+    mutable int m_MemoEpoch[LAST_BOT_DECISION_MEMO];
+    mutable bool m_MemoValue[LAST_BOT_DECISION_MEMO];
+    mutable CUtlVector<BotEntityMemo_t> m_EntityMemo;
+
+    mutable int m_iMemoSaved;
+    mutable int m_iMemoEvaluated;
 };
 
 
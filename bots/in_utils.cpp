@@ -16,6 +16,8 @@
 #include "func_breakablesurf.h"
 
 #include "bots\bot_defs.h"
+#include "bots\bot_manager.h"
+#include "bots\bot_visibility.h"
 #include "nav_pathfind.h"
 #include "util_shared.h"
 
@@ -238,7 +240,7 @@ CBaseEntity *Utils::FindNearestPhysicsObject( const Vector &vOrigin, float fMaxD
 
         // La entidad que lo quiere no puede verlo
         if ( pFrom ) {
-            if ( !pFrom->FVisible(pThrowEntity) )
+            if ( !Bot_IsVisibilityClear( pFrom, pFrom->EyePosition(), pThrowEntity->WorldSpaceCenter(), pThrowEntity ) )
                 continue;
         }
 
@@ -482,20 +484,31 @@ bool Utils::GetEntityBones( CBaseEntity *pEntity, HitboxBones &bones )
 }
 
 //================================================================================
-// Fill in [positions] with the entity's hitbox positions
-// If we do not have the Hitbox IDs of the entity then it will return generic positions.
-// Use with care: this is often heavy for the engine.
+// Fill in [positions] with generic positions of the entity (eyes and center)
+// It does not require the bones of the model.
 //================================================================================
-bool Utils::GetHitboxPositions( CBaseEntity *pEntity, HitboxPositions &positions )
+bool Utils::GetGenericHitboxPositions( CBaseEntity *pEntity, HitboxPositions &positions )
 {
     positions.Reset();
 
     if ( pEntity == NULL )
         return false;
 
-    // Generic Positions
     positions.head = pEntity->EyePosition();
     positions.chest = positions.leftLeg = positions.rightLeg = pEntity->WorldSpaceCenter();
+    return true;
+}
+
+//================================================================================
+// Fill in [positions] with the entity's hitbox positions
+// If we do not have the Hitbox IDs of the entity then it will return generic positions.
+// Use with care: this is often heavy for the engine.
+//================================================================================
+bool Utils::GetHitboxPositions( CBaseEntity *pEntity, HitboxPositions &positions )
+{
+    // Generic Positions
+    if ( !GetGenericHitboxPositions( pEntity, positions ) )
+        return false;
 
     CBaseAnimating *pModel = pEntity->GetBaseAnimating();
 
@@ -550,8 +563,9 @@ bool Utils::GetHitboxPosition( CBaseEntity *pEntity, Vector &vecPosition, Hitbox
 {
     vecPosition.Invalidate();
 
+    // The bones are set up only once per tick (see CBotManager::GetEntityHitbox)
     HitboxPositions positions;
-    GetHitboxPositions( pEntity, positions );
+    TheBots->GetEntityHitbox( pEntity, positions );
 
     if ( !positions.IsValid() )
         return false;
@@ -655,28 +669,27 @@ CPlayer *Utils::GetClosestPlayer( const Vector &vecPosition, float *distance, CP
     CPlayer *pClosest = NULL;
     float closeDist = 999999999999.9f;
 
-    for ( int i = 1; i <= gpGlobals->maxClients; ++i ) 
+    for ( int i = 1; i <= TheBotWorld->GetMaxPlayers(); ++i ) 
 	{
-        CPlayer *pPlayer = ToInPlayer( UTIL_PlayerByIndex(i) );
+        const BotEntitySnapshot_t *snapshot = TheBots->GetPlayerSnapshot( i );
 
-        if ( !pPlayer )
+        if ( !snapshot )
             continue;
 
-        if ( !pPlayer->IsAlive() )
+        if ( !snapshot->alive )
             continue;
 
-        if ( pPlayer == pIgnore )
+        if ( snapshot->entity.Get() == pIgnore )
             continue;
 
-        if ( team && pPlayer->GetTeamNumber() != team )
+        if ( team && snapshot->team != team )
             continue;
 
-        Vector position = pPlayer->GetAbsOrigin();
-        float dist = vecPosition.DistTo( position );
+        float dist = vecPosition.DistTo( snapshot->position );
 
         if ( dist < closeDist ) {
             closeDist = dist;
-            pClosest  = pPlayer;
+            pClosest  = ToInPlayer( snapshot->entity.Get() );
         }
     }
     
@@ -706,28 +719,27 @@ CPlayer * Utils::GetClosestPlayerByClass( const Vector & vecPosition, Class_T cl
 	CPlayer *pClosest = NULL;
     float closeDist = 999999999999.9f;
 
-    for ( int i = 1; i <= gpGlobals->maxClients; ++i ) 
+    for ( int i = 1; i <= TheBotWorld->GetMaxPlayers(); ++i ) 
 	{
-        CPlayer *pPlayer = ToInPlayer( UTIL_PlayerByIndex(i) );
+        const BotEntitySnapshot_t *snapshot = TheBots->GetPlayerSnapshot( i );
 
-        if ( !pPlayer )
+        if ( !snapshot )
             continue;
 
-        if ( !pPlayer->IsAlive() )
+        if ( !snapshot->alive )
             continue;
 
-        if ( pPlayer == pIgnore )
+        if ( snapshot->entity.Get() == pIgnore )
             continue;
 
-        if ( pPlayer->Classify() != classify )
+        if ( snapshot->classify != classify )
             continue;
 
-        Vector position = pPlayer->GetAbsOrigin();
-        float dist = vecPosition.DistTo( position );
+        float dist = vecPosition.DistTo( snapshot->position );
 
         if ( dist < closeDist ) {
             closeDist = dist;
-            pClosest  = pPlayer;
+            pClosest  = ToInPlayer( snapshot->entity.Get() );
         }
     }
     
@@ -754,9 +766,9 @@ bool Utils::IsSpotOccupiedByClass( const Vector &vecPosition, Class_T classify,
 //================================================================================
 bool Utils::IsCrossingLineOfFire( const Vector &vecStart, const Vector &vecFinish, CPlayer *pIgnore, int ignoreTeam  )
 {
-    for ( int i = 1; i <= gpGlobals->maxClients; ++i )
+    for ( int i = 1; i <= TheBotWorld->GetMaxPlayers(); ++i )
     {
-        CPlayer *pPlayer = ToInPlayer( UTIL_PlayerByIndex(i) );
+        CPlayer *pPlayer = TheBotWorld->GetPlayer( i );
 
         if ( !pPlayer )
             continue;
@@ -833,13 +845,13 @@ bool Utils::IsValidSpot( const Vector & vecSpot, const Vector & vecOrigin, const
     }
 
     // No es visible
-    if ( criteria.m_bOnlyVisible && pOwner && !pOwner->IsAbleToSee( vecSpot, CBaseCombatCharacter::DISREGARD_FOV ) ) {
+    if ( criteria.m_bOnlyVisible && pOwner && !Bot_IsVisibilityClear( pOwner, pOwner->EyePosition(), vecSpot ) ) {
         return false;
     }
 #else
     if ( criteria.m_iAvoidTeam && criteria.m_bOutOfVisibility ) {
-        for ( int it = 0; it <= gpGlobals->maxClients; ++it ) {
-            CPlayer *pPlayer = ToInPlayer( UTIL_PlayerByIndex(it) );
+        for ( int it = 0; it <= TheBotWorld->GetMaxPlayers(); ++it ) {
+            CPlayer *pPlayer = TheBotWorld->GetPlayer( it );
 
             if ( !pPlayer )
                 continue;
@@ -850,13 +862,13 @@ bool Utils::IsValidSpot( const Vector & vecSpot, const Vector & vecOrigin, const
             if ( pPlayer->GetTeamNumber() != criteria.m_iAvoidTeam )
                 return false;
 
-            if ( pPlayer->FVisible( vecSpot ) && pPlayer->IsInFieldOfView( vecSpot ) )
+            if ( pPlayer->IsInFieldOfView( vecSpot ) && Bot_IsVisibilityClear( pPlayer, pPlayer->EyePosition(), vecSpot ) )
                 return false;
         }
     }
 
     if ( criteria.m_bOnlyVisible && pOwner ) {
-        if ( !pOwner->FVisible( vecSpot ) || !pOwner->IsInFieldOfView( vecSpot ) )
+        if ( !pOwner->IsInFieldOfView( vecSpot ) || !Bot_IsVisibilityClear( pOwner, pOwner->EyePosition(), vecSpot ) )
             return false;
     }
 #endif
@@ -874,7 +886,7 @@ bool Utils::FindNavCoverSpot( Vector *vecResult, const Vector &vecOrigin, const
     if ( vecResult )
         vecResult->Invalidate();
 
-    CNavArea *pStartArea = TheNavMesh->GetNearestNavArea( vecOrigin );
+    CNavArea *pStartArea = TheBotWorld->GetNearestNavArea( vecOrigin );
 
     if ( !pStartArea )
         return false;
@@ -964,7 +976,8 @@ bool Utils::FindNavCoverSpotInArea( Vector *vecResult, const Vector &vecOrigin,
     if ( !pArea )
         return false;
 
-    CUtlVector<Vector> collector;
+    // Fixed storage, this way we do not allocate memory in each call
+    CUtlVectorFixed<Vector, 16> collector;
 
     for ( int e = 0; e <= 15; ++e ) {
         Vector position = pArea->GetRandomPoint();
@@ -1024,8 +1037,11 @@ bool Utils::FindNavCoverSpotInArea( Vector *vecResult, const Vector &vecOrigin,
 //================================================================================
 CAI_Hint *Utils::FindHintSpot( const Vector &vecOrigin, const CHintCriteria &hintCriteria, const CSpotCriteria &criteria, CPlayer *pPlayer, SpotVector *list )
 {
-    CUtlVector<CAI_Hint *> collector;
-    CAI_HintManager::FindAllHints( vecOrigin, hintCriteria, &collector );
+    // Reused between calls to avoid allocating memory (only called from the main thread)
+    static CUtlVector<CAI_Hint *> collector;
+    collector.RemoveAll();
+
+    TheBotWorld->FindHints( vecOrigin, hintCriteria, &collector );
 
     if ( collector.Count() == 0 )
         return NULL;
@@ -117,6 +117,7 @@ public:
 #endif
 
     static bool GetEntityBones( CBaseEntity *pEntity, HitboxBones &bones );
+    static bool GetGenericHitboxPositions( CBaseEntity *pEntity, HitboxPositions &positions );
     static bool GetHitboxPositions( CBaseEntity *pEntity, HitboxPositions &positions );
     static bool GetHitboxPosition( CBaseEntity *pEntity, Vector &vecPosition, HitboxType type );
 
@@ -57,6 +57,12 @@ public:
 
         m_pProfile = new CBotProfile();
         m_iPerformance = BOT_PERFORMANCE_AWAKE;
+        m_iLevelOfDetail = BOT_LOD_HIGH;
+        m_flDefaultLookDistance = -1.0f;
+        m_iCmdBuffer = 0;
+        m_iAllocations = 0;
+        m_iHeapGrowth = 0;
+        m_hStateTimer = BOT_TIMER_INVALID;
         m_pParent = parent;
     }
 
@@ -72,10 +78,29 @@ public:
         m_iPerformance = value;
     }
 
+    virtual BotLevelOfDetail GetLevelOfDetail() const {
+        return m_iLevelOfDetail;
+    }
+
+    virtual const BotLODInfo_t &GetLevelOfDetailInfo() const {
+        return g_BotLODInfo[m_iLevelOfDetail];
+    }
+
+    virtual void SetLevelOfDetail( BotLevelOfDetail value ) = 0;
+    virtual bool ShouldAimWithBones( float distance ) const = 0;
+
     virtual CUserCmd *GetUserCommand() {
         return m_cmd;
     }
 
+    virtual int GetAllocations() const {
+        return m_iAllocations;
+    }
+
+    virtual int GetHeapGrowth() const {
+        return m_iHeapGrowth;
+    }
+
     virtual CUserCmd *GetLastCmd() {
         return m_lastCmd;
     }
@@ -120,6 +145,14 @@ public:
         return m_nActiveSchedule;
     }
 
+    virtual CBotPerception *GetPerception() {
+        return &m_Perception;
+    }
+
+    virtual CBotSightCache *GetSightCache() {
+        return &m_SightCache;
+    }
+
     virtual void Spawn() = 0;
     virtual void Update() = 0;
     virtual void PlayerMove( CUserCmd *cmd ) = 0;
@@ -151,6 +184,8 @@ public:
     virtual void SetState( BotState state, float duration = 3.0f ) = 0;
     virtual void CleanState() = 0;
 
+    virtual void OnTimerExpired( BotTimerHandle handle, BotTimerType type, int param ) = 0;
+
     virtual void Panic( float duration = -1.0f ) = 0;
     virtual void Alert( float duration = -1.0f ) = 0;
     virtual void Idle() = 0;
@@ -159,6 +194,11 @@ public:
     virtual void SetCondition( BCOND condition ) = 0;
     virtual void ClearCondition( BCOND condition ) = 0;
     virtual bool HasCondition( BCOND condition ) const = 0;
+    virtual bool HasAnyCondition( const CFlagsBits &conditions ) const = 0;
+
+    virtual const CFlagsBits &GetConditions() const {
+        return m_nConditions;
+    }
 
     virtual void AddComponent( IBotComponent *pComponent ) = 0;
 
@@ -178,11 +218,12 @@ public:
     virtual int TranslateSchedule( int schedule ) = 0;
     virtual void UpdateSchedule() = 0;
 
-    virtual bool TaskStart( BotTaskInfo_t *info ) = 0;
-    virtual bool TaskRun( BotTaskInfo_t *info ) = 0;
+    virtual bool TaskStart( const BotTaskInfo_t *info ) = 0;
+    virtual bool TaskRun( const BotTaskInfo_t *info ) = 0;
     virtual void TaskComplete() = 0;
     virtual void TaskFail( const char *pWhy ) = 0;
 
+    virtual void PreparePerception() = 0;
     virtual void GatherConditions() = 0;
 
     virtual void GatherHealthConditions() = 0;
@@ -207,6 +248,10 @@ public:
 
     virtual void OnMemberTakeDamage( CPlayer *pMember, const CTakeDamageInfo &info ) = 0;
     virtual void OnMemberDeath( CPlayer *pMember, const CTakeDamageInfo &info ) = 0;
+
+    // Called by the memory for each enemy that another member has reported
+    // to the squad since the last update (see CBotMemory::UpdateSquadMemory)
+    // The position is in the table of the squad (see SquadThreat_t)
     virtual void OnMemberReportEnemy( CPlayer *pMember, CBaseEntity *pEnemy ) = 0;
 
     virtual bool ShouldShowDebug() = 0;
@@ -226,7 +271,10 @@ protected:
     CBotProfile *m_pProfile;
     int m_iTacticalMode;
     BotPerformance m_iPerformance;
+    BotLevelOfDetail m_iLevelOfDetail;
+    float m_flDefaultLookDistance;
     CountdownTimer m_iStateTimer;
+    BotTimerHandle m_hStateTimer;
 
     // Components
     CUtlMap<int, IBotComponent *> m_nComponents;
@@ -239,9 +287,25 @@ protected:
     CUserCmd *m_lastCmd;
     CUserCmd *m_cmd;
 
+    // We alternate between two commands so the last one is still valid
+    CUserCmd m_CmdBuffer[2];
+    int m_iCmdBuffer;
+
+    // Allocations marked with BOT_COUNT_ALLOCATION in the last RunAI()
+    int m_iAllocations;
+
+    // Bytes that the heap has grown in the last RunAI(), only measured with bot_debug_allocations
+    int m_iHeapGrowth;
+
     // Conditions
     CFlagsBits m_nConditions;
 
+    // Traces of this frame
+    CBotPerception m_Perception;
+
+    // Answers of the previous line of sight checks
+    CBotSightCache m_SightCache;
+
     // Debug
     CUtlVector<DebugMessage> m_debugMessages;
     float m_flDebugYPosition;
@@ -59,7 +59,7 @@ public:
     }
 
     virtual void Reset() {
-        m_flTickInterval = gpGlobals->interval_per_tick;
+        m_flTickInterval = TheBotWorld->GetTickInterval();
         m_flUpdateCost = 0.0f;
     }
 
@@ -79,6 +79,10 @@ public:
         return m_nBot->HasCondition( condition );
     }
 
+    virtual bool HasAnyCondition( const CFlagsBits &conditions ) const {
+        return m_nBot->HasAnyCondition( conditions );
+    }
+
     virtual void InjectButton( int btn ) {
         m_nBot->InjectButton( btn );
     }
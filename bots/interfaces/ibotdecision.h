@@ -34,6 +34,10 @@ public:
     };
 
 public:
+    // Forgets the answers of the predicates that were remembered in this tick
+    virtual void InvalidateMemo() {
+    }
+
     virtual bool CanLookNoVisibleSpots() const {
         return true;
     }
@@ -81,7 +85,10 @@ public:
     virtual bool IsFriend( CBaseEntity *pEntity ) const = 0;
     virtual bool IsSelf( CBaseEntity *pEntity ) const = 0;
 
+    // The memory ranks the enemies by their score and asks IsBetterEnemy
+    // between the two best ones (see CBotMemory::UpdateIdealThreat)
     virtual bool IsBetterEnemy( CBaseEntity *pEnemy, CBaseEntity *pPrevious ) const = 0;
+    virtual float GetThreatScore( CBaseEntity *pEnemy ) const = 0;
     virtual bool CanBeEnemy( CBaseEntity *pEnemy ) const = 0;
     virtual bool IsDangerousEnemy( CBaseEntity *pEnemy = NULL ) const = 0;
     virtual bool IsImportantEnemy( CBaseEntity *pEnemy = NULL ) const = 0;
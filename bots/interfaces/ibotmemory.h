@@ -16,11 +16,40 @@ class CDataMemory;
 
 // These macros allow you to obtain a value type from the information memory, 
 // if the memory does not exist it will be returned an empty one (never NULL).
-#define GetDataMemoryVector(name) GetMemory()->GetDataMemory(name, true)->GetVector()
-#define GetDataMemoryFloat(name) GetMemory()->GetDataMemory(name, true)->GetFloat()
-#define GetDataMemoryInt(name) GetMemory()->GetDataMemory(name, true)->GetInt()
-#define GetDataMemoryString(name) GetMemory()->GetDataMemory(name, true)->GetString()
-#define GetDataMemoryEntity(name) GetMemory()->GetDataMemory(name, true)->GetEntity()
+// [name] can be a BotMemoryKey or the name of the memory.
+#define GetDataMemoryVector(name) GetMemory()->GetDataMemoryOrEmpty(name)->GetVector()
+#define GetDataMemoryFloat(name) GetMemory()->GetDataMemoryOrEmpty(name)->GetFloat()
+#define GetDataMemoryInt(name) GetMemory()->GetDataMemoryOrEmpty(name)->GetInt()
+#define GetDataMemoryString(name) GetMemory()->GetDataMemoryOrEmpty(name)->GetString()
+#define GetDataMemoryEntity(name) GetMemory()->GetDataMemoryOrEmpty(name)->GetEntity()
+
+// Iterates the memory of the entities (backwards, the current memory can be forgotten)
+#define FOR_EACH_ENTITY_MEMORY( it ) for ( int it = m_Memory.Count() - 1; it >= 0; --it )
+
+//================================================================================
+// Relationship of a remembered entity
+//================================================================================
+enum BotMemoryRelation
+{
+    BOT_MEMORY_NEUTRAL = 0,
+    BOT_MEMORY_ENEMY,
+    BOT_MEMORY_FRIEND
+};
+
+//================================================================================
+// Slot of the memory table, indexed by the entity index
+//================================================================================
+struct BotMemorySlot_t
+{
+    CEntityMemory *memory;
+
+    // Serial number of the entity, when the index is reused
+    // by another entity the memory of the slot is not valid.
+    int serial;
+
+    // Position in the list of live memories
+    int live;
+};
 
 //================================================================================
 // Memory component
@@ -34,8 +63,12 @@ public:
 
     IBotMemory( IBot *bot ) : BaseClass( bot )
     {
-        SetDefLessFunc( m_Memory );
         SetDefLessFunc( m_DataMemory );
+
+        for ( int it = 0; it < LAST_BOT_MEMORY; ++it ) {
+            m_Blackboard[it].Reset();
+            m_BlackboardSerial[it] = 0;
+        }
     }
 
 public:
@@ -49,6 +82,8 @@ public:
 
     virtual CEntityMemory *UpdateEntityMemory( CBaseEntity *pEnt, const Vector &vecPosition, CBaseEntity *pInformer = NULL ) = 0;
 
+    virtual void SyncEntityMemory( CEntityMemory *memory ) = 0;
+
     virtual void ForgetEntity( CBaseEntity *pEnt ) = 0;
     virtual void ForgetEntity( int index ) = 0;
     virtual void ForgetAllEntities() = 0;
@@ -85,11 +120,31 @@ public:
     virtual CDataMemory *AddDataMemoryList( const char *name, CDataMemory *value, float forgetTime = -1.0f ) = 0;
     virtual CDataMemory *RemoveDataMemoryList( const char *name, CDataMemory *value, float forgetTime = -1.0f ) = 0;
 
-    virtual CDataMemory *GetDataMemory( const char *name, bool forceIfNotExists = false ) const = 0;
+    // The empty memory is shared by all the bots and it can not be modified
+    virtual CDataMemory *GetDataMemory( const char *name ) const = 0;
+    virtual const CDataMemory *GetDataMemoryOrEmpty( const char *name ) const = 0;
 
     virtual void ForgetData( const char *name ) = 0;
     virtual void ForgetAllData() = 0;
 
+    virtual CDataMemory *UpdateDataMemory( BotMemoryKey key, const Vector &value, float forgetTime = -1.0f ) = 0;
+    virtual CDataMemory *UpdateDataMemory( BotMemoryKey key, float value, float forgetTime = -1.0f ) = 0;
+    virtual CDataMemory *UpdateDataMemory( BotMemoryKey key, int value, float forgetTime = -1.0f ) = 0;
+    virtual CDataMemory *UpdateDataMemory( BotMemoryKey key, const char *value, float forgetTime = -1.0f ) = 0;
+    virtual CDataMemory *UpdateDataMemory( BotMemoryKey key, CBaseEntity *value, float forgetTime = -1.0f ) = 0;
+
+    virtual CDataMemory *GetDataMemory( BotMemoryKey key ) const = 0;
+    virtual const CDataMemory *GetDataMemoryOrEmpty( BotMemoryKey key ) const = 0;
+
+    virtual void ForgetData( BotMemoryKey key ) = 0;
+
+    // Increases every time the data memory of the key is saved, forgotten or expires
+    virtual int GetDataSerial( BotMemoryKey key ) const {
+        return m_BlackboardSerial[key];
+    }
+
+    virtual void OnTimerExpired( BotTimerHandle handle, BotTimerType type, int param ) = 0;
+
 public:
     virtual void Reset()
     {
@@ -99,9 +154,30 @@ public:
         m_pPrimaryThreat = NULL;
         m_pIdealThreat = NULL;
         m_flNearbyDistance = 1000.0;
-
-        m_Memory.Purge();
-        m_DataMemory.Purge();
+        m_pThreatSquad = NULL;
+        m_iThreatSequence = 0;
+
+        // The records go back to the pool, the implementation must
+        // stop their timers before calling us (see CBotMemory::Reset)
+        m_MemoryPool.AddVectorToTail( m_Memory );
+        m_Memory.RemoveAll();
+        m_MemorySlots.RemoveAll();
+
+        m_MemoryPositionX.RemoveAll();
+        m_MemoryPositionY.RemoveAll();
+        m_MemoryPositionZ.RemoveAll();
+        m_MemoryLastUpdate.RemoveAll();
+        m_MemoryLastVisible.RemoveAll();
+        m_MemoryTeam.RemoveAll();
+        m_MemoryRelation.RemoveAll();
+        m_MemoryValid.RemoveAll();
+
+        m_DataMemory.PurgeAndDeleteElements();
+
+        for ( int it = 0; it < LAST_BOT_MEMORY; ++it ) {
+            m_Blackboard[it].Reset();
+            ++m_BlackboardSerial[it];
+        }
     }
 
     virtual bool ItsImportant() const {
@@ -139,6 +215,12 @@ public:
         m_flNearbyDistance = distance;
     }
 
+    // The squad is gone or we are not a member anymore
+    virtual void ForgetSquadThreats() {
+        m_pThreatSquad = NULL;
+        m_iThreatSequence = 0;
+    }
+
 protected:
     bool m_bEnabled;
     CEntityMemory *m_pPrimaryThreat;
@@ -146,7 +228,35 @@ protected:
 
     float m_flNearbyDistance;
 
-    CUtlMap<int, CEntityMemory *> m_Memory;
+    // Squad and sequence of the last read of the squad threats
+    CSquad *m_pThreatSquad;
+    int m_iThreatSequence;
+
+    // Memory of the entities:
+    // A table indexed by the entity index, the list of live memories
+    // (to iterate them without gaps) and the records that can be reused.
+    CUtlVector<BotMemorySlot_t> m_MemorySlots;
+    CUtlVector<CEntityMemory *> m_Memory;
+    CUtlVector<CEntityMemory *> m_MemoryPool;
+
+    // Hot fields of the live memories, in the same order as [m_Memory].
+    // The range and count queries scan these arrays without touching the records.
+    // The team and the relationship are refreshed once per tick in UpdateMemory.
+    // [m_MemoryValid] is cleared when the entity dies or the memory is lost.
+    CUtlVector<float> m_MemoryPositionX;
+    CUtlVector<float> m_MemoryPositionY;
+    CUtlVector<float> m_MemoryPositionZ;
+    CUtlVector<float> m_MemoryLastUpdate;
+    CUtlVector<float> m_MemoryLastVisible;
+    CUtlVector<int> m_MemoryTeam;
+    CUtlVector<byte> m_MemoryRelation;
+    CUtlVector<byte> m_MemoryValid;
+
+    // Data memory:
+    // The keys known by the A.I. have a fixed slot, reading them is an array access.
+    // Any other name is stored in the map.
+    CDataMemory m_Blackboard[LAST_BOT_MEMORY];
+    int m_BlackboardSerial[LAST_BOT_MEMORY];
     CUtlMap<string_t, CDataMemory *> m_DataMemory;
 
     friend class CBot;
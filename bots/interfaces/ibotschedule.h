@@ -29,7 +29,13 @@
 // Macros
 //================================================================================
 
-#define ADD_TASK( task, value ) m_Tasks.AddToTail( new BotTaskInfo_t(task, value) )
+// The tasks can only be added inside Install_Tasks (see IBotSchedule::GetTaskProgram)
+// The program is shared by all the bots, the value of ADD_TASK must be a constant:
+// a value of the bot would be frozen with the value of the first bot that installed it.
+// Use ADD_TASK_AT_START and ResolveTaskValue for the values of each bot.
+#define ADD_TASK( task, value ) do { AssertMsg( m_pInstallingProgram, "ADD_TASK outside Install_Tasks()" ); m_pInstallingProgram->AddTask( BotTaskInfo_t(task, value) ); } while ( 0 )
+#define ADD_TASK_RANDOM( task, min, max ) do { AssertMsg( m_pInstallingProgram, "ADD_TASK_RANDOM outside Install_Tasks()" ); m_pInstallingProgram->AddRandomTask( task, min, max ); } while ( 0 )
+#define ADD_TASK_AT_START( task ) do { AssertMsg( m_pInstallingProgram, "ADD_TASK_AT_START outside Install_Tasks()" ); m_pInstallingProgram->AddStartTask( task ); } while ( 0 )
 #define ADD_INTERRUPT( condition ) m_Interrupts.AddToTail( condition )
 
 #define DECLARE_SCHEDULE( id ) virtual int GetID() const { return id; } \
@@ -39,6 +45,131 @@
 #define SET_SCHEDULE_TASKS( classname ) void classname::Install_Tasks()
 #define SET_SCHEDULE_INTERRUPTS( classname ) void classname::Install_Interruptions()
 
+#define ADD_DESIRE_CONDITION( condition ) ( m_DesireInputs.tracked = true, m_DesireInputs.conditions.Set( condition ) )
+#define ADD_DESIRE_MEMORY( key ) ( m_DesireInputs.tracked = true, m_DesireInputs.memory.AddToTail( key ) )
+#define ADD_DESIRE_STATE() ( m_DesireInputs.tracked = true, m_DesireInputs.state = true )
+#define ADD_DESIRE_ENEMY() ( m_DesireInputs.tracked = true, m_DesireInputs.enemy = true )
+
+#define DECLARE_SCHEDULE_DESIRE_INPUTS() virtual void Install_DesireInputs(); \
+    virtual int GetDesireKey() const;
+
+#define SET_SCHEDULE_DESIRE_INPUTS( classname ) void classname::Install_DesireInputs()
+
+//================================================================================
+// How the value of a task of the program is obtained
+//================================================================================
+enum BotTaskValueType
+{
+    BOT_TASK_VALUE_CONSTANT = 0,
+
+    // RandomFloat( min, max ) when the schedule starts
+    BOT_TASK_VALUE_RANDOM,
+
+    // Asked to the schedule when it starts (see IBotSchedule::ResolveTaskValue)
+    BOT_TASK_VALUE_AT_START,
+};
+
+//================================================================================
+// A task of the program
+//================================================================================
+struct BotTaskStep_t
+{
+    BotTaskStep_t( const BotTaskInfo_t &task ) : info( task )
+    {
+        type = BOT_TASK_VALUE_CONSTANT;
+        flMin = 0.0f;
+        flMax = 0.0f;
+        slot = -1;
+    }
+
+    BotTaskInfo_t info;
+    BotTaskValueType type;
+
+    float flMin;
+    float flMax;
+
+    // Slot of the value in each bot, -1 when the value is constant
+    int slot;
+};
+
+//================================================================================
+// Tasks of a schedule, installed only once and shared by all the bots.
+// Each bot only keeps the index of its active task and the values
+// of the tasks that are obtained when the schedule starts.
+// The programs are released when the level ends.
+//================================================================================
+struct BotTaskProgram_t
+{
+    BotTaskProgram_t( const char *typeName, int scheduleId, int tasksKey )
+    {
+        type = typeName;
+        schedule = scheduleId;
+        key = tasksKey;
+        slots = 0;
+    }
+
+    void AddTask( const BotTaskInfo_t &task ) {
+        steps.AddToTail( BotTaskStep_t( task ) );
+    }
+
+    void AddRandomTask( int task, float minValue, float maxValue ) {
+        BotTaskStep_t step( (BotTaskInfo_t( task, minValue )) );
+        step.type = BOT_TASK_VALUE_RANDOM;
+        step.flMin = minValue;
+        step.flMax = maxValue;
+        step.slot = slots++;
+        steps.AddToTail( step );
+    }
+
+    void AddStartTask( int task ) {
+        BotTaskStep_t step( (BotTaskInfo_t( task )) );
+        step.type = BOT_TASK_VALUE_AT_START;
+        step.slot = slots++;
+        steps.AddToTail( step );
+    }
+
+    // Class of the schedule, a subclass of a mod with
+    // the same ID installs its own tasks.
+    const char *type;
+    int schedule;
+    int key;
+    int slots;
+
+    CUtlVector<BotTaskStep_t> steps;
+};
+
+//================================================================================
+// Inputs of the desire of a schedule.
+// The desire is evaluated again only when one of them has changed, a schedule
+// that does not declare its inputs is evaluated in each tick.
+//================================================================================
+struct BotDesireInputs_t
+{
+    bool installed;
+    bool tracked;
+
+    // Conditions, state, enemy and data memories read by GetDesire()
+    CFlagsBits conditions;
+    bool state;
+    bool enemy;
+    CUtlVector<BotMemoryKey> memory;
+};
+
+//================================================================================
+// Values of the inputs when the desire was evaluated
+//================================================================================
+struct BotDesireCache_t
+{
+    bool valid;
+    float desire;
+
+    CFlagsBits conditions;
+    BotState state;
+    EHANDLE enemy;
+    int key;
+    CUtlVector<int> memory;
+};
+
 //================================================================================
 // Base para crear un conjunto de tareas
 //================================================================================
@@ -49,6 +180,18 @@ public:
 
     IBotSchedule( IBot *bot ) : BaseClass( bot )
     {
+        m_iInterruptsKey = -1;
+        m_pTaskProgram = NULL;
+        m_iTaskProgramSerial = -1;
+        m_pInstallingProgram = NULL;
+        m_iTaskPC = -1;
+        m_nActiveTask = NULL;
+        m_DesireInputs.installed = false;
+        m_DesireInputs.tracked = false;
+        m_DesireInputs.state = false;
+        m_DesireInputs.enemy = false;
+        m_DesireCache.valid = false;
+        m_hWaitTimer = BOT_TIMER_INVALID;
     }
 
     virtual bool IsSchedule() const {
@@ -61,6 +204,36 @@ public:
 
     virtual float GetDesire() const = 0;
 
+    // Value of everything the list of tasks depends on,
+    // each value has its own program.
+    virtual int GetTasksKey() const {
+        return 0;
+    }
+
+    // Sets the value of a task added with ADD_TASK_AT_START
+    virtual void ResolveTaskValue( BotTaskInfo_t *info ) {
+        AssertMsg( false, "ADD_TASK_AT_START without ResolveTaskValue()" );
+    }
+
+    // Value of everything the list of interruptions depends on,
+    // the list is installed again only when it changes.
+    virtual int GetInterruptsKey() const;
+
+    // Inputs of the desire, see SET_SCHEDULE_DESIRE_INPUTS
+    virtual void Install_DesireInputs() { }
+
+    // Value of the inputs of the desire that are not conditions,
+    // state, enemy or data memory (skill, flags of the entities...)
+    // It must be built from cheap state, never from the predicates
+    // of the decision, otherwise the cache saves nothing.
+    virtual int GetDesireKey() const {
+        return 0;
+    }
+
+    // Cheap values of what the predicates of the decision read
+    virtual int GetMovementKey() const;
+    virtual int GetEnemyKey() const;
+
 public:
     virtual bool HasFinished() const {
         return m_bFinished;
@@ -75,7 +248,7 @@ public:
     }
 
     virtual bool HasTasks() const {
-        return m_Tasks.Count() > 0;
+        return (m_pTaskProgram && m_iTaskPC >= 0 && m_iTaskPC < m_pTaskProgram->steps.Count());
     }
 
     // Indicates whether the schedule is important and should only stop with interruptions or when all tasks are completed.
@@ -93,26 +266,34 @@ public:
     }
 
     virtual bool IsWaitFinished() const {
-        return m_WaitTimer.IsElapsed();
+        return (m_hWaitTimer == BOT_TIMER_INVALID);
     }
 
-    virtual BotTaskInfo_t *GetActiveTask() const {
+    virtual const BotTaskInfo_t *GetActiveTask() const {
         return m_nActiveTask;
     }
 
+    virtual const BotTaskInfo_t *GetTask( int index ) const;
+    virtual const BotTaskProgram_t *GetTaskProgram();
+
+    static void ReleaseTaskPrograms();
+
 public:
     virtual void Reset();
     virtual void Start();
     virtual void Finish();
     virtual void Fail( const char *pWhy );
 
+    virtual void CompileInterrupts();
     virtual BCOND GetInterruption();
     virtual bool ShouldInterrupted();
     virtual float GetInternalDesire();
+    virtual float GetCachedDesire();
 
     virtual void Update();    
 
     virtual void Wait( float seconds );
+    virtual void OnWaitFinished( BotTimerHandle handle );
 
     virtual bool SavePosition( const Vector &position, float duration = -1.0f );
     virtual const Vector &GetSavedPosition();
@@ -130,13 +311,24 @@ protected:
 
     int m_iScheduleOnFail;
 
-    BotTaskInfo_t *m_nActiveTask;
+    const BotTaskInfo_t *m_nActiveTask;
     float m_flLastDesire;
 
-    CUtlVector<BotTaskInfo_t *> m_Tasks;
+    // Shared program of tasks, index of the active task
+    // and the values obtained when the schedule started
+    const BotTaskProgram_t *m_pTaskProgram;
+    int m_iTaskProgramSerial;
+    BotTaskProgram_t *m_pInstallingProgram;
+    int m_iTaskPC;
+    CUtlVector<BotTaskInfo_t> m_TaskValues;
     CUtlVector<BCOND> m_Interrupts;
+    CFlagsBits m_InterruptsMask;
+    int m_iInterruptsKey;
+
+    BotDesireInputs_t m_DesireInputs;
+    BotDesireCache_t m_DesireCache;
 
-    CountdownTimer m_WaitTimer;
+    BotTimerHandle m_hWaitTimer;
     IntervalTimer m_StartTimer;
     IntervalTimer m_FailTimer;
 };
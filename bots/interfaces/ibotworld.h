@@ -0,0 +1,59 @@
+//========= Copyright  1996-2005, Valve Corporation, All rights reserved. ============//
+// Authors: 
+// Ivn Bravo Bravo (linkedin.com/in/ivanbravobravo), 2017
+
+#ifndef IBOT_WORLD_H
+#define IBOT_WORLD_H
+
+#ifdef _WIN32
+#pragma once
+#endif
+
+class CPlayer;
+class CNavArea;
+class CAI_Hint;
+class CHintCriteria;
+
+//================================================================================
+// Everything the bots need to know about the world.
+// The A.I. must ask the world through this interface instead of calling
+// the engine directly (UTIL_TraceLine, TheNavMesh, gpGlobals...), this way
+// the world can be replaced by a synthetic one to measure the A.I.
+//================================================================================
+abstract_class IBotWorld
+{
+public:
+    virtual const char *GetName() const = 0;
+
+    // Time
+    virtual float GetTime() const = 0;
+    virtual int GetTickCount() const = 0;
+    virtual float GetTickInterval() const = 0;
+
+    // Traces
+    // NOTE: They are called from a worker thread only with a filter
+    // that only accepts the world (see CBotVisibility::RunWorldQuery)
+    virtual void TraceLine( const Vector &vecAbsStart, const Vector &vecAbsEnd, unsigned int mask, const IHandleEntity *ignore, int collisionGroup, trace_t *ptr ) = 0;
+    virtual void TraceLine( const Vector &vecAbsStart, const Vector &vecAbsEnd, unsigned int mask, ITraceFilter *pFilter, trace_t *ptr ) = 0;
+    virtual void TraceHull( const Vector &vecAbsStart, const Vector &vecAbsEnd, const Vector &hullMin, const Vector &hullMax, unsigned int mask, const IHandleEntity *ignore, int collisionGroup, trace_t *ptr ) = 0;
+    virtual bool IsWalkableTraceLineClear( const Vector &from, const Vector &to, unsigned int flags = 0 ) = 0;
+
+    // Navigation
+    virtual bool IsNavMeshLoaded() const = 0;
+    virtual CNavArea *GetNavArea( const Vector &pos ) const = 0;
+    virtual CNavArea *GetNearestNavArea( const Vector &pos ) const = 0;
+    virtual CNavArea *GetNearestNavArea( CBaseEntity *pEntity ) const = 0;
+    virtual bool GetGroundHeight( const Vector &pos, float *height, Vector *normal = NULL ) const = 0;
+    virtual bool GetSimpleGroundHeight( const Vector &pos, float *height, Vector *normal = NULL ) const = 0;
+
+    // Entities
+    virtual int GetMaxPlayers() const = 0;
+    virtual CPlayer *GetPlayer( int index ) const = 0;
+
+    // Hints
+    virtual int FindHints( const Vector &vecOrigin, const CHintCriteria &criteria, CUtlVector<CAI_Hint *> *pResult ) = 0;
+};
+
+extern IBotWorld *TheBotWorld;
+
+#endif // IBOT_WORLD_H
@@ -9,6 +9,7 @@
 #include "nav_mesh.h"
 #include "nav_path.h"
 #include "bots/interfaces/improv.h"
+#include "bots/bot_profiler.h"
 // memdbgon must be the last include file in a .cpp file!!!
 #include "tier0/memdbgon.h"
 
@@ -304,11 +305,11 @@ bool CNavPath::BuildTrivialPath( const Vector &start, const Vector &goal )
 {
 	m_segmentCount = 0;
 
-    CNavArea *startArea = TheNavMesh->GetNearestNavArea( start );
+    CNavArea *startArea = TheBotWorld->GetNearestNavArea( start );
 	if (startArea == NULL)
 		return false;
 
-    CNavArea *goalArea = TheNavMesh->GetNearestNavArea( goal );
+    CNavArea *goalArea = TheBotWorld->GetNearestNavArea( goal );
 	if (goalArea == NULL)
 		return false;
 
@@ -361,7 +362,7 @@ int CNavPath::FindNextOccludedNode( int anchor )
 		if (m_path[i].ladder)
 			return i;
 
-		if (!IsWalkableTraceLineClear( m_path[ anchor ].pos, m_path[ i ].pos ))
+		if (!Bot_IsWalkableTraceLineClear( BOT_TRACE_PATH, m_path[ anchor ].pos, m_path[ i ].pos ))
 		{
 			// cant see this node from anchor node
 			return i;
@@ -369,7 +370,7 @@ int CNavPath::FindNextOccludedNode( int anchor )
 
 		Vector anchorPlusHalf =  m_path[ anchor ].pos + Vector( 0, 0, HalfHumanHeight );
 		Vector iPlusHalf =  m_path[ i ].pos +Vector( 0, 0, HalfHumanHeight );
-		if (!IsWalkableTraceLineClear( anchorPlusHalf, iPlusHalf) )
+		if (!Bot_IsWalkableTraceLineClear( BOT_TRACE_PATH, anchorPlusHalf, iPlusHalf) )
 		{
 			// cant see this node from anchor node
 			return i;
@@ -377,7 +378,7 @@ int CNavPath::FindNextOccludedNode( int anchor )
 
 		Vector anchorPlusFull =  m_path[ anchor ].pos + Vector( 0, 0, HumanHeight );
 		Vector iPlusFull = m_path[ i ].pos + Vector( 0, 0, HumanHeight );
-		if (!IsWalkableTraceLineClear( anchorPlusFull, iPlusFull ))
+		if (!Bot_IsWalkableTraceLineClear( BOT_TRACE_PATH, anchorPlusFull, iPlusFull ))
 		{
 			// cant see this node from anchor node
 			return i;
@@ -725,7 +726,7 @@ int CNavPathFollower::FindOurPositionOnPath( Vector *close, bool local ) const
 		{
 			// don't use points we cant see
 			Vector probe = pos + Vector( 0, 0, HalfHumanHeight );
-			if (!IsWalkableTraceLineClear( eyes, probe, WALK_THRU_DOORS | WALK_THRU_BREAKABLES ))
+			if (!Bot_IsWalkableTraceLineClear( BOT_TRACE_PATH, eyes, probe, WALK_THRU_DOORS | WALK_THRU_BREAKABLES ))
 				continue;
 
 			// don't use points we cant reach
@@ -875,7 +876,7 @@ int CNavPathFollower::FindPathPoint( float aheadRange, Vector *point, int *prevI
 
 		// don't use points we cant see
 		Vector probe = pos + Vector( 0, 0, HalfHumanHeight );
-		if (!IsWalkableTraceLineClear( eyes, probe, WALK_THRU_BREAKABLES ))
+		if (!Bot_IsWalkableTraceLineClear( BOT_TRACE_PATH, eyes, probe, WALK_THRU_BREAKABLES ))
 		{
 			// presumably, the previous point is visible, so we will interpolate
 			visible = false;
@@ -941,7 +942,7 @@ int CNavPathFollower::FindPathPoint( float aheadRange, Vector *point, int *prevI
 			float dt = sightStepSize / length;
 
 			Vector probe = *point + Vector( 0, 0, HalfHumanHeight );
-			while( t > 0.0f && !IsWalkableTraceLineClear( eyes,  probe, WALK_THRU_BREAKABLES ) )
+			while( t > 0.0f && !Bot_IsWalkableTraceLineClear( BOT_TRACE_PATH, eyes,  probe, WALK_THRU_BREAKABLES ) )
 			{
 				t -= dt;
 				*point = *beforePoint + t * to;
@@ -1041,7 +1042,7 @@ void CNavPathFollower::FeelerReflexAdjustment( Vector *goalPosition, float heigh
 	Vector from = feet + feelerOffset * lat;
 	Vector to = from + feelerLength * dir;
 
-	bool leftClear = IsWalkableTraceLineClear( from, to, WALK_THRU_DOORS | WALK_THRU_BREAKABLES );
+	bool leftClear = Bot_IsWalkableTraceLineClear( BOT_TRACE_PATH, from, to, WALK_THRU_DOORS | WALK_THRU_BREAKABLES );
 
 	// draw debug beams
 	if (m_isDebug)
@@ -1055,7 +1056,7 @@ void CNavPathFollower::FeelerReflexAdjustment( Vector *goalPosition, float heigh
 	from = feet - feelerOffset * lat;
 	to = from + feelerLength * dir;
 
-	bool rightClear = IsWalkableTraceLineClear( from, to, WALK_THRU_DOORS | WALK_THRU_BREAKABLES );
+	bool rightClear = Bot_IsWalkableTraceLineClear( BOT_TRACE_PATH, from, to, WALK_THRU_DOORS | WALK_THRU_BREAKABLES );
 
 	// draw debug beams
 	if (m_isDebug)
@@ -8,6 +8,7 @@
 #define _NAV_PATH_H_
 
 #include "nav_area.h"
+#include "bots/interfaces/ibotworld.h"
 
 class CImprov;
 
@@ -66,11 +67,11 @@ public:
 		if (start == NULL || goal == NULL)
 			return false;
 
-		CNavArea *startArea = TheNavMesh->GetNearestNavArea(start + Vector(0.0f,0.0f,1.0f));
+		CNavArea *startArea = TheBotWorld->GetNearestNavArea(start + Vector(0.0f,0.0f,1.0f));
 		if (startArea == NULL)
 			return false;
 
-		CNavArea *goalArea = TheNavMesh->GetNavArea( goal );
+		CNavArea *goalArea = TheBotWorld->GetNavArea( goal );
 
 		// if we are already in the goal area, build trivial path
 		if (startArea == goalArea)
@@ -84,7 +85,7 @@ public:
 		if (goalArea)
 			pathEndPosition.z = goalArea->GetZ( &pathEndPosition );
 		else
-			TheNavMesh->GetGroundHeight( pathEndPosition, &pathEndPosition.z );
+			TheBotWorld->GetGroundHeight( pathEndPosition, &pathEndPosition.z );
 
 		//
 		// Compute shortest path to goal
@@ -6,6 +6,9 @@
 
 #include "bots\bot.h"
 #include "bots\interfaces\ibotschedule.h"
+#include "bots\bot_profiler.h"
+#include "bots\bot_timeline.h"
+#include "bots\bot_manager.h"
 
 #ifdef INSOURCE_DLL
 #include "in_utils.h"
@@ -14,10 +17,27 @@
 #endif
 
 #include "in_buttons.h"
+#include <typeinfo>
 
 // memdbgon must be the last include file in a .cpp file!!!
 #include "tier0/memdbgon.h"
 
+//================================================================================
+// Programs of tasks shared by all the bots
+// A program is identified by the class of the schedule, its ID and its tasks key.
+// The serial increases when the programs are released, the schedules
+// that have a program of a previous serial look for it again.
+//================================================================================
+static CUtlVector<BotTaskProgram_t *> g_TaskPrograms;
+static int g_iTaskProgramsSerial = 0;
+
+//================================================================================
+// Commands
+//================================================================================
+
+DECLARE_REPLICATED_COMMAND( bot_desire_cache, "1", "Indicates if the desire of the schedules is only evaluated again when its inputs change." )
+DECLARE_REPLICATED_COMMAND( bot_desire_cache_verify, "0", "Evaluates the desire of all the schedules and checks that the cached desire is the same." )
+
 //================================================================================
 //================================================================================
 void IBotSchedule::Reset()
@@ -29,11 +49,14 @@ void IBotSchedule::Reset()
     m_bFinished = false;
 
     m_nActiveTask = NULL;
-    Assert( m_Tasks.Count() == 0 );
+    Assert( !HasTasks() );
     m_iScheduleOnFail = SCHEDULE_NONE;
 
-    m_WaitTimer.Invalidate();
+    TheBots->GetTimers()->Remove( m_hWaitTimer );
+    m_hWaitTimer = BOT_TIMER_INVALID;
     m_FailTimer.Invalidate();
+
+    m_DesireCache.valid = false;
 }
 
 //================================================================================
@@ -51,7 +74,30 @@ void IBotSchedule::Start()
         GetLocomotion()->StandUp();
     }
 
-    Install_Tasks();
+    m_pTaskProgram = GetTaskProgram();
+    m_iTaskPC = 0;
+
+    // Values of the tasks that are only known now
+    m_TaskValues.RemoveAll();
+
+    FOR_EACH_VEC( m_pTaskProgram->steps, it )
+    {
+        const BotTaskStep_t &step = m_pTaskProgram->steps[it];
+
+        if ( step.slot < 0 )
+            continue;
+
+        Assert( step.slot == m_TaskValues.Count() );
+        int index = m_TaskValues.AddToTail( step.info );
+
+        if ( step.type == BOT_TASK_VALUE_RANDOM ) {
+            m_TaskValues[index] = BotTaskInfo_t( step.info.task, RandomFloat( step.flMin, step.flMax ) );
+        }
+        else {
+            ResolveTaskValue( &m_TaskValues[index] );
+        }
+    }
+
     GetBot()->DebugAddMessage( "[%s] Started", g_BotSchedules[GetID()] );
 }
 
@@ -67,10 +113,11 @@ void IBotSchedule::Finish()
     m_StartTimer.Invalidate();
 
     if ( ItsImportant() ) {
-        Assert( m_Tasks.Count() == 0 );
+        Assert( !HasTasks() );
     }
 
-    m_Tasks.Purge();
+    // The program is kept for the next time
+    m_iTaskPC = -1;
 
     if ( GetLocomotion() ) {
         GetLocomotion()->StopDrive();
@@ -89,19 +136,56 @@ void IBotSchedule::Fail( const char *pWhy )
     m_FailTimer.Start();
 
     if ( m_iScheduleOnFail != SCHEDULE_NONE ) {
-        GetMemory()->UpdateDataMemory( "NextSchedule", m_iScheduleOnFail );
+        GetMemory()->UpdateDataMemory( MEMORY_NEXT_SCHEDULE, m_iScheduleOnFail );
     }
 
     GetBot()->DebugAddMessage("[%s:%s] Failed: %s", g_BotSchedules[GetID()], GetActiveTaskName(), pWhy);
 }
 
 //================================================================================
+// Some schedules install different interruptions according to the skill
 //================================================================================
-BCOND IBotSchedule::GetInterruption()
+int IBotSchedule::GetInterruptsKey() const
 {
-    m_Interrupts.Purge();
+    return GetProfile()->GetSkill();
+}
+
+//================================================================================
+// Installs the list of interruptions and compiles it into a mask
+// of conditions, only when the inputs of the list have changed.
+//================================================================================
+void IBotSchedule::CompileInterrupts()
+{
+    int key = GetInterruptsKey();
+
+    if ( m_iInterruptsKey == key )
+        return;
+
+    m_Interrupts.RemoveAll();
     Install_Interruptions();
 
+    m_InterruptsMask.ClearAll();
+
+    FOR_EACH_VEC( m_Interrupts, it )
+    {
+        m_InterruptsMask.Set( m_Interrupts.Element( it ) );
+    }
+
+    m_iInterruptsKey = key;
+}
+
+//================================================================================
+// Returns the first interruption that is active
+// The mask is checked first, the list is only walked to know
+// which condition has interrupted the schedule.
+//================================================================================
+BCOND IBotSchedule::GetInterruption()
+{
+    CompileInterrupts();
+
+    if ( !HasAnyCondition( m_InterruptsMask ) )
+        return BCOND_NONE;
+
     FOR_EACH_VEC( m_Interrupts, it )
     {
         BCOND cond = m_Interrupts.Element( it );
@@ -162,11 +246,11 @@ float IBotSchedule::GetInternalDesire()
             return BOT_DESIRE_NONE;
 
         if ( GetMemory() ) {
-            int nextSchedule = GetDataMemoryInt( "NextSchedule" );
+            int nextSchedule = GetDataMemoryInt( MEMORY_NEXT_SCHEDULE );
 
             // Another schedule has asked to activate this
             if ( GetID() == nextSchedule ) {
-                GetMemory()->ForgetData( "NextSchedule" );
+                GetMemory()->ForgetData( MEMORY_NEXT_SCHEDULE );
 
                 m_flLastDesire = BOT_DESIRE_FORCED;
                 return m_flLastDesire;
@@ -174,36 +258,252 @@ float IBotSchedule::GetInternalDesire()
         }
     }
 
-	m_flLastDesire = GetDesire();
+	m_flLastDesire = GetCachedDesire();
 	return m_flLastDesire;
 }
 
+//================================================================================
+// Value of what CanMove() reads besides BCOND_DEJECTED,
+// the schedule must add BCOND_DEJECTED as a desire condition.
+//================================================================================
+int IBotSchedule::GetMovementKey() const
+{
+    int key = (GetLocomotion() && !GetLocomotion()->IsDisabled()) ? 1 : 0;
+
+#ifdef INSOURCE_DLL
+    if ( GetHost()->IsMovementDisabled() )
+        key |= 2;
+#endif
+
+    return key;
+}
+
+//================================================================================
+// Value of the flags of the enemy that IsDangerousEnemy() reads,
+// the schedule must add the enemy as a desire input (ADD_DESIRE_ENEMY).
+// A bot with its own IsDangerousEnemy() must extend it.
+//================================================================================
+int IBotSchedule::GetEnemyKey() const
+{
+    CBaseEntity *pEnemy = GetBot()->GetEnemy();
+
+    if ( !pEnemy || !pEnemy->IsPlayer() )
+        return 0;
+
+    CPlayer *pPlayer = ToInPlayer( pEnemy );
+    int key = 1;
+
+#ifdef INSOURCE_DLL
+    if ( pPlayer->IsDejected() )
+        key |= 2;
+
+    if ( pPlayer->IsMovementDisabled() )
+        key |= 4;
+#endif
+
+    IBot *pBot = pPlayer->GetBotController();
+
+    if ( pBot ) {
+        if ( pBot->HasCondition( BCOND_HELPLESS ) )
+            key |= 8;
+
+        if ( pBot->HasCondition( BCOND_DEJECTED ) )
+            key |= 16;
+
+        if ( !pBot->GetLocomotion() || pBot->GetLocomotion()->IsDisabled() )
+            key |= 32;
+    }
+
+    return key;
+}
+
+//================================================================================
+// Returns the desire of the schedule, it is only evaluated again
+// when one of the inputs declared by the schedule has changed.
+//================================================================================
+float IBotSchedule::GetCachedDesire()
+{
+    if ( !m_DesireInputs.installed ) {
+        Install_DesireInputs();
+        m_DesireInputs.installed = true;
+        m_DesireCache.memory.SetCount( m_DesireInputs.memory.Count() );
+    }
+
+    if ( !bot_desire_cache.GetBool() || !m_DesireInputs.tracked )
+        return GetDesire();
+
+    BotDesireCache_t &cache = m_DesireCache;
+    const CFlagsBits &conditions = GetBot()->GetConditions();
+    bool changed = !cache.valid;
+
+    // Conditions
+    for ( int it = 0; it < conditions.GetNumDWords(); ++it ) {
+        uint32 value = conditions.GetDWord( it ) & m_DesireInputs.conditions.GetDWord( it );
+
+        if ( value != cache.conditions.GetDWord( it ) ) {
+            cache.conditions.SetDWord( it, value );
+            changed = true;
+        }
+    }
+
+    // State
+    if ( m_DesireInputs.state && cache.state != GetBot()->GetState() ) {
+        cache.state = GetBot()->GetState();
+        changed = true;
+    }
+
+    // Enemy
+    if ( m_DesireInputs.enemy && cache.enemy.Get() != GetBot()->GetEnemy() ) {
+        cache.enemy = GetBot()->GetEnemy();
+        changed = true;
+    }
+
+    // Data memory, the serial does not change when a memory expires
+    // before its timer, so we also save if it still exists.
+    if ( GetMemory() ) {
+        FOR_EACH_VEC( m_DesireInputs.memory, it )
+        {
+            BotMemoryKey key = m_DesireInputs.memory[it];
+            int value = (GetMemory()->GetDataSerial( key ) << 1) | (GetMemory()->GetDataMemory( key ) ? 1 : 0);
+
+            if ( value != cache.memory[it] ) {
+                cache.memory[it] = value;
+                changed = true;
+            }
+        }
+    }
+
+    // Everything else
+    int key = GetDesireKey();
+
+    if ( key != cache.key ) {
+        cache.key = key;
+        changed = true;
+    }
+
+    TheBotProfiler->CountDesire( !changed );
+
+    if ( changed ) {
+        cache.desire = GetDesire();
+        cache.valid = true;
+    }
+    else if ( bot_desire_cache_verify.GetBool() ) {
+        float desire = GetDesire();
+
+        if ( desire != cache.desire ) {
+            TheBotProfiler->CountDesireMismatch();
+            DevWarning( "[%s] The cached desire (%.2f) is not the current desire (%.2f), an input is missing.\n", g_BotSchedules[GetID()], cache.desire, desire );
+            AssertMsg( false, "The cached desire of a schedule is not the current desire" );
+        }
+    }
+
+    return cache.desire;
+}
+
 //================================================================================
 //================================================================================
 void IBotSchedule::Update()
 {
     VPROF_BUDGET( "IBotSchedule::Update", VPROF_BUDGETGROUP_BOTS );
 
-    Assert( m_Tasks.Count() > 0 );
-    BotTaskInfo_t *idealTask = m_Tasks.Element( 0 );
+    Assert( HasTasks() );
+    const BotTaskInfo_t *idealTask = GetTask( m_iTaskPC );
+
+    int task = idealTask->task;
+
+    CFastTimer timer;
+    timer.Start();
 
     if ( idealTask != m_nActiveTask ) {
         m_nActiveTask = idealTask;
         TaskStart();
-        return;
+    }
+    else {
+        TaskRun();
     }
 
-    TaskRun();
+    timer.End();
+    TheBotProfiler->AddSample( GetHost()->entindex(), BOT_PROFILE_TASK, task, timer.GetDuration().GetMillisecondsF() );
+}
+
+//================================================================================
+// Returns the task of the program in the given index
+//================================================================================
+const BotTaskInfo_t *IBotSchedule::GetTask( int index ) const
+{
+    Assert( m_pTaskProgram );
+    const BotTaskStep_t &step = m_pTaskProgram->steps[index];
+
+    if ( step.slot >= 0 )
+        return &m_TaskValues[step.slot];
+
+    return &step.info;
+}
+
+//================================================================================
+// Returns the program of tasks for the current tasks key.
+// The tasks are installed only the first time that a bot needs the program.
+//================================================================================
+const BotTaskProgram_t *IBotSchedule::GetTaskProgram()
+{
+    int key = GetTasksKey();
+
+    if ( m_pTaskProgram && m_iTaskProgramSerial == g_iTaskProgramsSerial && m_pTaskProgram->key == key )
+        return m_pTaskProgram;
+
+    const char *type = typeid( *this ).name();
+    m_iTaskProgramSerial = g_iTaskProgramsSerial;
+
+    FOR_EACH_VEC( g_TaskPrograms, it )
+    {
+        BotTaskProgram_t *program = g_TaskPrograms[it];
+
+        if ( program->schedule == GetID() && program->key == key && Q_strcmp( program->type, type ) == 0 )
+            return program;
+    }
+
+    BOT_COUNT_ALLOCATION();
+    BotTaskProgram_t *program = new BotTaskProgram_t( type, GetID(), key );
+
+    m_pInstallingProgram = program;
+    Install_Tasks();
+    m_pInstallingProgram = NULL;
+
+    AssertMsg( program->steps.Count() > 0, "Schedule without tasks" );
+    g_TaskPrograms.AddToTail( program );
+    return program;
+}
+
+//================================================================================
+// Releases the programs of all the schedules when the level ends
+//================================================================================
+void IBotSchedule::ReleaseTaskPrograms()
+{
+    g_TaskPrograms.PurgeAndDeleteElements();
+    ++g_iTaskProgramsSerial;
 }
 
 //================================================================================
 //================================================================================
 void IBotSchedule::Wait( float seconds )
 {
-    m_WaitTimer.Start( seconds );
+    TheBots->GetTimers()->Remove( m_hWaitTimer );
+    m_hWaitTimer = TheBots->GetTimers()->Add( GetBot(), BOT_TIMER_SCHEDULE_WAIT, GetID(), seconds );
+
     GetBot()->DebugAddMessage( "[%s:%s] %.2fs", g_BotSchedules[GetID()], GetActiveTaskName(), seconds );
 }
 
+//================================================================================
+// The wait timer has expired
+//================================================================================
+void IBotSchedule::OnWaitFinished( BotTimerHandle handle )
+{
+    if ( handle != m_hWaitTimer )
+        return;
+
+    m_hWaitTimer = BOT_TIMER_INVALID;
+}
+
 //================================================================================
 //================================================================================
 bool IBotSchedule::SavePosition( const Vector &position, float duration )
@@ -215,7 +515,7 @@ bool IBotSchedule::SavePosition( const Vector &position, float duration )
         return false;
     }
 
-    GetMemory()->UpdateDataMemory( "SavedPosition", position, duration );
+    GetMemory()->UpdateDataMemory( MEMORY_SAVED_POSITION, position, duration );
     return true;
 }
 
@@ -230,14 +530,14 @@ const Vector &IBotSchedule::GetSavedPosition()
         return vec3_invalid;
     }
 
-    return GetDataMemoryVector( "SavedPosition" );
+    return GetDataMemoryVector( MEMORY_SAVED_POSITION );
 }
 
 //================================================================================
 //================================================================================
 const char *IBotSchedule::GetActiveTaskName() const
 {
-    BotTaskInfo_t *info = GetActiveTask();
+    const BotTaskInfo_t *info = GetActiveTask();
 
     if ( !info ) {
         return "UNKNOWN";
@@ -254,7 +554,8 @@ const char *IBotSchedule::GetActiveTaskName() const
 //================================================================================
 void IBotSchedule::TaskStart()
 {
-    BotTaskInfo_t *pTask = GetActiveTask();
+    const BotTaskInfo_t *pTask = GetActiveTask();
+    BOT_TIMELINE_SCOPE( TheBotProfiler->GetHistogramName( BOT_PROFILE_TASK, pTask->task ), "TaskStart" );
 
     if ( GetBot()->TaskStart( pTask ) ) {
         return;
@@ -349,7 +650,7 @@ void IBotSchedule::TaskStart()
                 return;
             }
 
-            SavePosition( GetDataMemoryVector( "SpawnPosition" ) );
+            SavePosition( GetDataMemoryVector( MEMORY_SPAWN_POSITION ) );
             break;
         }
 
@@ -364,7 +665,7 @@ void IBotSchedule::TaskStart()
             CNavArea *pArea = GetHost()->GetLastKnownArea();
 
             if ( pArea == NULL ) {
-                pArea = TheNavMesh->GetNearestNavArea( GetHost() );
+                pArea = TheBotWorld->GetNearestNavArea( GetHost() );
             }
 
             if ( pArea == NULL ) {
@@ -586,7 +887,7 @@ void IBotSchedule::TaskStart()
                 return;
             }
 
-            GetMemory()->UpdateDataMemory( "NextSchedule", pTask->iValue );
+            GetMemory()->UpdateDataMemory( MEMORY_NEXT_SCHEDULE, pTask->iValue );
 
             TaskComplete();
             break;
@@ -604,7 +905,8 @@ void IBotSchedule::TaskStart()
 //================================================================================
 void IBotSchedule::TaskRun()
 {
-    BotTaskInfo_t *pTask = GetActiveTask();
+    const BotTaskInfo_t *pTask = GetActiveTask();
+    BOT_TIMELINE_SCOPE( TheBotProfiler->GetHistogramName( BOT_PROFILE_TASK, pTask->task ), "TaskRun" );
 
     if ( GetBot()->TaskRun( pTask ) )
         return;
@@ -802,7 +1104,7 @@ void IBotSchedule::TaskRun()
 
             if ( GetVision()->IsAimReady() ) {
                 if ( GetMemory() ) {
-                    GetMemory()->UpdateDataMemory( "BlockLookAround", 1, 5.0f );
+                    GetMemory()->UpdateDataMemory( MEMORY_BLOCK_LOOK_AROUND, 1, 5.0f );
                 }
 
                 TaskComplete();
@@ -853,14 +1155,14 @@ void IBotSchedule::TaskComplete()
         GetLocomotion()->StopDrive();
     }
 
-    if ( m_Tasks.Count() == 0 ) {
-        Assert( !"m_Tasks.Count() == 0" );
+    if ( !HasTasks() ) {
+        Assert( !"HasTasks() == false" );
         return;
     }
 
-    m_Tasks.Remove( 0 );
+    ++m_iTaskPC;
 
-    if ( m_Tasks.Count() == 0 ) {
+    if ( !HasTasks() ) {
         m_bFinished = true;
     }
 }
\ No newline at end of file
@@ -26,9 +26,9 @@ SET_SCHEDULE_TASKS( CCallBackupSchedule )
     ADD_TASK( BTASK_CROUCH, NULL );
     ADD_TASK( BTASK_HEAL, NULL );
     ADD_TASK( BTASK_RELOAD, NULL );
-    ADD_TASK( BTASK_WAIT, RandomFloat( 2.0f, 6.0f ) );
+    ADD_TASK_RANDOM( BTASK_WAIT, 2.0f, 6.0f );
     ADD_TASK( BTASK_CALL_FOR_BACKUP, NULL );
-    ADD_TASK( BTASK_WAIT, RandomFloat( 2.0f, 6.0f ) );
+    ADD_TASK_RANDOM( BTASK_WAIT, 2.0f, 6.0f );
     ADD_TASK( BTASK_RESTORE_POSITION, NULL );
 }
 
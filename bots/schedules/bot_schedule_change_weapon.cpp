@@ -21,17 +21,27 @@
 //================================================================================
 SET_SCHEDULE_TASKS( CChangeWeaponSchedule )
 {
-    CDataMemory *memory = GetMemory()->GetDataMemory( "BestWeapon" );
-    Assert( memory );
-
     ADD_TASK( BTASK_SAVE_POSITION, NULL );
     ADD_TASK( BTASK_RUN, NULL );
-    ADD_TASK( BTASK_MOVE_DESTINATION, memory->GetEntity() );
-    ADD_TASK( BTASK_AIM, memory->GetEntity() );
+    ADD_TASK_AT_START( BTASK_MOVE_DESTINATION );
+    ADD_TASK_AT_START( BTASK_AIM );
     ADD_TASK( BTASK_USE, NULL );
     ADD_TASK( BTASK_RESTORE_POSITION, NULL );
 }
 
+//================================================================================
+// The weapon is the one in our memory when the schedule starts
+//================================================================================
+void CChangeWeaponSchedule::ResolveTaskValue( BotTaskInfo_t *info )
+{
+    CDataMemory *memory = GetMemory()->GetDataMemory( MEMORY_BEST_WEAPON );
+    Assert( memory );
+
+    if ( memory ) {
+        *info = BotTaskInfo_t( info->task, memory->GetEntity() );
+    }
+}
+
 SET_SCHEDULE_INTERRUPTS( CChangeWeaponSchedule )
 {
     if ( GetProfile()->GetSkill() < SKILL_ULTRA_HARD ) {
@@ -48,6 +58,23 @@ SET_SCHEDULE_INTERRUPTS( CChangeWeaponSchedule )
     ADD_INTERRUPT( BCOND_HEAR_MOVE_AWAY );
 }
 
+//================================================================================
+// Inputs of GetDesire()
+//================================================================================
+SET_SCHEDULE_DESIRE_INPUTS( CChangeWeaponSchedule )
+{
+    ADD_DESIRE_CONDITION( BCOND_BETTER_WEAPON_AVAILABLE );
+    ADD_DESIRE_CONDITION( BCOND_DEJECTED );
+    ADD_DESIRE_MEMORY( MEMORY_BEST_WEAPON );
+}
+
+//================================================================================
+//================================================================================
+int CChangeWeaponSchedule::GetDesireKey() const
+{
+    return GetMovementKey();
+}
+
 //================================================================================
 //================================================================================
 float CChangeWeaponSchedule::GetDesire() const
@@ -55,7 +82,7 @@ float CChangeWeaponSchedule::GetDesire() const
     if ( !GetMemory() )
         return BOT_DESIRE_NONE;
 
-    CDataMemory *memory = GetMemory()->GetDataMemory( "BestWeapon" );
+    CDataMemory *memory = GetMemory()->GetDataMemory( MEMORY_BEST_WEAPON );
 
     if ( memory == NULL )
         return BOT_DESIRE_NONE;
@@ -73,7 +100,7 @@ float CChangeWeaponSchedule::GetDesire() const
 //================================================================================
 void CChangeWeaponSchedule::TaskStart()
 {
-	BotTaskInfo_t *pTask = GetActiveTask();
+	const BotTaskInfo_t *pTask = GetActiveTask();
 
 	switch( pTask->task )
 	{
@@ -95,7 +122,7 @@ void CChangeWeaponSchedule::TaskStart()
 //================================================================================
 void CChangeWeaponSchedule::TaskRun()
 {
-    CDataMemory *memory = GetMemory()->GetDataMemory( "BestWeapon" );
+    CDataMemory *memory = GetMemory()->GetDataMemory( MEMORY_BEST_WEAPON );
 
     if ( !memory ) {
         Fail( "Best weapon not available" );
@@ -118,7 +145,7 @@ void CChangeWeaponSchedule::TaskRun()
         }
     }
 
-    BotTaskInfo_t *pTask = GetActiveTask();
+    const BotTaskInfo_t *pTask = GetActiveTask();
 
     switch ( pTask->task ) {
         case BTASK_USE:
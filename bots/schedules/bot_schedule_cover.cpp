@@ -26,7 +26,7 @@ SET_SCHEDULE_TASKS( CCoverSchedule )
     ADD_TASK( BTASK_MOVE_DESTINATION, NULL );
     ADD_TASK( BTASK_CROUCH, NULL );
     ADD_TASK( BTASK_RELOAD_SAFE, NULL );
-    ADD_TASK( BTASK_WAIT, RandomFloat( 1.0f, 3.0f ) );
+    ADD_TASK_RANDOM( BTASK_WAIT, 1.0f, 3.0f );
     ADD_TASK( BTASK_RESTORE_POSITION, NULL );
 }
 
@@ -40,6 +40,30 @@ SET_SCHEDULE_INTERRUPTS( CCoverSchedule )
     ADD_INTERRUPT( BCOND_GOAL_UNREACHABLE );
 }
 
+//================================================================================
+// Inputs of GetDesire()
+//================================================================================
+SET_SCHEDULE_DESIRE_INPUTS( CCoverSchedule )
+{
+    ADD_DESIRE_CONDITION( BCOND_LIGHT_DAMAGE );
+    ADD_DESIRE_CONDITION( BCOND_REPEATED_DAMAGE );
+    ADD_DESIRE_CONDITION( BCOND_HEAVY_DAMAGE );
+    ADD_DESIRE_CONDITION( BCOND_HELPLESS );
+    ADD_DESIRE_CONDITION( BCOND_DEJECTED );
+    ADD_DESIRE_STATE();
+    ADD_DESIRE_ENEMY();
+}
+
+//================================================================================
+//================================================================================
+int CCoverSchedule::GetDesireKey() const
+{
+    int key = GetMovementKey();
+    key |= (GetEnemyKey() << 2);
+    key |= (GetProfile()->GetSkill() << 8);
+    return key;
+}
+
 //================================================================================
 //================================================================================
 float CCoverSchedule::GetDesire() const
@@ -77,7 +101,7 @@ SET_SCHEDULE_TASKS( CHideSchedule )
     ADD_TASK( BTASK_SAVE_FAR_COVER_SPOT, NULL );
     ADD_TASK( BTASK_MOVE_DESTINATION, NULL );
     ADD_TASK( BTASK_RELOAD, NULL );
-    ADD_TASK( BTASK_WAIT, RandomFloat( 1.0f, 3.0f ) );
+    ADD_TASK_RANDOM( BTASK_WAIT, 1.0f, 3.0f );
 }
 
 
@@ -90,6 +114,23 @@ SET_SCHEDULE_INTERRUPTS( CHideSchedule )
     ADD_INTERRUPT( BCOND_GOAL_UNREACHABLE );
 }
 
+//================================================================================
+// Inputs of GetDesire()
+//================================================================================
+SET_SCHEDULE_DESIRE_INPUTS( CHideSchedule )
+{
+    ADD_DESIRE_CONDITION( BCOND_HELPLESS );
+    ADD_DESIRE_CONDITION( BCOND_DEJECTED );
+    ADD_DESIRE_STATE();
+}
+
+//================================================================================
+//================================================================================
+int CHideSchedule::GetDesireKey() const
+{
+    return GetMovementKey();
+}
+
 //================================================================================
 //================================================================================
 float CHideSchedule::GetDesire() const
@@ -50,6 +50,14 @@ SET_SCHEDULE_INTERRUPTS( CDefendSpawnSchedule )
     }
 }
 
+//================================================================================
+// The list also depends on whether we help our friends
+//================================================================================
+int CDefendSpawnSchedule::GetInterruptsKey() const
+{
+    return (BaseClass::GetInterruptsKey() << 1) | (GetDecision()->ShouldHelpFriends() ? 1 : 0);
+}
+
 //================================================================================
 //================================================================================
 float CDefendSpawnSchedule::GetDesire() const
@@ -57,7 +65,7 @@ float CDefendSpawnSchedule::GetDesire() const
     if ( !GetMemory() )
         return BOT_DESIRE_NONE;
 
-    CDataMemory *memory = GetMemory()->GetDataMemory( "SpawnPosition" );
+    CDataMemory *memory = GetMemory()->GetDataMemory( MEMORY_SPAWN_POSITION );
 
     if ( memory == NULL )
         return BOT_DESIRE_NONE;
@@ -22,17 +22,27 @@
 //================================================================================
 SET_SCHEDULE_TASKS( CHelpDejectedFriendSchedule )
 {
-    CDataMemory *memory = GetMemory()->GetDataMemory( "DejectedFriend" );
-    Assert( memory );
-
     ADD_TASK( BTASK_SAVE_POSITION, NULL );
     ADD_TASK( BTASK_RUN, NULL );
-    ADD_TASK( BTASK_MOVE_DESTINATION, memory->GetEntity() );
-    ADD_TASK( BTASK_AIM, memory->GetEntity() );
+    ADD_TASK_AT_START( BTASK_MOVE_DESTINATION );
+    ADD_TASK_AT_START( BTASK_AIM );
     ADD_TASK( BTASK_HELP, NULL );
     ADD_TASK( BTASK_RESTORE_POSITION, NULL );
 }
 
+//================================================================================
+// The friend is the one in our memory when the schedule starts
+//================================================================================
+void CHelpDejectedFriendSchedule::ResolveTaskValue( BotTaskInfo_t *info )
+{
+    CDataMemory *memory = GetMemory()->GetDataMemory( MEMORY_DEJECTED_FRIEND );
+    Assert( memory );
+
+    if ( memory ) {
+        *info = BotTaskInfo_t( info->task, memory->GetEntity() );
+    }
+}
+
 SET_SCHEDULE_INTERRUPTS( CHelpDejectedFriendSchedule )
 {
     ADD_INTERRUPT( BCOND_REPEATED_DAMAGE );
@@ -48,7 +58,7 @@ bool CHelpDejectedFriendSchedule::ShouldHelp()
     if ( !GetMemory() )
         return false;
 
-    CDataMemory *memory = GetMemory()->GetDataMemory( "DejectedFriend" );
+    CDataMemory *memory = GetMemory()->GetDataMemory( MEMORY_DEJECTED_FRIEND );
 
     if ( !memory )
         return false;
@@ -70,6 +80,36 @@ bool CHelpDejectedFriendSchedule::ShouldHelp()
     return true;
 }
 
+//================================================================================
+// Inputs of GetDesire()
+//================================================================================
+SET_SCHEDULE_DESIRE_INPUTS( CHelpDejectedFriendSchedule )
+{
+    ADD_DESIRE_CONDITION( BCOND_SEE_DEJECTED_FRIEND );
+    ADD_DESIRE_CONDITION( BCOND_HELPLESS );
+    ADD_DESIRE_CONDITION( BCOND_DEJECTED );
+    ADD_DESIRE_MEMORY( MEMORY_DEJECTED_FRIEND );
+    ADD_DESIRE_STATE();
+}
+
+//================================================================================
+//================================================================================
+int CHelpDejectedFriendSchedule::GetDesireKey() const
+{
+    int key = GetMovementKey();
+    key |= (GetProfile()->IsEasiest() ? 4 : 0);
+
+    // What ShouldHelpFriends() reads from the squad
+    CSquad *pSquad = GetBot()->GetSquad();
+
+    if ( pSquad ) {
+        key |= (pSquad->GetActiveCount() <= 2 ? 8 : 0);
+        key |= (pSquad->GetStrategie() << 4);
+    }
+
+    return key;
+}
+
 //================================================================================
 //================================================================================
 float CHelpDejectedFriendSchedule::GetDesire() const
@@ -77,7 +117,7 @@ float CHelpDejectedFriendSchedule::GetDesire() const
     if ( !GetMemory() )
         return BOT_DESIRE_NONE;
 
-    CDataMemory *memory = GetMemory()->GetDataMemory( "DejectedFriend" );
+    CDataMemory *memory = GetMemory()->GetDataMemory( MEMORY_DEJECTED_FRIEND );
 
     if ( !memory )
         return BOT_DESIRE_NONE;
@@ -101,12 +141,12 @@ float CHelpDejectedFriendSchedule::GetDesire() const
 //================================================================================
 void CHelpDejectedFriendSchedule::TaskRun()
 {
-    CDataMemory *memory = GetMemory()->GetDataMemory( "DejectedFriend" );
+    CDataMemory *memory = GetMemory()->GetDataMemory( MEMORY_DEJECTED_FRIEND );
     Assert( memory );
 
     CPlayer *pFriend = ToInPlayer( memory->GetEntity() );
 
-    BotTaskInfo_t *pTask = GetActiveTask();
+    const BotTaskInfo_t *pTask = GetActiveTask();
 
     switch ( pTask->task ) {
         // Recargamos
@@ -135,7 +175,7 @@ void CHelpDejectedFriendSchedule::TaskRun()
             // Nuestro amigo ha muerto o 
             // ya esta siendo ayudado
             if ( !pFriend || !pFriend->IsAlive() || pFriend->IsBeingHelped() || !pFriend->IsDejected() ) {
-                GetMemory()->ForgetData( "Dejected Friend" );
+                GetMemory()->ForgetData( MEMORY_DEJECTED_FRIEND );
                 Fail( "The friend." );
                 return;
             }
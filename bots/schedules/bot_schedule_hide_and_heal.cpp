@@ -27,7 +27,7 @@ SET_SCHEDULE_TASKS( CHideAndHealSchedule )
     ADD_TASK( BTASK_CROUCH, NULL );
     ADD_TASK( BTASK_HEAL, NULL );
     ADD_TASK( BTASK_RELOAD_SAFE, NULL );
-    ADD_TASK( BTASK_WAIT, RandomFloat( 1.0f, 3.0f ) );
+    ADD_TASK_RANDOM( BTASK_WAIT, 1.0f, 3.0f );
     ADD_TASK( BTASK_RESTORE_POSITION, NULL );
 }
 
@@ -38,6 +38,24 @@ SET_SCHEDULE_INTERRUPTS( CHideAndHealSchedule )
     ADD_INTERRUPT( BCOND_GOAL_UNREACHABLE );
 }
 
+//================================================================================
+// Inputs of GetDesire()
+//================================================================================
+SET_SCHEDULE_DESIRE_INPUTS( CHideAndHealSchedule )
+{
+    ADD_DESIRE_CONDITION( BCOND_LOW_HEALTH );
+    ADD_DESIRE_CONDITION( BCOND_HELPLESS );
+    ADD_DESIRE_CONDITION( BCOND_DEJECTED );
+    ADD_DESIRE_ENEMY();
+}
+
+//================================================================================
+//================================================================================
+int CHideAndHealSchedule::GetDesireKey() const
+{
+    return GetMovementKey() | (GetEnemyKey() << 2);
+}
+
 //================================================================================
 //================================================================================
 float CHideAndHealSchedule::GetDesire() const
@@ -27,7 +27,7 @@ SET_SCHEDULE_TASKS( CHideAndReloadSchedule )
     ADD_TASK( BTASK_RELOAD, true );
     ADD_TASK( BTASK_MOVE_DESTINATION, NULL );
     ADD_TASK( BTASK_CROUCH, NULL );
-    ADD_TASK( BTASK_WAIT, RandomFloat( 1.0f, 2.5f ) );
+    ADD_TASK_RANDOM( BTASK_WAIT, 1.0f, 2.5f );
     ADD_TASK( BTASK_RESTORE_POSITION, NULL );
 }
 
@@ -43,6 +43,25 @@ SET_SCHEDULE_INTERRUPTS( CHideAndReloadSchedule )
     ADD_INTERRUPT( BCOND_HEAR_MOVE_AWAY );
 }
 
+//================================================================================
+// Inputs of GetDesire()
+//================================================================================
+SET_SCHEDULE_DESIRE_INPUTS( CHideAndReloadSchedule )
+{
+    ADD_DESIRE_CONDITION( BCOND_EMPTY_CLIP1_AMMO );
+    ADD_DESIRE_CONDITION( BCOND_HELPLESS );
+    ADD_DESIRE_CONDITION( BCOND_DEJECTED );
+    ADD_DESIRE_STATE();
+    ADD_DESIRE_ENEMY();
+}
+
+//================================================================================
+//================================================================================
+int CHideAndReloadSchedule::GetDesireKey() const
+{
+    return GetMovementKey() | (GetEnemyKey() << 2);
+}
+
 //================================================================================
 //================================================================================
 float CHideAndReloadSchedule::GetDesire() const
@@ -65,7 +84,7 @@ float CHideAndReloadSchedule::GetDesire() const
 //================================================================================
 void CHideAndReloadSchedule::TaskRun()
 {
-    BotTaskInfo_t *pTask = GetActiveTask();
+    const BotTaskInfo_t *pTask = GetActiveTask();
 
     switch ( pTask->task ) {
         case BTASK_MOVE_DESTINATION:
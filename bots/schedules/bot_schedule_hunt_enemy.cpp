@@ -16,11 +16,23 @@
 // memdbgon must be the last include file in a .cpp file!!!
 #include "tier0/memdbgon.h"
 
+//================================================================================
+// There is a program for the careful approach and another one for the direct one
+//================================================================================
+int CHuntEnemySchedule::GetTasksKey() const
+{
+#ifndef HL2MP
+    return (GetDecision()->ShouldMustBeCareful() ? 1 : 0);
+#else
+    return 0;
+#endif
+}
+
 //================================================================================
 //================================================================================
 SET_SCHEDULE_TASKS( CHuntEnemySchedule )
 {
-    bool carefulApproach = GetDecision()->ShouldMustBeCareful();
+    bool carefulApproach = (m_pInstallingProgram->key == 1);
 
     ADD_TASK( BTASK_SET_FAIL_SCHEDULE, SCHEDULE_COVER );
     ADD_TASK( BTASK_RUN, NULL );
@@ -29,13 +41,13 @@ SET_SCHEDULE_TASKS( CHuntEnemySchedule )
     // We must be careful!
     if ( carefulApproach ) {
         // We run towards the target until we reach a distance of between 700 and 900 units
-        ADD_TASK( BTASK_HUNT_ENEMY, RandomFloat( 700.0, 900.0f ) );
+        ADD_TASK_RANDOM( BTASK_HUNT_ENEMY, 700.0, 900.0f );
 
         // We walked slowly until reaching a short distance and 
         // we waited a little in case the target leaves its coverage.
         ADD_TASK( BTASK_SNEAK, NULL );
-        ADD_TASK( BTASK_HUNT_ENEMY, RandomFloat( 400.0f, 500.0f ) );
-        ADD_TASK( BTASK_WAIT, RandomFloat( 0.5f, 3.5f ) );
+        ADD_TASK_RANDOM( BTASK_HUNT_ENEMY, 400.0f, 500.0f );
+        ADD_TASK_RANDOM( BTASK_WAIT, 0.5f, 3.5f );
     }
 #endif
 
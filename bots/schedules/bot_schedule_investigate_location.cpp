@@ -18,15 +18,28 @@
 //================================================================================
 SET_SCHEDULE_TASKS( CInvestigateLocationSchedule )
 {
-    CDataMemory *memory = GetMemory()->GetDataMemory( "InvestigateLocation" );
-    Assert( memory );
-
     ADD_TASK( BTASK_SAVE_POSITION, NULL );
-    ADD_TASK( BTASK_MOVE_DESTINATION, memory->GetVector() );
-    ADD_TASK( BTASK_WAIT, RandomFloat( 3.0f, 6.0f ) ); // TODO
+    ADD_TASK_AT_START( BTASK_MOVE_DESTINATION );
+    ADD_TASK_RANDOM( BTASK_WAIT, 3.0f, 6.0f ); // TODO
     ADD_TASK( BTASK_RESTORE_POSITION, NULL );
 }
 
+//================================================================================
+// The location is the one in our memory when the schedule starts
+//================================================================================
+void CInvestigateLocationSchedule::ResolveTaskValue( BotTaskInfo_t *info )
+{
+    CDataMemory *memory = GetMemory()->GetDataMemory( MEMORY_INVESTIGATE_LOCATION );
+
+    if ( !memory ) {
+        *info = BotTaskInfo_t( info->task, vec3_invalid );
+        Fail( "No location to investigate" );
+        return;
+    }
+
+    *info = BotTaskInfo_t( info->task, memory->GetVector() );
+}
+
 SET_SCHEDULE_INTERRUPTS( CInvestigateLocationSchedule )
 {
     ADD_INTERRUPT( BCOND_HELPLESS );
@@ -29,6 +29,26 @@ SET_SCHEDULE_INTERRUPTS( CReloadSchedule )
     ADD_INTERRUPT( BCOND_EMPTY_PRIMARY_AMMO );
 }
 
+//================================================================================
+// Inputs of GetDesire()
+//================================================================================
+SET_SCHEDULE_DESIRE_INPUTS( CReloadSchedule )
+{
+    ADD_DESIRE_CONDITION( BCOND_EMPTY_CLIP1_AMMO );
+    ADD_DESIRE_CONDITION( BCOND_LOW_CLIP1_AMMO );
+    ADD_DESIRE_CONDITION( BCOND_HELPLESS );
+    ADD_DESIRE_CONDITION( BCOND_DEJECTED );
+    ADD_DESIRE_STATE();
+    ADD_DESIRE_ENEMY();
+}
+
+//================================================================================
+//================================================================================
+int CReloadSchedule::GetDesireKey() const
+{
+    return GetMovementKey() | (GetEnemyKey() << 2);
+}
+
 //================================================================================
 //================================================================================
 float CReloadSchedule::GetDesire() const
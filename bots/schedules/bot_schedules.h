@@ -41,6 +41,7 @@ public:
 public:
 	virtual bool ItsImportant() { return true; }
     virtual float GetDesire() const;
+    virtual void ResolveTaskValue( BotTaskInfo_t *info );
 };
 
 //================================================================================
@@ -52,12 +53,16 @@ public:
 	DECLARE_CLASS_GAMEROOT( CHuntEnemySchedule, IBotSchedule );
     DECLARE_SCHEDULE( SCHEDULE_HUNT_ENEMY );
 
+    // The desire is not cached, CanHuntThreat() reads the distance
+    // to the enemy and there is no cheap value for it.
+
     CHuntEnemySchedule( IBot *bot ) : BaseClass( bot )
     {
     }
 
 public:
     virtual float GetDesire() const;
+    virtual int GetTasksKey() const;
 };
 
 //================================================================================
@@ -68,6 +73,7 @@ class CReloadSchedule : public IBotSchedule
 public:
 	DECLARE_CLASS_GAMEROOT( CReloadSchedule, IBotSchedule );
     DECLARE_SCHEDULE( SCHEDULE_RELOAD );
+    DECLARE_SCHEDULE_DESIRE_INPUTS();
 
     CReloadSchedule( IBot *bot ) : BaseClass( bot )
     {
@@ -85,6 +91,7 @@ class CCoverSchedule : public IBotSchedule
 public:
 	DECLARE_CLASS_GAMEROOT( CCoverSchedule, IBotSchedule );
     DECLARE_SCHEDULE( SCHEDULE_COVER );
+    DECLARE_SCHEDULE_DESIRE_INPUTS();
 
     CCoverSchedule( IBot *bot ) : BaseClass( bot )
     {
@@ -103,6 +110,7 @@ class CHideSchedule : public IBotSchedule
 public:
 	DECLARE_CLASS_GAMEROOT( CCoverSchedule, IBotSchedule );
     DECLARE_SCHEDULE( SCHEDULE_HIDE );
+    DECLARE_SCHEDULE_DESIRE_INPUTS();
 
     CHideSchedule( IBot *bot ) : BaseClass( bot )
     {
@@ -121,6 +129,7 @@ class CChangeWeaponSchedule : public IBotSchedule
 public:
 	DECLARE_CLASS_GAMEROOT( CChangeWeaponSchedule, IBotSchedule );
     DECLARE_SCHEDULE( SCHEDULE_CHANGE_WEAPON );
+    DECLARE_SCHEDULE_DESIRE_INPUTS();
 
     CChangeWeaponSchedule( IBot *bot ) : BaseClass( bot )
     {
@@ -133,6 +142,7 @@ public:
 
 public:
     virtual float GetDesire() const;
+    virtual void ResolveTaskValue( BotTaskInfo_t *info );
 
     virtual void TaskStart();
 	virtual void TaskRun();
@@ -146,6 +156,7 @@ class CHideAndHealSchedule : public IBotSchedule
 public:
 	DECLARE_CLASS_GAMEROOT( CHideAndHealSchedule, IBotSchedule );
     DECLARE_SCHEDULE( SCHEDULE_HIDE_AND_HEAL );
+    DECLARE_SCHEDULE_DESIRE_INPUTS();
 
     CHideAndHealSchedule( IBot *bot ) : BaseClass( bot )
     {
@@ -164,6 +175,7 @@ class CHideAndReloadSchedule : public IBotSchedule
 public:
 	DECLARE_CLASS_GAMEROOT( CHideAndReloadSchedule, IBotSchedule );
     DECLARE_SCHEDULE( SCHEDULE_HIDE_AND_RELOAD );
+    DECLARE_SCHEDULE_DESIRE_INPUTS();
 
     CHideAndReloadSchedule( IBot *bot ) : BaseClass( bot )
     {
@@ -185,6 +197,7 @@ class CHelpDejectedFriendSchedule : public IBotSchedule
 public:
 	DECLARE_CLASS_GAMEROOT( CHelpDejectedFriendSchedule, IBotSchedule );
     DECLARE_SCHEDULE( SCHEDULE_HELP_DEJECTED_FRIEND );
+    DECLARE_SCHEDULE_DESIRE_INPUTS();
 
     CHelpDejectedFriendSchedule( IBot *bot ) : BaseClass( bot )
     {
@@ -199,6 +212,7 @@ public:
 	virtual bool ShouldHelp();
 
     virtual float GetDesire() const;
+    virtual void ResolveTaskValue( BotTaskInfo_t *info );
     virtual void TaskRun();
 };
 #endif
@@ -259,6 +273,7 @@ public:
 
 public:
     virtual float GetDesire() const;
+    virtual int GetInterruptsKey() const;
 };
 
 #endif // BOT_SCHEDULES_H
\ No newline at end of file
@@ -8,6 +8,7 @@
 #include "bots\squad_manager.h"
 
 #include "bots\bot.h"
+#include "bots\bot_profiler.h"
 #include "bots\bot_squad.h"
 
 // memdbgon must be the last include file in a .cpp file!!!
@@ -24,6 +25,7 @@
 //================================================================================
 
 DECLARE_REPLICATED_COMMAND( sv_squad_replace_leader, "1", "" );
+DECLARE_REPLICATED_COMMAND( sv_squad_threat_duration, "10", "Seconds that a threat stays in the squad table without being reported again." );
 
 //================================================================================
 // Constructor
@@ -40,16 +42,30 @@ CSquad::CSquad()
     SetLeader( NULL );
 
     m_nController = NULL;
+    m_iThreatSequence = 0;
 
     // Nos agregamos a la lista
     TheSquads->AddSquad( this );
 }
 
+//================================================================================
+// The bots must not keep a pointer to the squad (see IBotMemory::ForgetSquadThreats)
+//================================================================================
+CSquad::~CSquad()
+{
+    FOR_EACH_VEC_BACK( m_nMembers, it )
+    {
+        RemoveMember( it );
+    }
+}
+
 //================================================================================
 // Pensamiento
 //================================================================================
 void CSquad::Think()
 {
+    UpdateThreats();
+
     if ( IsEmpty() )
         return;
 
@@ -273,6 +289,11 @@ void CSquad::RemoveMember( CPlayer *member )
 //================================================================================
 void CSquad::RemoveMember( int index ) 
 {
+    CPlayer *pMember = GetMember( index );
+
+    if ( pMember && pMember->GetBotController() && pMember->GetBotController()->GetMemory() )
+        pMember->GetBotController()->GetMemory()->ForgetSquadThreats();
+
     m_nMembers.Remove( index );
 }
 
@@ -308,7 +329,7 @@ bool CSquad::IsSomeoneLooking( CBaseEntity * pTarget, CPlayer *pIgnore )
         pMember->GetVectors( &vecForward, NULL, NULL );
 
         trace_t tr;
-        UTIL_TraceLine( vecOrigin, vecOrigin + vecForward * 3000.0f, MASK_SHOT, &traceFilter, &tr );
+        Bot_TraceLine( BOT_TRACE_SQUAD_LOOKING, vecOrigin, vecOrigin + vecForward * 3000.0f, MASK_SHOT, &traceFilter, &tr );
 
         if ( tr.m_pEnt == pTarget )
             return true;
@@ -427,6 +448,11 @@ void CSquad::ReportTakeDamage( CPlayer *member, const CTakeDamageInfo &info )
         pMember->OnMemberTakeDamage( member, info );
     });
 
+    // A human member has been attacked, the bots of the squad
+    // will read the attacker from the table
+    if ( !member->IsBot() && info.GetAttacker() )
+        ReportEnemy( member, info.GetAttacker() );
+
     if ( GetController() )
         GetController()->m_OnReportDamage.FireOutput( member, NULL );
 }
@@ -455,14 +481,21 @@ void CSquad::ReportDeath( CPlayer *member, const CTakeDamageInfo &info )
 //================================================================================
 void CSquad::ReportEnemy( CPlayer *member, CBaseEntity *pEnemy )
 {
-    FOR_EACH_MEMBER(
-    {
-        // No lo queremos comunicar a nosotros mismos...
-        if ( member == pMember )
-            continue;
+    // The members read the table when they update their memory
+    // and receive IBot::OnMemberReportEnemy (see CBotMemory::UpdateSquadMemory)
+    // Only the members that see the enemy keep it in their memory.
+    int index = FindThreat( pEnemy );
+
+    if ( index == -1 ) {
+        index = m_Threats.AddToTail();
+        m_Threats[index].entity = pEnemy;
+    }
 
-        pMember->OnMemberReportEnemy( member, pEnemy );
-    } );
+    SquadThreat_t &threat = m_Threats[index];
+    threat.position = pEnemy->WorldSpaceCenter();
+    threat.reporter = member;
+    threat.time = TheBotWorld->GetTime();
+    threat.sequence = ++m_iThreatSequence;
 
     if ( GetController() ) {
         variant_t value;
@@ -482,3 +515,33 @@ void CSquad::ReportEnemy( CPlayer *member, CBaseEntity *pEnemy )
         }
     }
 }
+
+//================================================================================
+//================================================================================
+int CSquad::FindThreat( CBaseEntity *pEnemy )
+{
+    FOR_EACH_VEC( m_Threats, it )
+    {
+        if ( m_Threats[it].entity.Get() == pEnemy )
+            return it;
+    }
+
+    return -1;
+}
+
+//================================================================================
+// Removes the threats that no longer exist or nobody has seen for a while
+//================================================================================
+void CSquad::UpdateThreats()
+{
+    float expireTime = TheBotWorld->GetTime() - sv_squad_threat_duration.GetFloat();
+
+    FOR_EACH_VEC_BACK( m_Threats, it )
+    {
+        CBaseEntity *pEnemy = m_Threats[it].entity.Get();
+
+        if ( pEnemy == NULL || pEnemy->IsMarkedForDeletion() || !pEnemy->IsAlive() || m_Threats[it].time < expireTime ) {
+            m_Threats.FastRemove( it );
+        }
+    }
+}
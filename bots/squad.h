@@ -23,6 +23,22 @@ struct SquadOptions_t
 
 };
 
+//================================================================================
+// Enemy seen by a member of the squad
+//================================================================================
+struct SquadThreat_t
+{
+    EHANDLE entity;
+
+    // Position where it was seen, who saw it and when
+    Vector position;
+    EHANDLE reporter;
+    float time;
+
+    // Sequence of the squad in the last update
+    int sequence;
+};
+
 //================================================================================
 // Define un escuadron, el enlace para comunicarse entre miembros
 //================================================================================
@@ -30,6 +46,7 @@ class CSquad
 {
 public:
     CSquad();
+    ~CSquad();
 
     virtual void Think();
 
@@ -85,6 +102,15 @@ public:
     virtual void ReportDeath( CPlayer *pMember, const CTakeDamageInfo &info );
     virtual void ReportEnemy( CPlayer *pMember, CBaseEntity *pEnemy );
 
+public:
+    virtual int GetThreatCount() { return m_Threats.Count(); }
+    virtual const SquadThreat_t &GetThreat( int index ) { return m_Threats[index]; }
+    virtual int GetThreatSequence() { return m_iThreatSequence; }
+
+protected:
+    virtual int FindThreat( CBaseEntity *pEnemy );
+    virtual void UpdateThreats();
+
 public:
     MembersVector m_nMembers;
 
@@ -99,7 +125,13 @@ protected:
     BotStrategie m_iStrategie;
     int m_iSkill;
     bool m_bFollowLeader;
-    
+
+    // Enemies seen by the members, shared by the whole squad.
+    // Each report increases the sequence, so the members only
+    // need to read the threats updated since their last read.
+    CUtlVector<SquadThreat_t> m_Threats;
+    int m_iThreatSequence;
+
 };
 
 #endif // SQUAD_H
\ No newline at end of file
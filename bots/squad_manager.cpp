@@ -26,7 +26,7 @@ CSquadManager::CSquadManager() : CAutoGameSystemPerFrame("SquadManager")
 void CSquadManager::LevelShutdownPostEntity() 
 {
     // Eliminamos los escuadrones
-    m_nSquads.RemoveAll();
+    m_nSquads.PurgeAndDeleteElements();
 }
 
 //================================================================================